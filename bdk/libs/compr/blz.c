@@ -32,6 +32,54 @@ const blz_footer *blz_get_footer(const unsigned char *compData, unsigned int com
 	return srcFooter;
 }
 
+#if defined(__ARM_FEATURE_UNALIGNED) || !defined(__arm__)
+#define BLZ_LOAD(type, src)       ({ type _v; memcpy(&_v, (src), sizeof(type)); _v; })
+#define BLZ_STORE(type, dst, val) ({ type _v = (val); memcpy((dst), &_v, sizeof(type)); })
+#endif
+
+/*
+ * Segments are 3 to 18 bytes and copied from above, so with an upwards copy every read is
+ * ahead of the writes, even when they overlap. That makes it a memmove and the chunks can be
+ * of any width, as long as each is loaded before it is stored.
+ */
+static void _blz_copy(unsigned char *dst, const unsigned char *src, u32 size)
+{
+#if defined(__ARM_FEATURE_UNALIGNED) || !defined(__arm__)
+	// Unaligned accesses are fine. Head, middle and tail chunks may overlap each other.
+	if (size >= 8)
+	{
+		u32 mid_ofs = size >= 16 ? 8 : 0;
+		u64 head = BLZ_LOAD(u64, src);
+		u64 mid = BLZ_LOAD(u64, src + mid_ofs);
+		u64 tail = BLZ_LOAD(u64, src + size - 8);
+		BLZ_STORE(u64, dst, head);
+		BLZ_STORE(u64, dst + mid_ofs, mid);
+		BLZ_STORE(u64, dst + size - 8, tail);
+		return;
+	}
+	if (size >= 4)
+	{
+		u32 head = BLZ_LOAD(u32, src);
+		u32 tail = BLZ_LOAD(u32, src + size - 4);
+		BLZ_STORE(u32, dst, head);
+		BLZ_STORE(u32, dst + size - 4, tail);
+		return;
+	}
+#else
+	// No unaligned accesses on ARMv4. Both sides line up only if the distance is a multiple of 4.
+	if (!((u32)(src - dst) & 3) && size >= 8)
+	{
+		for (; (u32)dst & 3; size--)
+			*dst++ = *src++;
+		for (; size >= 4; size -= 4, dst += 4, src += 4)
+			*(u32 *)dst = *(const u32 *)src;
+	}
+#endif
+
+	while (size--)
+		*dst++ = *src++;
+}
+
 // From https://github.com/SciresM/hactool/blob/master/kip.c which is exactly how kernel does it, thanks SciresM!
 int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer)
 {
@@ -45,6 +93,9 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 
 	while (out_ofs)
 	{
+		if (cmp_ofs < 1)
+			return 0; // Out of bounds.
+
 		unsigned char control = cmp_start[--cmp_ofs];
 		for (unsigned int i=0; i<8; i++)
 		{
@@ -62,8 +113,7 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 
 				out_ofs -= seg_size;
 
-				for (unsigned int j = 0; j < seg_size; j++)
-					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+				_blz_copy(&cmp_start[out_ofs], &cmp_start[out_ofs + seg_ofs], seg_size);
 			}
 			else
 			{
@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "lz4f.h"
+#include <mem/heap.h>
+
+#define LZ4F_MAGIC        0x184D2204
+#define LZ4F_FLG_VERSION  0x40
+#define LZ4F_FLG_VER_MASK 0xC0
+#define LZ4F_FLG_B_INDEP  BIT(5)
+#define LZ4F_FLG_B_CSUM   BIT(4)
+#define LZ4F_FLG_C_SIZE   BIT(3)
+#define LZ4F_FLG_C_CSUM   BIT(2)
+#define LZ4F_FLG_RSVD     BIT(1)
+#define LZ4F_FLG_DICT_ID  BIT(0)
+#define LZ4F_BLK_RAW      BIT(31)
+#define LZ4F_HIST_SIZE    SZ_64K
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME32_4 0x27D4EB2FU
+#define XXH_PRIME32_5 0x165667B1U
+
+static inline u32 _lz4f_get32(const u8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static inline void _lz4f_put32(u8 *p, u32 val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+	p[3] = val >> 24;
+}
+
+static inline u32 _xxh_rotl(u32 val, u32 bits)
+{
+	return (val << bits) | (val >> (32 - bits));
+}
+
+static inline u32 _xxh_round(u32 acc, u32 val)
+{
+	return _xxh_rotl(acc + val * XXH_PRIME32_2, 13) * XXH_PRIME32_1;
+}
+
+static void _xxh32_init(lz4f_xxh32_t *xxh)
+{
+	memset(xxh, 0, sizeof(lz4f_xxh32_t));
+	xxh->v[0] = XXH_PRIME32_1 + XXH_PRIME32_2;
+	xxh->v[1] = XXH_PRIME32_2;
+	xxh->v[2] = 0;
+	xxh->v[3] = -XXH_PRIME32_1;
+}
+
+static void _xxh32_stripes(lz4f_xxh32_t *xxh, const u8 *p, u32 stripes)
+{
+	u32 v0 = xxh->v[0], v1 = xxh->v[1], v2 = xxh->v[2], v3 = xxh->v[3];
+
+	// Word loads need alignment on the BPMP.
+	if (!((uptr)p & 3))
+	{
+		const u32 *w = (const u32 *)p;
+		for (; stripes; stripes--, w += 4)
+		{
+			v0 = _xxh_round(v0, w[0]);
+			v1 = _xxh_round(v1, w[1]);
+			v2 = _xxh_round(v2, w[2]);
+			v3 = _xxh_round(v3, w[3]);
+		}
+	}
+	else
+	{
+		for (; stripes; stripes--, p += 16)
+		{
+			v0 = _xxh_round(v0, _lz4f_get32(p));
+			v1 = _xxh_round(v1, _lz4f_get32(p + 4));
+			v2 = _xxh_round(v2, _lz4f_get32(p + 8));
+			v3 = _xxh_round(v3, _lz4f_get32(p + 12));
+		}
+	}
+
+	xxh->v[0] = v0;
+	xxh->v[1] = v1;
+	xxh->v[2] = v2;
+	xxh->v[3] = v3;
+}
+
+static void _xxh32_update(lz4f_xxh32_t *xxh, const u8 *p, u32 size)
+{
+	u8 *pending = (u8 *)xxh->buf;
+
+	xxh->total += size;
+	if (xxh->total >= 16)
+		xxh->large = true;
+
+	if (xxh->buf_len)
+	{
+		u32 fill = MIN(16 - xxh->buf_len, size);
+		memcpy(pending + xxh->buf_len, p, fill);
+		xxh->buf_len += fill;
+		p += fill;
+		size -= fill;
+
+		if (xxh->buf_len < 16)
+			return;
+
+		_xxh32_stripes(xxh, pending, 1);
+		xxh->buf_len = 0;
+	}
+
+	_xxh32_stripes(xxh, p, size / 16);
+	memcpy(pending, p + (size & ~15), size & 15);
+	xxh->buf_len = size & 15;
+}
+
+static u32 _xxh32_digest(const lz4f_xxh32_t *xxh)
+{
+	const u8 *p = (const u8 *)xxh->buf;
+	u32 h;
+
+	if (xxh->large)
+		h = _xxh_rotl(xxh->v[0], 1) + _xxh_rotl(xxh->v[1], 7) + _xxh_rotl(xxh->v[2], 12) + _xxh_rotl(xxh->v[3], 18);
+	else
+		h = xxh->v[2] + XXH_PRIME32_5;
+	h += xxh->total;
+
+	u32 left = xxh->buf_len;
+	for (; left >= 4; left -= 4, p += 4)
+		h = _xxh_rotl(h + _lz4f_get32(p) * XXH_PRIME32_3, 17) * XXH_PRIME32_4;
+	for (; left; left--, p++)
+		h = _xxh_rotl(h + *p * XXH_PRIME32_5, 11) * XXH_PRIME32_1;
+
+	h ^= h >> 15;
+	h *= XXH_PRIME32_2;
+	h ^= h >> 13;
+	h *= XXH_PRIME32_3;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static u32 _xxh32(const u8 *p, u32 size)
+{
+	lz4f_xxh32_t xxh;
+
+	_xxh32_init(&xxh);
+	_xxh32_update(&xxh, p, size);
+
+	return _xxh32_digest(&xxh);
+}
+
+static void _lz4f_free(lz4f_t *lz)
+{
+	LZ4_freeStream(lz->stream);
+	LZ4_freeStreamDecode(lz->stream_dec);
+	free(lz->buf);
+	free(lz->cmp);
+
+	lz->stream = NULL;
+	lz->stream_dec = NULL;
+	lz->buf = NULL;
+	lz->cmp = NULL;
+}
+
+// Block sizes are 64 KiB, 256 KiB, 1 MiB and 4 MiB for ids 4 to 7.
+static u32 _lz4f_blk_size(u32 blk_id)
+{
+	return 1 << (8 + 2 * blk_id);
+}
+
+/*
+ * The buffer keeps 64 KiB of history in front of the current block. Blocks are stored one
+ * after another, and only when the next one does not fit, the last 64 KiB are moved to the
+ * start. The spare 64 KiB halve these moves for small blocks.
+ */
+static int _lz4f_alloc(lz4f_t *lz, u32 blk_id, u32 cmp_size)
+{
+	lz->blk_size = _lz4f_blk_size(blk_id);
+	lz->buf_size = LZ4F_HIST_SIZE * 2 + lz->blk_size;
+	lz->buf = malloc(lz->buf_size);
+	lz->cmp = malloc(cmp_size);
+
+	if (!lz->buf || !lz->cmp)
+	{
+		_lz4f_free(lz);
+		return FR_NOT_ENOUGH_CORE;
+	}
+
+	return FR_OK;
+}
+
+static int _lz4f_write_all(FIL *fp, const void *buf, u32 size)
+{
+	UINT bw;
+
+	int res = f_write(fp, buf, size, &bw);
+	if (!res && bw != size)
+		res = FR_DENIED; // Disk full.
+
+	return res;
+}
+
+static int _lz4f_read_all(FIL *fp, void *buf, u32 size)
+{
+	UINT br;
+
+	int res = f_read(fp, buf, size, &br);
+	if (!res && br != size)
+		res = FR_INT_ERR; // Truncated frame.
+
+	return res;
+}
+
+int lz4f_write_open(lz4f_t *lz, FIL *fp, u32 blk_id, bool checksum)
+{
+	u8 hdr[7];
+
+	if (blk_id < LZ4F_BLOCK_64K || blk_id > LZ4F_BLOCK_4M)
+		return FR_INVALID_PARAMETER;
+
+	memset(lz, 0, sizeof(lz4f_t));
+	lz->fp = fp;
+	lz->flg = LZ4F_FLG_VERSION | (checksum ? LZ4F_FLG_C_CSUM : 0);
+
+	// Room for the block size in front, so a block is written at once.
+	int res = _lz4f_alloc(lz, blk_id, 4 + LZ4_COMPRESSBOUND(_lz4f_blk_size(blk_id)));
+	if (res)
+		return res;
+
+	lz->stream = LZ4_createStream();
+	if (!lz->stream)
+	{
+		_lz4f_free(lz);
+		return FR_NOT_ENOUGH_CORE;
+	}
+
+	_xxh32_init(&lz->xxh);
+
+	_lz4f_put32(hdr, LZ4F_MAGIC);
+	hdr[4] = lz->flg;
+	hdr[5] = blk_id << 4;
+	hdr[6] = _xxh32(hdr + 4, 2) >> 8;
+
+	res = _lz4f_write_all(fp, hdr, sizeof(hdr));
+	if (res)
+		_lz4f_free(lz);
+
+	return res;
+}
+
+static int _lz4f_write_block(lz4f_t *lz)
+{
+	int res;
+	u8 *src = lz->buf + lz->pos;
+
+	if (lz->flg & LZ4F_FLG_C_CSUM)
+		_xxh32_update(&lz->xxh, src, lz->len);
+
+	// With a full bound the stream stays valid, so blocks that do not shrink are stored after.
+	int size = LZ4_compress_fast_continue(lz->stream, (const char *)src, (char *)lz->cmp + 4, lz->len,
+		LZ4_COMPRESSBOUND(lz->blk_size), 1);
+	if (size > 0 && (u32)size < lz->len)
+	{
+		_lz4f_put32(lz->cmp, size);
+		res = _lz4f_write_all(lz->fp, lz->cmp, size + 4);
+	}
+	else
+	{
+		_lz4f_put32(lz->cmp, lz->len | LZ4F_BLK_RAW);
+		res = _lz4f_write_all(lz->fp, lz->cmp, 4);
+		if (!res)
+			res = _lz4f_write_all(lz->fp, src, lz->len);
+	}
+
+	lz->pos += lz->len;
+	lz->len = 0;
+	if (lz->pos + lz->blk_size > lz->buf_size)
+		lz->pos = LZ4_saveDict(lz->stream, (char *)lz->buf, LZ4F_HIST_SIZE);
+
+	return res;
+}
+
+int lz4f_write(lz4f_t *lz, const void *buf, u32 size)
+{
+	const u8 *src = buf;
+
+	while (size)
+	{
+		u32 n = MIN(size, lz->blk_size - lz->len);
+		memcpy(lz->buf + lz->pos + lz->len, src, n);
+		lz->len += n;
+		src += n;
+		size -= n;
+
+		if (lz->len == lz->blk_size)
+		{
+			int res = _lz4f_write_block(lz);
+			if (res)
+				return res;
+		}
+	}
+
+	return FR_OK;
+}
+
+int lz4f_write_close(lz4f_t *lz)
+{
+	u8 end[8];
+	int res = FR_OK;
+
+	if (lz->len)
+		res = _lz4f_write_block(lz);
+
+	if (!res)
+	{
+		_lz4f_put32(end, 0);
+		_lz4f_put32(end + 4, _xxh32_digest(&lz->xxh));
+		res = _lz4f_write_all(lz->fp, end, (lz->flg & LZ4F_FLG_C_CSUM) ? 8 : 4);
+	}
+
+	_lz4f_free(lz);
+
+	return res;
+}
+
+int lz4f_read_open(lz4f_t *lz, FIL *fp)
+{
+	u8 hdr[4 + 2 + 8 + 1];
+
+	memset(lz, 0, sizeof(lz4f_t));
+	lz->fp = fp;
+
+	int res = _lz4f_read_all(fp, hdr, 6);
+	if (res)
+		return res;
+
+	u8 flg = hdr[4];
+	u32 blk_id = (hdr[5] >> 4) & 7;
+	if (_lz4f_get32(hdr) != LZ4F_MAGIC || (flg & LZ4F_FLG_VER_MASK) != LZ4F_FLG_VERSION || (flg & LZ4F_FLG_RSVD) ||
+		(hdr[5] & 0x8F) || blk_id < LZ4F_BLOCK_64K)
+		return FR_INT_ERR;
+	if (flg & LZ4F_FLG_DICT_ID)
+		return FR_INVALID_PARAMETER;
+
+	// Content size is not needed, it is only checked with the header.
+	u32 desc_size = 2 + ((flg & LZ4F_FLG_C_SIZE) ? 8 : 0);
+	res = _lz4f_read_all(fp, hdr + 6, desc_size - 2 + 1);
+	if (res)
+		return res;
+	if (hdr[4 + desc_size] != ((_xxh32(hdr + 4, desc_size) >> 8) & 0xFF))
+		return FR_INT_ERR;
+
+	lz->flg = flg;
+	res = _lz4f_alloc(lz, blk_id, _lz4f_blk_size(blk_id));
+	if (res)
+		return res;
+
+	lz->stream_dec = LZ4_createStreamDecode();
+	if (!lz->stream_dec)
+	{
+		_lz4f_free(lz);
+		return FR_NOT_ENOUGH_CORE;
+	}
+	LZ4_setStreamDecode(lz->stream_dec, NULL, 0);
+
+	_xxh32_init(&lz->xxh);
+
+	return FR_OK;
+}
+
+static int _lz4f_read_block(lz4f_t *lz)
+{
+	u8 word[4];
+
+	// Decoded data up to the new block must stay contiguous, for the decoder and raw blocks.
+	u32 pos = lz->pos + lz->len;
+	if (pos + lz->blk_size > lz->buf_size)
+	{
+		u32 hist = MIN(pos, LZ4F_HIST_SIZE);
+		memmove(lz->buf, lz->buf + pos - hist, hist);
+		LZ4_setStreamDecode(lz->stream_dec, (const char *)lz->buf, hist);
+		pos = hist;
+	}
+	lz->pos = pos;
+	lz->len = 0;
+	lz->off = 0;
+
+	int res = _lz4f_read_all(lz->fp, word, 4);
+	if (res)
+		return res;
+
+	u32 hdr = _lz4f_get32(word);
+	u32 size = hdr & ~LZ4F_BLK_RAW;
+	if (!hdr)
+	{
+		lz->eof = true;
+		if (!(lz->flg & LZ4F_FLG_C_CSUM))
+			return FR_OK;
+
+		res = _lz4f_read_all(lz->fp, word, 4);
+		if (!res && _lz4f_get32(word) != _xxh32_digest(&lz->xxh))
+			res = FR_INT_ERR;
+
+		return res;
+	}
+	if (size > lz->blk_size)
+		return FR_INT_ERR;
+
+	// Raw blocks are read in place.
+	u8 *data = (hdr & LZ4F_BLK_RAW) ? lz->buf + pos : lz->cmp;
+	res = _lz4f_read_all(lz->fp, data, size);
+	if (!res && (lz->flg & LZ4F_FLG_B_CSUM))
+	{
+		res = _lz4f_read_all(lz->fp, word, 4);
+		if (!res && _lz4f_get32(word) != _xxh32(data, size))
+			res = FR_INT_ERR;
+	}
+	if (res)
+		return res;
+
+	if (hdr & LZ4F_BLK_RAW)
+	{
+		// The decoder did not see this block, so point it to the history again.
+		u32 hist = MIN(pos + size, LZ4F_HIST_SIZE);
+		LZ4_setStreamDecode(lz->stream_dec, (const char *)lz->buf + pos + size - hist, hist);
+		lz->len = size;
+	}
+	else
+	{
+		if (lz->flg & LZ4F_FLG_B_INDEP)
+			LZ4_setStreamDecode(lz->stream_dec, NULL, 0);
+
+		int out = LZ4_decompress_safe_continue(lz->stream_dec, (const char *)lz->cmp, (char *)lz->buf + pos,
+			size, lz->blk_size);
+		if (out < 0)
+			return FR_INT_ERR;
+		lz->len = out;
+	}
+
+	if (lz->flg & LZ4F_FLG_C_CSUM)
+		_xxh32_update(&lz->xxh, lz->buf + pos, lz->len);
+
+	return FR_OK;
+}
+
+int lz4f_read(lz4f_t *lz, void *buf, u32 size, u32 *br)
+{
+	u8 *dst = buf;
+
+	*br = 0;
+	while (size)
+	{
+		if (lz->off == lz->len)
+		{
+			if (lz->eof)
+				break;
+
+			int res = _lz4f_read_block(lz);
+			if (res)
+				return res;
+			continue;
+		}
+
+		u32 n = MIN(size, lz->len - lz->off);
+		memcpy(dst, lz->buf + lz->pos + lz->off, n);
+		lz->off += n;
+		dst += n;
+		size -= n;
+		*br += n;
+	}
+
+	return FR_OK;
+}
+
+void lz4f_read_close(lz4f_t *lz)
+{
+	_lz4f_free(lz);
+}
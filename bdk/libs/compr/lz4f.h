@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LZ4F_H_
+#define _LZ4F_H_
+
+#include <libs/compr/lz4.h>
+#include <libs/fatfs/ff.h>
+#include <utils/types.h>
+
+/*
+ * Streaming LZ4 frames over FatFs files.
+ * Files are standard LZ4 frames, so a PC decompresses them with the lz4 tool. Blocks are
+ * linked and compressed with LZ4_compress_fast_continue() and LZ4_decompress_safe_continue(),
+ * so memory use is about two blocks plus 144 KiB, whatever the file size. The FIL is opened
+ * and closed by the caller, and the frame starts at its current position.
+ *
+ * Functions return FatFs results: FR_NOT_ENOUGH_CORE when out of memory, FR_INVALID_PARAMETER
+ * for frame options the reader does not support and FR_INT_ERR for corrupt data.
+ */
+
+// Block sizes of the frame format.
+#define LZ4F_BLOCK_64K  4
+#define LZ4F_BLOCK_256K 5
+#define LZ4F_BLOCK_1M   6
+#define LZ4F_BLOCK_4M   7
+
+typedef struct _lz4f_xxh32_t
+{
+	u32 v[4];
+	u32 total;
+	u32 buf[4];
+	u32 buf_len;
+	bool large;
+} lz4f_xxh32_t;
+
+typedef struct _lz4f_t
+{
+	FIL *fp;
+	LZ4_stream_t *stream;
+	LZ4_streamDecode_t *stream_dec;
+	u8 *buf;      // History and the current block.
+	u8 *cmp;      // Compressed block with its size.
+	u32 buf_size;
+	u32 blk_size;
+	u32 pos;      // Start of the current block in buf.
+	u32 len;      // Bytes in the current block.
+	u32 off;      // Bytes of the current block already read.
+	u8 flg;
+	bool eof;
+	lz4f_xxh32_t xxh;
+} lz4f_t;
+
+// Starts a frame with blocks of blk_id size. checksum adds a content checksum.
+int lz4f_write_open(lz4f_t *lz, FIL *fp, u32 blk_id, bool checksum);
+int lz4f_write(lz4f_t *lz, const void *buf, u32 size);
+// Writes the last block and the frame end, and frees the buffers. Also frees them on failure.
+int lz4f_write_close(lz4f_t *lz);
+
+int lz4f_read_open(lz4f_t *lz, FIL *fp);
+// Reads up to size bytes. br is less than size only at the end of the frame.
+int lz4f_read(lz4f_t *lz, void *buf, u32 size, u32 *br);
+void lz4f_read_close(lz4f_t *lz);
+
+#endif
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lzrev.h"
+
+/*
+ * Both decoders mirror the forward ones: *--in reads the next compressed byte and the output
+ * grows downwards, so a match at offset d copies from d bytes above the write position.
+ * Input is only read before the writes it produces. Nothing is bounds checked.
+ */
+
+// Same encoding as _LZ_ReadVarSize in lz.c.
+static u32 _lz_read_varsize_rev(const u8 **in)
+{
+	u32 val = 0;
+	u8 b;
+
+	do
+	{
+		b = *--(*in);
+		val = (val << 7) | (b & 0x7F);
+	} while (b & 0x80);
+
+	return val;
+}
+
+u32 lz_uncompress_rev(const u8 *in, u32 in_size, u8 *out_end)
+{
+	if (!in_size)
+		return 0;
+
+	const u8 *in_pos = in + in_size;
+	u8 *out = out_end;
+
+	u8 marker = *--in_pos;
+	while (in_pos > in)
+	{
+		u8 symbol = *--in_pos;
+		if (symbol != marker)
+			*--out = symbol;
+		else if (!in_pos[-1])
+		{
+			// Single occurrence of the marker byte.
+			in_pos--;
+			*--out = marker;
+		}
+		else
+		{
+			u32 length = _lz_read_varsize_rev(&in_pos);
+			u32 offset = _lz_read_varsize_rev(&in_pos);
+
+			while (length--)
+			{
+				out--;
+				*out = out[offset];
+			}
+		}
+	}
+
+	return out_end - out;
+}
+
+static u32 _lz4_read_len_rev(const u8 **in, u32 len)
+{
+	if (len == 15)
+	{
+		u8 b;
+		do
+		{
+			b = *--(*in);
+			len += b;
+		} while (b == 255);
+	}
+
+	return len;
+}
+
+u32 lz4_uncompress_rev(const u8 *in, u32 in_size, u8 *out_end)
+{
+	const u8 *in_pos = in + in_size;
+	u8 *out = out_end;
+
+	while (in_pos > in)
+	{
+		u8 token = *--in_pos;
+
+		// Literals.
+		u32 len = _lz4_read_len_rev(&in_pos, token >> 4);
+		while (len--)
+			*--out = *--in_pos;
+
+		// Last sequence has no match.
+		if (in_pos == in)
+			break;
+
+		// Match. Offset is little endian.
+		u32 offset = *--in_pos;
+		offset |= *--in_pos << 8;
+
+		len = _lz4_read_len_rev(&in_pos, token & 0xF) + 4;
+		while (len--)
+		{
+			out--;
+			*out = out[offset];
+		}
+	}
+
+	return out_end - out;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LZREV_H_
+#define _LZREV_H_
+
+#include <utils/types.h>
+
+/*
+ * Decoders for data packed back to front (lz77 -i): the data is reversed, compressed with
+ * the LZ or LZ4 block format and the compressed stream reversed again.
+ * Input is read from its end and output written downwards, ending right below out_end.
+ * So the input may sit below the output and overlap it, as long as every write lands above
+ * the input not read yet. lz77 -i checks that and reports the distance it needs.
+ */
+
+// Returns the uncompressed size.
+u32 lz_uncompress_rev(const u8 *in, u32 in_size, u8 *out_end);
+// Returns the uncompressed size.
+u32 lz4_uncompress_rev(const u8 *in, u32 in_size, u8 *out_end);
+
+#endif
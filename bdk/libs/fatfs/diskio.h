@@ -31,6 +31,13 @@ typedef enum {
 	DRIVE_EMU  = 4
 } DDRIVE;
 
+/* Sector cache statistics */
+typedef struct _disk_cache_stats_t {
+	u32 hits;
+	u32 misses;
+	u32 writebacks;
+} disk_cache_stats_t;
+
 
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
@@ -43,6 +50,9 @@ DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 DRESULT disk_set_info (BYTE pdrv, BYTE cmd, void *buff);
 
+void disk_sd_cache_reset (void);	/* Write back and drop all cached SD sectors */
+void disk_sd_cache_stats (disk_cache_stats_t *stats);
+
 
 /* Disk Status Bits (DSTATUS) */
 
@@ -286,6 +286,28 @@ typedef struct {
 } FILESEM;
 #endif
 
+/* Directory name index */
+#if FF_DIR_INDEX != 0
+#if FF_USE_LFN != 3
+#error FF_DIR_INDEX needs FF_USE_LFN 3
+#endif
+typedef struct {
+	DWORD	ofs;	/* Offset of the entry block + 1 (0:empty slot) */
+	WORD	key;	/* Name hash */
+} DIXENT;
+
+typedef struct {
+	FATFS*	fs;		/* Volume of the directory (NULL:blank entry) */
+	WORD	id;		/* Volume mount ID */
+	BYTE	built;	/* Table holds all names of the directory */
+	DWORD	sclust;	/* Directory start cluster (0:root) */
+	DWORD	stamp;	/* Last use */
+	UINT	cnt;	/* Number of keys in the table */
+	UINT	size;	/* Size of the table (power of 2) */
+	DIXENT*	tbl;	/* Open addressing hash table */
+} DIRIDX;
+#endif
+
 
 /* SBCS up-case tables (\x80-\xFF) */
 #define TBL_CT437  {0x80,0x9A,0x45,0x41,0x8E,0x41,0x8F,0x80,0x45,0x45,0x45,0x49,0x49,0x49,0x8E,0x8F, \
@@ -467,6 +489,11 @@ static BYTE CurrVol;				/* Current drive */
 static FILESEM Files[FF_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if FF_DIR_INDEX != 0
+static DIRIDX DirIdx[FF_DIR_INDEX];	/* Name index of recently used directories */
+static DWORD DixStamp;
+#endif
+
 #if FF_STR_VOLUME_ID
 #ifdef FF_VOLUME_STRS
 static const char* const VolumeStr[FF_VOLUMES] = {FF_VOLUME_STRS};	/* Pre-defined volume ID */
@@ -1318,38 +1345,64 @@ static FRESULT put_fat (	/* FR_OK(0):succeeded, !=0:error */
 /* Find a contiguous free cluster block */
 /*--------------------------------------*/
 
+/* The bitmap is scanned a word at a time. win[] is the first member of FATFS, so it is word aligned */
+typedef DWORD __attribute__((may_alias)) BMWORD;
+#define BM_CTZ(w)	__builtin_ctz(w)
+
 static DWORD find_bitmap (	/* 0:Not found, 2..:Cluster block found, 0xFFFFFFFF:Disk error */
 	FATFS* fs,	/* Filesystem object */
 	DWORD clst,	/* Cluster number to scan from */
 	DWORD ncl	/* Number of contiguous clusters to find (1..) */
 )
 {
-	BYTE bm, bv;
-	UINT i;
-	DWORD val, scl, ctr;
+	UINT t, nb;
+	DWORD w, m, val, lim, end, ctr;
 
 
+	/* Start of the run found by the last scan, if the scan would find it again */
+	if (fs->bm_hint_ncl >= ncl) {
+		if (clst == fs->bm_hint_scl) return clst;
+		if (clst + 1 == fs->bm_hint_scl && clst >= 2) {	/* Only when the scan skips clst as in use */
+			val = clst - 2;
+			if (move_window(fs, fs->bitbase + val / 8 / SS(fs)) != FR_OK) return 0xFFFFFFFF;
+			if (fs->win[val / 8 % SS(fs)] & (1 << (val % 8))) return fs->bm_hint_scl;
+		}
+	}
+
 	clst -= 2;	/* The first bit in the bitmap corresponds to cluster #2 */
 	if (clst >= fs->n_fatent - 2) clst = 0;
-	scl = val = clst; ctr = 0;
+	val = clst; end = fs->n_fatent - 2; ctr = 0;	/* Scan clst..end, then 0..clst */
 	for (;;) {
+		if (val >= end) {	/* End of this pass */
+			if (end == clst) return 0;	/* All cluster scanned? */
+			val = 0; end = clst; ctr = 0;	/* Wrap around. A run does not continue over it */
+			if (val >= end) return 0;
+		}
 		if (move_window(fs, fs->bitbase + val / 8 / SS(fs)) != FR_OK) return 0xFFFFFFFF;
-		i = val / 8 % SS(fs); bm = 1 << (val % 8);
+		lim = (val / 8 / SS(fs) + 1) * SS(fs) * 8;	/* First bit of the next sector */
+		if (lim > end) lim = end;
 		do {
-			do {
-				bv = fs->win[i] & bm; bm <<= 1;		/* Get bit value */
-				if (++val >= fs->n_fatent - 2) {	/* Next cluster (with wrap-around) */
-					val = 0; bm = 0; i = SS(fs);
-				}
-				if (bv == 0) {	/* Is it a free cluster? */
-					if (++ctr == ncl) return scl + 2;	/* Check if run length is sufficient for required */
-				} else {
-					scl = val; ctr = 0;		/* Encountered a cluster in-use, restart to scan */
+			w = ((BMWORD*)fs->win)[val / 32 % (SS(fs) / 4)] >> (val % 32);
+			nb = 32 - val % 32;
+			if (nb > lim - val) nb = lim - val;
+			do {	/* Split the word into in-use and free runs */
+				m = (nb < 32) ? ((DWORD)1 << nb) - 1 : 0xFFFFFFFF;
+				if (w & 1) {	/* In use: skip to the next free cluster */
+					t = (~w & m) ? BM_CTZ(~w & m) : nb;
+					ctr = 0;
+				} else {		/* Free: extend the run to the next cluster in use */
+					t = (w & m) ? BM_CTZ(w & m) : nb;
+					if (ctr + t >= ncl) {	/* Is the run long enough? */
+						fs->bm_hint_scl = val - ctr + 2;	/* Remember the free run seen so far */
+						fs->bm_hint_ncl = ctr + t;
+						return val - ctr + 2;
+					}
+					ctr += t;
 				}
-				if (val == clst) return 0;	/* All cluster scanned? */
-			} while (bm != 0);
-			bm = 1;
-		} while (++i < SS(fs));
+				val += t; nb -= t;
+				w = (t < 32) ? w >> t : 0;
+			} while (nb);
+		} while (val < lim);
 	}
 }
 
@@ -1368,7 +1421,16 @@ static FRESULT change_bitmap (
 	BYTE bm;
 	UINT i;
 	DWORD sect;
+	BMWORD *wp;
+
 
+	if (bv && fs->bm_hint_ncl && clst < fs->bm_hint_scl + fs->bm_hint_ncl && clst + ncl > fs->bm_hint_scl) {	/* Allocating from the free run hint? */
+		if (clst == fs->bm_hint_scl && ncl < fs->bm_hint_ncl) {
+			fs->bm_hint_scl += ncl; fs->bm_hint_ncl -= ncl;	/* Rest of the run stays free */
+		} else {
+			fs->bm_hint_ncl = 0;
+		}
+	}
 
 	clst -= 2;	/* The first bit corresponds to cluster #2 */
 	sect = fs->bitbase + clst / 8 / SS(fs);	/* Sector address */
@@ -1377,6 +1439,16 @@ static FRESULT change_bitmap (
 	for (;;) {
 		if (move_window(fs, sect++) != FR_OK) return FR_DISK_ERR;
 		do {
+			if (bm == 1 && i % 4 == 0) {	/* Flip whole words */
+				for (; ncl >= 32 && i < SS(fs); i += 4, ncl -= 32) {
+					wp = (BMWORD*)(fs->win + i);
+					if (*wp != (bv ? 0 : 0xFFFFFFFF)) return FR_INT_ERR;	/* Are the bits expected value? */
+					*wp = ~*wp;
+					fs->wflag = 1;
+				}
+				if (ncl == 0) return FR_OK;
+				if (i == SS(fs)) break;
+			}
 			do {
 				if (bv == (int)((fs->win[i] & bm) != 0)) return FR_INT_ERR;	/* Is the bit expected value? */
 				fs->win[i] ^= bm;	/* Flip the bit */
@@ -2439,19 +2511,18 @@ static FRESULT dir_read (
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
 
-static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
-	DIR* dp					/* Pointer to the directory object with the file name */
+static FRESULT dir_match (	/* FR_OK(0):succeeded, !=0:error */
+	DIR* dp,				/* Pointer to the directory object with the file name */
+	int one					/* Compare only the object at the current position */
 )
 {
-	FRESULT res;
+	FRESULT res = FR_OK;
 	FATFS *fs = dp->obj.fs;
 	BYTE c;
 #if FF_USE_LFN
 	BYTE a, ord, sum;
 #endif
 
-	res = dir_sdi(dp, 0);			/* Rewind directory object */
-	if (res != FR_OK) return res;
 #if FF_FS_EXFAT
 	if (fs->fs_type == FS_EXFAT) {	/* On the exFAT volume */
 		BYTE nc;
@@ -2462,12 +2533,14 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 #if FF_MAX_LFN < 255
 			if (fs->dirbuf[XDIR_NumName] > FF_MAX_LFN) continue;			/* Skip comparison if inaccessible object name */
 #endif
-			if (ld_word(fs->dirbuf + XDIR_NameHash) != hash) continue;	/* Skip comparison if hash mismatched */
-			for (nc = fs->dirbuf[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {	/* Compare the name */
-				if ((di % SZDIRE) == 0) di += 2;
-				if (ff_wtoupper(ld_word(fs->dirbuf + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
+			if (ld_word(fs->dirbuf + XDIR_NameHash) == hash) {	/* Skip comparison if hash mismatched */
+				for (nc = fs->dirbuf[XDIR_NumName], di = SZDIRE * 2, ni = 0; nc; nc--, di += 2, ni++) {	/* Compare the name */
+					if ((di % SZDIRE) == 0) di += 2;
+					if (ff_wtoupper(ld_word(fs->dirbuf + di)) != ff_wtoupper(fs->lfnbuf[ni])) break;
+				}
+				if (nc == 0 && !fs->lfnbuf[ni]) break;	/* Name matched? */
 			}
-			if (nc == 0 && !fs->lfnbuf[ni]) break;	/* Name matched? */
+			if (one) return FR_NO_FILE;
 		}
 		return res;
 	}
@@ -2499,6 +2572,7 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 			} else {					/* An SFN entry is found */
 				if (ord == 0 && sum == sum_sfn(dp->dir)) break;	/* LFN matched? */
 				if (!(dp->fn[NSFLAG] & NS_LOSS) && !mem_cmp(dp->dir, dp->fn, 11)) break;	/* SFN matched? */
+				if (one) { res = FR_NO_FILE; break; }
 				ord = 0xFF; dp->blk_ofs = 0xFFFFFFFF;	/* Reset LFN sequence */
 			}
 		}
@@ -2513,6 +2587,285 @@ static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
 }
 
 
+#if FF_DIR_INDEX != 0
+/*-----------------------------------------------------------------------*/
+/* Directory name index                                                  */
+/*-----------------------------------------------------------------------*/
+/* A directory gets an index on its second lookup. The index maps name   */
+/* hashes to entry blocks, so a lookup only compares the blocks with a   */
+/* matching hash. FAT entries are indexed by both LFN and SFN. exFAT     */
+/* entries use the name hash of the entry itself. New entries are added  */
+/* to the index and a removal drops the indexes of the volume.           */
+
+static DWORD dix_mix (	/* Hash of a character at a position. Keys are sums, so LFN parts can be added in any order */
+	DWORD chr,
+	UINT pos
+)
+{
+	DWORD x = (chr ^ ((DWORD)pos << 16)) * 0x9E3779B1;
+
+	return x ^ (x >> 15);
+}
+
+
+static WORD dix_lfn_key (	/* Key of an up-case folded LFN */
+	const WCHAR* name
+)
+{
+	DWORD sum = 0;
+	UINT i;
+
+
+	for (i = 0; name[i]; i++) sum += dix_mix(ff_wtoupper(name[i]), i);
+	return (WORD)(sum ^ (sum >> 16));
+}
+
+
+static WORD dix_sfn_key (	/* Key of an SFN as stored in the entry */
+	const BYTE* sfn
+)
+{
+	DWORD sum = 0;
+	UINT i;
+
+
+	for (i = 0; i < 11; i++) sum += dix_mix(sfn[i], i + 0x100);
+	return (WORD)(sum ^ (sum >> 16));
+}
+
+
+static void dix_free (
+	DIRIDX* ix
+)
+{
+	ff_memfree(ix->tbl);
+	mem_set(ix, 0, sizeof (DIRIDX));
+}
+
+
+static void dix_drop (	/* Drop all indexes of a volume */
+	FATFS* fs
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_DIR_INDEX; i++) {
+		if (DirIdx[i].fs == fs) dix_free(&DirIdx[i]);
+	}
+}
+
+
+static DIRIDX* dix_get (	/* Index of the directory, NULL if there is none */
+	DIR* dp
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_DIR_INDEX; i++) {
+		if (DirIdx[i].fs == dp->obj.fs && DirIdx[i].id == dp->obj.fs->id && DirIdx[i].sclust == dp->obj.sclust) return &DirIdx[i];
+	}
+	return 0;
+}
+
+
+static int dix_put (	/* 1:Added, 0:Not enough memory */
+	DIRIDX* ix,
+	WORD key,
+	DWORD ofs
+)
+{
+	DIXENT *tbl;
+	UINT i, j, n;
+
+
+	if ((ix->cnt + 1) * 4 > ix->size * 3) {	/* Grow the table at 3/4 load */
+		n = ix->size ? ix->size * 2 : 64;
+		tbl = ff_memalloc(n * sizeof (DIXENT));
+		if (!tbl) return 0;
+		mem_set(tbl, 0, n * sizeof (DIXENT));
+		for (i = 0; i < ix->size; i++) {	/* Move the keys */
+			if (!ix->tbl[i].ofs) continue;
+			for (j = ix->tbl[i].key & (n - 1); tbl[j].ofs; j = (j + 1) & (n - 1)) ;
+			tbl[j] = ix->tbl[i];
+		}
+		ff_memfree(ix->tbl);
+		ix->tbl = tbl; ix->size = n;
+	}
+	for (i = key & (ix->size - 1); ix->tbl[i].ofs; i = (i + 1) & (ix->size - 1)) ;
+	ix->tbl[i].ofs = ofs + 1;
+	ix->tbl[i].key = key;
+	ix->cnt++;
+	return 1;
+}
+
+
+static FRESULT dix_build (	/* Add all names of the directory to the index */
+	DIRIDX* ix,
+	DIR* dp
+)
+{
+	FRESULT res;
+	FATFS *fs = dp->obj.fs;
+	DIR dj;
+	DWORD lsum = 0, bofs = 0xFFFFFFFF;
+	WORD lkey, skey;
+	WCHAR wc;
+	BYTE c, a, ord = 0xFF, sum = 0xFF;
+	UINT i;
+	int add_sfn;
+
+
+	mem_cpy(&dj, dp, sizeof (DIR));
+	res = dir_sdi(&dj, 0);
+	while (res == FR_OK) {
+		res = move_window(fs, dj.sect);
+		if (res != FR_OK) break;
+		c = dj.dir[DIR_Name];
+		if (c == 0) break;	/* Reached to end of table */
+#if FF_FS_EXFAT
+		if (fs->fs_type == FS_EXFAT) {	/* On the exFAT volume */
+			if (c == ET_STREAM && bofs != 0xFFFFFFFF) {	/* Name hash of the preceding file entry */
+				if (!dix_put(ix, ld_word(dj.dir + XDIR_NameHash - SZDIRE), bofs)) res = FR_NOT_ENOUGH_CORE;
+			}
+			bofs = (c == ET_FILEDIR) ? dj.dptr : 0xFFFFFFFF;
+		} else
+#endif
+		{	/* On the FAT/FAT32 volume. Same LFN sequence checks as dir_match() */
+			a = dj.dir[DIR_Attr] & AM_MASK;
+			if (c == DDEM || ((a & AM_VOL) && a != AM_LFN)) {	/* An entry without valid data */
+				ord = 0xFF;
+			} else if (a == AM_LFN) {	/* An LFN entry is found */
+				if (c & LLEF) {			/* Start of LFN sequence */
+					sum = dj.dir[LDIR_Chksum];
+					c &= (BYTE)~LLEF; ord = c;
+					bofs = dj.dptr; lsum = 0;
+				}
+				if (c == ord && ord && sum == dj.dir[LDIR_Chksum]) {
+					for (i = 0; i < 13 && (wc = ld_word(dj.dir + LfnOfs[i])) != 0; i++) {
+						lsum += dix_mix(ff_wtoupper(wc), (ord - 1) * 13 + i);
+					}
+					ord--;
+				} else {
+					ord = 0xFF;
+				}
+			} else {					/* An SFN entry is found */
+				skey = dix_sfn_key(dj.dir);
+				add_sfn = 1;
+				if (ord == 0 && sum == sum_sfn(dj.dir)) {	/* Has a valid LFN? */
+					lkey = (WORD)(lsum ^ (lsum >> 16));
+					if (!dix_put(ix, lkey, bofs)) res = FR_NOT_ENOUGH_CORE;
+					add_sfn = (skey != lkey);	/* Same key needs a single slot. Any key value is valid */
+				} else {
+					bofs = dj.dptr;
+				}
+				if (add_sfn && !dix_put(ix, skey, bofs)) res = FR_NOT_ENOUGH_CORE;
+				ord = 0xFF;
+			}
+		}
+		if (res == FR_OK) res = dir_next(&dj, 0);
+	}
+	if (res == FR_NO_FILE) res = FR_OK;	/* Reached to end of directory */
+	if (res == FR_OK) ix->built = 1;
+	return res;
+}
+
+
+static int dix_find (	/* 1:Looked up with the index, result in *res, 0:No index */
+	DIR* dp,
+	FRESULT* res
+)
+{
+	FATFS *fs = dp->obj.fs;
+	DIRIDX *ix = dix_get(dp);
+	WORD keys[2];
+	UINT i, k, nk = 0;
+
+
+	if (!ix) {	/* Directory seen first time. Remember it in the oldest entry */
+		ix = &DirIdx[0];
+		for (i = 1; i < FF_DIR_INDEX; i++) {
+			if (!DirIdx[i].fs || (ix->fs && DirIdx[i].stamp < ix->stamp)) ix = &DirIdx[i];
+		}
+		dix_free(ix);
+		ix->fs = fs; ix->id = fs->id; ix->sclust = dp->obj.sclust;
+		ix->stamp = ++DixStamp;
+		return 0;
+	}
+	ix->stamp = ++DixStamp;
+	if (!ix->built && dix_build(ix, dp) != FR_OK) {	/* Build it on the second lookup */
+		dix_free(ix);
+		return 0;
+	}
+
+#if FF_FS_EXFAT
+	if (fs->fs_type == FS_EXFAT) {
+		keys[nk++] = xname_sum(fs->lfnbuf);
+	} else
+#endif
+	{
+		if (!(dp->fn[NSFLAG] & NS_NOLFN)) keys[nk++] = dix_lfn_key(fs->lfnbuf);
+		if (!(dp->fn[NSFLAG] & NS_LOSS)) keys[nk++] = dix_sfn_key(dp->fn);
+	}
+
+	for (k = 0; k < nk && ix->size; k++) {
+		for (i = keys[k] & (ix->size - 1); ix->tbl[i].ofs; i = (i + 1) & (ix->size - 1)) {
+			if (ix->tbl[i].key != keys[k]) continue;
+			*res = dir_sdi(dp, ix->tbl[i].ofs - 1);	/* Compare the name at the entry block */
+			if (*res == FR_OK) *res = dir_match(dp, 1);
+			if (*res != FR_NO_FILE) return 1;	/* Found or error */
+		}
+	}
+	*res = FR_NO_FILE;
+	return 1;
+}
+
+
+static void dix_add (	/* Add a new entry block to the index of its directory */
+	DIR* dp,
+	DWORD ofs
+)
+{
+	FATFS *fs = dp->obj.fs;
+	DIRIDX *ix = dix_get(dp);
+	WORD lkey, skey;
+	int ok = 1;
+
+
+	if (!ix || !ix->built) return;
+#if FF_FS_EXFAT
+	if (fs->fs_type == FS_EXFAT) {
+		ok = dix_put(ix, xname_sum(fs->lfnbuf), ofs);
+	} else
+#endif
+	{
+		lkey = dix_lfn_key(fs->lfnbuf);
+		skey = dix_sfn_key(dp->fn);
+		if (dp->fn[NSFLAG] & NS_LFN) ok = dix_put(ix, lkey, ofs);
+		if (ok && (!(dp->fn[NSFLAG] & NS_LFN) || skey != lkey)) ok = dix_put(ix, skey, ofs);
+	}
+	if (!ok) dix_free(ix);
+}
+#endif
+
+
+static FRESULT dir_find (	/* FR_OK(0):succeeded, !=0:error */
+	DIR* dp					/* Pointer to the directory object with the file name */
+)
+{
+	FRESULT res;
+
+
+	res = dir_sdi(dp, 0);			/* Rewind directory object */
+	if (res != FR_OK) return res;
+#if FF_DIR_INDEX != 0
+	if (dix_find(dp, &res)) return res;
+#endif
+	return dir_match(dp, 0);
+}
+
+
 
 
 #if !FF_FS_READONLY
@@ -2529,6 +2882,9 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 #if FF_USE_LFN		/* LFN configuration */
 	UINT n, nlen, nent;
 	BYTE sn[12], sum;
+#if FF_DIR_INDEX != 0
+	DWORD bofs;
+#endif
 
 
 	if (dp->fn[NSFLAG] & (NS_DOT | NS_NONAME)) return FR_INVALID_NAME;	/* Check name validity */
@@ -2562,6 +2918,9 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 		}
 
 		create_xdir(fs->dirbuf, fs->lfnbuf);	/* Create on-memory directory block to be written later */
+#if FF_DIR_INDEX != 0
+		dix_add(dp, dp->blk_ofs);
+#endif
 		return FR_OK;
 	}
 #endif
@@ -2582,6 +2941,9 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 	/* Create an SFN with/without LFNs. */
 	nent = (sn[NSFLAG] & NS_LFN) ? (nlen + 12) / 13 + 1 : 1;	/* Number of entries to allocate */
 	res = dir_alloc(dp, nent);		/* Allocate entries */
+#if FF_DIR_INDEX != 0
+	bofs = dp->dptr - SZDIRE * (nent - 1);	/* Allocated entry block offset */
+#endif
 	if (res == FR_OK && --nent) {	/* Set LFN entry if needed */
 		res = dir_sdi(dp, dp->dptr - nent * SZDIRE);
 		if (res == FR_OK) {
@@ -2613,6 +2975,9 @@ static FRESULT dir_register (	/* FR_OK:succeeded, FR_DENIED:no free entry or too
 			fs->wflag = 1;
 		}
 	}
+#if FF_USE_LFN && FF_DIR_INDEX != 0
+	if (res == FR_OK) dix_add(dp, bofs);
+#endif
 
 	return res;
 }
@@ -2635,6 +3000,9 @@ static FRESULT dir_remove (	/* FR_OK:Succeeded, FR_DISK_ERR:A disk error */
 #if FF_USE_LFN		/* LFN configuration */
 	DWORD last = dp->dptr;
 
+#if FF_DIR_INDEX != 0
+	dix_drop(fs);	/* Entry blocks may be reused by other names, also when a removed sub-directory is */
+#endif
 	res = (dp->blk_ofs == 0xFFFFFFFF) ? FR_OK : dir_sdi(dp, dp->blk_ofs);	/* Goto top of the entry block if LFN is exist */
 	if (res == FR_OK) {
 		do {
@@ -3410,6 +3778,7 @@ static FRESULT find_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 
 #if !FF_FS_READONLY
 		fs->last_clst = fs->free_clst = 0xFFFFFFFF;		/* Initialize cluster allocation information */
+		fs->bm_hint_ncl = 0;
 #endif
 		fmt = FS_EXFAT;			/* FAT sub-type */
 	} else
@@ -3587,6 +3956,9 @@ FRESULT f_mount (
 #if FF_FS_LOCK != 0
 		clear_lock(cfs);
 #endif
+#if FF_DIR_INDEX != 0
+		dix_drop(cfs);
+#endif
 #if FF_FS_REENTRANT						/* Discard sync object of the current volume */
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
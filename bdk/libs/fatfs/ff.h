@@ -120,6 +120,10 @@ typedef struct {
 #if !FF_FS_READONLY
 	DWORD	last_clst;		/* Last allocated cluster */
 	DWORD	free_clst;		/* Number of free clusters */
+#if FF_FS_EXFAT
+	DWORD	bm_hint_scl;	/* Start of a known free cluster run */
+	DWORD	bm_hint_ncl;	/* Size of the known free cluster run (0:none) */
+#endif
 #endif
 #if FF_FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
@@ -498,6 +498,122 @@ DWORD ff_wtoupper (	/* Returns up-converted code point */
 	DWORD uni		/* Unicode code point to be up-converted */
 )
 {
+#if FF_UPCASE_TBL == 2
+	/* Page tables for U+0000 - U+FFFF. The up-converted code point is the code point
+	   plus a delta. Generated from the compressed tables by tools/hostsim/upbench -g */
+	static const BYTE uct1[] = {	/* Row of each 256 code points */
+		0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x07,0x08,0x09,
+		0x06,0x0A,0x06,0x06,0x0B,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x0C,0x0D,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,
+		0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x0E
+	};
+	static const BYTE uct2[][16] = {	/* Block of each 16 code points in a row */
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x01,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x04},
+		{0x05,0x05,0x05,0x06,0x07,0x05,0x05,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,0x05,0x0F},
+		{0x05,0x05,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x00,0x00,0x19,0x01,0x1A,0x1B,0x05,0x1C},
+		{0x00,0x00,0x00,0x03,0x03,0x1D,0x05,0x05,0x1E,0x05,0x05,0x05,0x1F,0x05,0x05,0x05},
+		{0x05,0x20,0x00,0x00,0x00,0x00,0x21,0x22,0x23,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x24,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x05,0x25,0x05,0x05,0x05,0x05,0x05,0x26},
+		{0x27,0x28,0x27,0x27,0x28,0x29,0x27,0x2A,0x27,0x27,0x27,0x2B,0x2C,0x2D,0x2E,0x2F},
+		{0x00,0x00,0x00,0x00,0x30,0x00,0x00,0x31,0x32,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x33,0x34,0x00},
+		{0x00,0x00,0x00,0x22,0x22,0x35,0x36,0x37,0x05,0x05,0x05,0x05,0x05,0x05,0x20,0x00},
+		{0x38,0x38,0x39,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x01,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}
+	};
+	static const BYTE uct3[][16] = {	/* Delta index of each code point in a block */
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01},
+		{0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x00,0x00,0x00,0x00},
+		{0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01},
+		{0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x00,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x02},
+		{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00},
+		{0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00},
+		{0x04,0x00,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x00,0x00,0x03,0x00,0x00,0x00},
+		{0x00,0x00,0x03,0x00,0x00,0x05,0x00,0x00,0x00,0x03,0x06,0x00,0x00,0x00,0x07,0x00},
+		{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x03,0x00,0x00},
+		{0x03,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x00,0x03,0x00,0x00,0x00,0x03,0x00,0x08},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x09,0x00,0x00,0x09,0x00,0x00,0x09,0x00,0x03,0x00},
+		{0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x0A,0x00,0x03},
+		{0x00,0x00,0x00,0x09,0x00,0x03,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x03,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x0B,0x00,0x03,0x00,0x0C,0x00},
+		{0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x00,0x00,0x0D,0x0E,0x00,0x0F,0x0F,0x00,0x10,0x00,0x11,0x00,0x00,0x00,0x00},
+		{0x0F,0x00,0x00,0x12,0x00,0x00,0x00,0x00,0x13,0x14,0x00,0x15,0x00,0x00,0x00,0x14},
+		{0x00,0x00,0x16,0x00,0x00,0x17,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x00,0x00},
+		{0x19,0x00,0x00,0x19,0x00,0x00,0x00,0x00,0x19,0x1A,0x1B,0x1B,0x1C,0x00,0x00,0x00},
+		{0x00,0x00,0x1D,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x07,0x07,0x07,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x1E,0x1F,0x1F,0x1F},
+		{0x01,0x01,0x20,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x01,0x21,0x22,0x22,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x00,0x23,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x03,0x00,0x00,0x00,0x00},
+		{0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24,0x24},
+		{0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03},
+		{0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x25},
+		{0x00,0x03,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26},
+		{0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26},
+		{0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x27,0x00,0x00},
+		{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x28,0x28,0x28,0x28,0x28,0x28,0x28,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x28,0x28,0x28,0x28,0x28,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x28,0x00,0x28,0x00,0x28,0x00,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x29,0x29,0x2A,0x2A,0x2A,0x2A,0x2B,0x2B,0x2C,0x2C,0x2D,0x2D,0x2E,0x2E,0x00,0x00},
+		{0x28,0x28,0x00,0x2F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x30,0x00,0x00,0x00},
+		{0x28,0x28,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x28,0x28,0x00,0x00,0x00,0x23,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x2F,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x31,0x00},
+		{0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32,0x32},
+		{0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33},
+		{0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x33,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x26,0x00},
+		{0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x03,0x00,0x03,0x00,0x00,0x00},
+		{0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
+		{0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34,0x34},
+		{0x34,0x34,0x34,0x34,0x34,0x34,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}
+	};
+	static const WORD uctd[] = {	/* Up conversion deltas */
+		0x0000,0xFFE0,0x0079,0xFFFF,0x00C3,0x0061,0x00A3,0x0082,
+		0x0038,0xFFFE,0xFFB1,0x2A2B,0x2A28,0xFF2E,0xFF32,0xFF33,
+		0xFF36,0xFF35,0xFF31,0xFF2F,0xFF2D,0x29F7,0xFF2B,0xFF2A,
+		0x29E7,0xFF26,0xFFBB,0xFF27,0xFFB9,0xFF25,0xFFDA,0xFFDB,
+		0xFFE1,0xFFC0,0xFFC1,0x0007,0xFFB0,0xFFF1,0xFFD0,0x0EE6,
+		0x0008,0x004A,0x0056,0x0064,0x0080,0x0070,0x007E,0x0009,
+		0xFFF7,0xFFE4,0xFFF0,0xFFE6,0xE3A0
+	};
+
+	if (uni < 0x80) {		/* Is it ASCII? */
+		if (uni >= 'a' && uni <= 'z') uni -= 0x20;
+	} else if (uni < 0x10000) {	/* Is it in BMP? */
+		uni = (WORD)(uni + uctd[uct3[uct2[uct1[uni >> 8]][(uni >> 4) & 15]][uni & 15]]);
+	}
+
+	return uni;
+#else
 	const WORD *p;
 	WORD uc, bc, nc, cmd;
 	static const WORD cvt1[] = {	/* Compressed up conversion table for U+0000 - U+0FFF */
@@ -593,6 +709,11 @@ DWORD ff_wtoupper (	/* Returns up-converted code point */
 	};
 
 
+#if FF_UPCASE_TBL == 1
+	if (uni < 0x80) {		/* Is it ASCII? */
+		return (uni >= 'a' && uni <= 'z') ? uni - 0x20 : uni;
+	}
+#endif
 	if (uni < 0x10000) {	/* Is it in BMP? */
 		uc = (WORD)uni;
 		p = uc < 0x1000 ? cvt1 : cvt2;
@@ -620,6 +741,7 @@ DWORD ff_wtoupper (	/* Returns up-converted code point */
 	}
 
 	return uni;
+#endif
 }
 
 #endif /* #if FF_USE_LFN */
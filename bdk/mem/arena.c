@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+#include "heap.h"
+
+// Arena info is before arena memory.
+arena_t *arena_create(u32 size)
+{
+	u32 hdr_size = ALIGN(sizeof(arena_t), ARENA_ALIGN);
+
+	if (size > UINT32_MAX - hdr_size)
+		return NULL;
+
+	arena_t *arena = (arena_t *)malloc(hdr_size + size);
+	if (!arena)
+		return NULL;
+
+	arena->start = (u32)arena + hdr_size;
+	arena->end   = arena->start + size;
+	arena->pos   = arena->start;
+
+	return arena;
+}
+
+void arena_destroy(arena_t *arena)
+{
+	if (arena)
+		free(arena);
+}
+
+void *arena_alloc_aligned(arena_t *arena, u32 size, u32 align)
+{
+	// Alignment must be a power of 2.
+	u32 addr = ALIGN(arena->pos, align);
+
+	if (addr < arena->pos || addr > arena->end || size > arena->end - addr)
+		return NULL;
+
+	arena->pos = addr + size;
+
+	return (void *)addr;
+}
+
+void *arena_alloc(arena_t *arena, u32 size)
+{
+	return arena_alloc_aligned(arena, size, ARENA_ALIGN);
+}
+
+void *arena_calloc(arena_t *arena, u32 num, u32 size)
+{
+	if (num && size > UINT32_MAX / num)
+		return NULL;
+
+	void *res = arena_alloc(arena, num * size);
+	if (res)
+		memset(res, 0, num * size);
+
+	return res;
+}
+
+u32 arena_mark(arena_t *arena)
+{
+	return arena->pos;
+}
+
+void arena_reset(arena_t *arena, u32 mark)
+{
+	// Only allow rewinding to a previous mark.
+	if (mark >= arena->start && mark <= arena->pos)
+		arena->pos = mark;
+}
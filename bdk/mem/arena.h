@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <utils/types.h>
+
+#define ARENA_ALIGN 0x20 // Arch cache line size. Also satisfies SDMMC DMA alignment.
+
+typedef struct _arena_t
+{
+	u32 start;
+	u32 end;
+	u32 pos;
+} arena_t;
+
+arena_t *arena_create(u32 size);
+void  arena_destroy(arena_t *arena);
+void *arena_alloc(arena_t *arena, u32 size);
+void *arena_alloc_aligned(arena_t *arena, u32 size, u32 align);
+void *arena_calloc(arena_t *arena, u32 num, u32 size);
+u32   arena_mark(arena_t *arena);
+void  arena_reset(arena_t *arena, u32 mark);
+
+#endif
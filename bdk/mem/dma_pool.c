@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dma_pool.h"
+#include <mem/heap.h>
+
+/*
+ * Pool of DRAM sector buffers for SDMMC DMA.
+ * Buffers on stack or BSS reside in IRAM and force a bounce copy in sdmmc.
+ */
+static u8 *pool;
+static u32 pool_map;
+
+void *dma_pool_alloc()
+{
+	if (!pool)
+	{
+		pool = (u8 *)malloc(DMA_POOL_BUF_SZ * DMA_POOL_BUFS);
+		pool_map = 0;
+	}
+
+	u32 free_map = ~pool_map & (BIT(DMA_POOL_BUFS) - 1);
+	if (!free_map)
+		return malloc(DMA_POOL_BUF_SZ); // Heap memory is also DMA aligned.
+
+	u32 idx = LOG2(free_map & -free_map);
+	pool_map |= BIT(idx);
+
+	return pool + idx * DMA_POOL_BUF_SZ;
+}
+
+void dma_pool_free(void *buf)
+{
+	u8 *addr = (u8 *)buf;
+	if (!addr)
+		return;
+
+	if (addr >= pool && addr < pool + DMA_POOL_BUF_SZ * DMA_POOL_BUFS)
+		pool_map &= ~BIT((addr - pool) / DMA_POOL_BUF_SZ);
+	else
+		free(buf);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _DMA_POOL_H_
+#define _DMA_POOL_H_
+
+#include <libs/fatfs/ff.h>
+#include <utils/types.h>
+
+#define DMA_POOL_BUF_SZ SZ_4K // Fits a FIL or FATFS object or 8 sectors.
+#define DMA_POOL_BUFS   8
+
+_Static_assert(sizeof(FATFS) <= DMA_POOL_BUF_SZ, "FATFS does not fit in a DMA pool buffer!");
+_Static_assert(sizeof(FIL) <= DMA_POOL_BUF_SZ, "FIL does not fit in a DMA pool buffer!");
+
+void *dma_pool_alloc();
+void  dma_pool_free(void *buf);
+
+#endif
@@ -1,177 +1,444 @@
-/*
- * Copyright (c) 2018 naehrwert
- * Copyright (c) 2018-2020 CTCaer
- *
- * This program is free software; you can redistribute it and/or modify it
- * under the terms and conditions of the GNU General Public License,
- * version 2, as published by the Free Software Foundation.
- *
- * This program is distributed in the hope it will be useful, but WITHOUT
- * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
- * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
- * more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#include <string.h>
-#include "heap.h"
-#include <gfx_utils.h>
-
-static void _heap_create(heap_t *heap, u32 start)
-{
-	heap->start = start;
-	heap->first = NULL;
-}
-
-// Node info is before node address.
-static u32 _heap_alloc(heap_t *heap, u32 size)
-{
-	hnode_t *node, *new_node;
-
-	// Align to cache line size.
-	size = ALIGN(size, sizeof(hnode_t));
-
-	if (!heap->first)
-	{
-		node = (hnode_t *)heap->start;
-		node->used = 1;
-		node->size = size;
-		node->prev = NULL;
-		node->next = NULL;
-		heap->first = node;
-
-		return (u32)node + sizeof(hnode_t);
-	}
-
-	node = heap->first;
-	while (true)
-	{
-		// Check if there's available unused node.
-		if (!node->used && (size <= node->size))
-		{
-			// Size and offset of the new unused node.
-			u32 new_size = node->size - size;
-			new_node = (hnode_t *)((u32)node + sizeof(hnode_t) + size);
-
-			// If there's aligned unused space from the old node,
-			// create a new one and set the leftover size.
-			if (new_size >= (sizeof(hnode_t) << 2))
-			{
-				new_node->size = new_size - sizeof(hnode_t);
-				new_node->used = 0;
-				new_node->next = node->next;
-
-				// Check that we are not on first node.
-				if (new_node->next)
-					new_node->next->prev = new_node;
-
-				new_node->prev = node;
-				node->next = new_node;
-			}
-			else // Unused node size is just enough.
-				size += new_size;
-
-			node->size = size;
-			node->used = 1;
-
-			return (u32)node + sizeof(hnode_t);
-		}
-
-		// No unused node found, try the next one.
-		if (node->next)
-			node = node->next;
-		else
-			break;
-	}
-
-	// No unused node found, create a new one.
-	new_node = (hnode_t *)((u32)node + sizeof(hnode_t) + node->size);
-	new_node->used = 1;
-	new_node->size = size;
-	new_node->prev = node;
-	new_node->next = NULL;
-	node->next = new_node;
-
-	return (u32)new_node + sizeof(hnode_t);
-}
-
-static void _heap_free(heap_t *heap, u32 addr)
-{
-	hnode_t *node = (hnode_t *)(addr - sizeof(hnode_t));
-	node->used = 0;
-	node = heap->first;
-	while (node)
-	{
-		if (!node->used)
-		{
-			if (node->prev && !node->prev->used)
-			{
-				node->prev->size += node->size + sizeof(hnode_t);
-				node->prev->next = node->next;
-
-				if (node->next)
-					node->next->prev = node->prev;
-			}
-		}
-		node = node->next;
-	}
-}
-
-heap_t _heap;
-
-void heap_init(u32 base)
-{
-	_heap_create(&_heap, base);
-}
-
-void heap_copy(heap_t *heap)
-{
-	memcpy(&_heap, heap, sizeof(heap_t));
-}
-
-void *malloc(u32 size)
-{
-	return (void *)_heap_alloc(&_heap, size);
-}
-
-void *calloc(u32 num, u32 size)
-{
-	void *res = (void *)_heap_alloc(&_heap, num * size);
-	memset(res, 0, ALIGN(num * size, sizeof(hnode_t))); // Clear the aligned size.
-	return res;
-}
-
-void free(void *buf)
-{
-	if ((u32)buf >= _heap.start)
-		_heap_free(&_heap, (u32)buf);
-}
-
-void heap_monitor(heap_monitor_t *mon, bool print_node_stats)
-{
-	u32 count = 0;
-	memset(mon, 0, sizeof(heap_monitor_t));
-
-	hnode_t *node = _heap.first;
-	while (true)
-	{
-		if (node->used)
-			mon->used += node->size + sizeof(hnode_t);
-		else
-			mon->total += node->size + sizeof(hnode_t);
-
-		if (print_node_stats)
-			gfx_printf("%3d - %d, addr: 0x%08X, size: 0x%X\n",
-				count, node->used, (u32)node + sizeof(hnode_t), node->size);
-
-		count++;
-
-		if (node->next)
-			node = node->next;
-		else
-			break;
-	}
-	mon->total += mon->used;
-}
+/*
+ * Copyright (c) 2018 naehrwert
+ * Copyright (c) 2018-2020 CTCaer
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "heap.h"
+#include <gfx_utils.h>
+#ifdef HEAP_TRACE
+#include <memory_map.h>
+#include <utils/trace_ring.h>
+#include <utils/util.h>
+#endif
+
+static void _heap_create(heap_t *heap, u32 start)
+{
+	memset(heap, 0, sizeof(heap_t));
+	heap->start = start;
+}
+
+// Size classes are power of 2 ranges of cache line sized units.
+static u32 _heap_bin(u32 size)
+{
+	return LOG2((size / sizeof(hnode_t)) | 1);
+}
+
+static void _heap_link_free(heap_t *heap, hnode_t *node)
+{
+	u32 bin = _heap_bin(node->size);
+
+	node->fprev = NULL;
+	node->fnext = heap->bins[bin];
+	if (node->fnext)
+		node->fnext->fprev = node;
+
+	heap->bins[bin] = node;
+	heap->bin_map |= BIT(bin);
+}
+
+static void _heap_unlink_free(heap_t *heap, hnode_t *node)
+{
+	u32 bin = _heap_bin(node->size);
+
+	if (node->fprev)
+		node->fprev->fnext = node->fnext;
+	else
+		heap->bins[bin] = node->fnext;
+
+	if (node->fnext)
+		node->fnext->fprev = node->fprev;
+
+	if (!heap->bins[bin])
+		heap->bin_map &= ~BIT(bin);
+}
+
+// Smallest node that fits, of the first HEAP_FIT_SCAN ones of a free list. An exact fit ends the scan.
+static hnode_t *_heap_best_fit(hnode_t *node, u32 size)
+{
+	hnode_t *best = NULL;
+	u32 scan = HEAP_FIT_SCAN;
+
+	for (; node && scan; node = node->fnext, scan--)
+	{
+		if (node->size < size || (best && node->size >= best->size))
+			continue;
+
+		best = node;
+		if (node->size == size)
+			break;
+	}
+
+	return best;
+}
+
+static hnode_t *_heap_find_free(heap_t *heap, u32 size)
+{
+	u32 bin = _heap_bin(size);
+
+	// Check the same size class for the best fit.
+	hnode_t *node = _heap_best_fit(heap->bins[bin], size);
+	if (node)
+		return node;
+
+	// Any node from a bigger size class fits. Get the best one of the smallest class.
+	u32 map = heap->bin_map & ~(BIT(bin + 1) - 1);
+	if (!map)
+		return NULL;
+
+	return _heap_best_fit(heap->bins[LOG2(map & -map)], size);
+}
+
+static u32 _heap_mark_used(heap_t *heap, hnode_t *node)
+{
+	node->used = 1;
+
+	heap->used += node->size + sizeof(hnode_t);
+	if (heap->used > heap->used_max)
+		heap->used_max = heap->used;
+
+	return (u32)node + sizeof(hnode_t);
+}
+
+// Node info is before node address.
+static u32 _heap_alloc(heap_t *heap, u32 size)
+{
+	hnode_t *node, *new_node;
+
+	// Align to cache line size.
+	size = ALIGN(size, sizeof(hnode_t));
+
+	if (!heap->first)
+	{
+		node = (hnode_t *)heap->start;
+		node->size = size;
+		node->prev = NULL;
+		node->next = NULL;
+		heap->first = node;
+		heap->last = node;
+
+		return _heap_mark_used(heap, node);
+	}
+
+	// Check if there's available unused node.
+	node = _heap_find_free(heap, size);
+	if (node)
+	{
+		_heap_unlink_free(heap, node);
+
+		// Size and offset of the new unused node.
+		u32 new_size = node->size - size;
+		new_node = (hnode_t *)((u32)node + sizeof(hnode_t) + size);
+
+		// If there's aligned unused space from the old node,
+		// create a new one and set the leftover size.
+		if (new_size >= (sizeof(hnode_t) << 2))
+		{
+			new_node->size = new_size - sizeof(hnode_t);
+			new_node->used = 0;
+			new_node->next = node->next;
+
+			// Check that we are not on last node.
+			if (new_node->next)
+				new_node->next->prev = new_node;
+			else
+				heap->last = new_node;
+
+			new_node->prev = node;
+			node->next = new_node;
+
+			_heap_link_free(heap, new_node);
+		}
+		else // Unused node size is just enough.
+			size += new_size;
+
+		node->size = size;
+
+		return _heap_mark_used(heap, node);
+	}
+
+	// No unused node found. If last node is unused, expand it.
+	node = heap->last;
+	if (!node->used)
+	{
+		_heap_unlink_free(heap, node);
+		node->size = size;
+
+		return _heap_mark_used(heap, node);
+	}
+
+	// Create a new one.
+	new_node = (hnode_t *)((u32)node + sizeof(hnode_t) + node->size);
+	new_node->size = size;
+	new_node->prev = node;
+	new_node->next = NULL;
+	node->next = new_node;
+	heap->last = new_node;
+
+	return _heap_mark_used(heap, new_node);
+}
+
+static void _heap_free(heap_t *heap, u32 addr);
+
+// Release the aligned unused space at the end of a used node.
+static void _heap_trim(heap_t *heap, hnode_t *node, u32 size)
+{
+	u32 new_size = node->size - size;
+	if (new_size < (sizeof(hnode_t) << 2))
+		return;
+
+	hnode_t *new_node = (hnode_t *)((u32)node + sizeof(hnode_t) + size);
+	new_node->size = new_size - sizeof(hnode_t);
+	new_node->used = 1;
+	new_node->next = node->next;
+
+	if (new_node->next)
+		new_node->next->prev = new_node;
+	else
+		heap->last = new_node;
+
+	new_node->prev = node;
+	node->next = new_node;
+	node->size = size;
+
+	_heap_free(heap, (u32)new_node + sizeof(hnode_t));
+}
+
+static u32 _heap_alloc_aligned(heap_t *heap, u32 size, u32 align)
+{
+	// Nodes are already cache line aligned.
+	if (align <= sizeof(hnode_t))
+		return _heap_alloc(heap, size);
+
+	size = ALIGN(size, sizeof(hnode_t));
+	u32 addr = _heap_alloc(heap, size + align - sizeof(hnode_t));
+	hnode_t *node = (hnode_t *)(addr - sizeof(hnode_t));
+
+	// Split off the unaligned front space as a new unused node.
+	if (addr % align)
+	{
+		u32 aligned = ALIGN(addr, align);
+		hnode_t *new_node = (hnode_t *)(aligned - sizeof(hnode_t));
+
+		new_node->size = node->size - (aligned - addr);
+		new_node->used = 1;
+		new_node->next = node->next;
+
+		if (new_node->next)
+			new_node->next->prev = new_node;
+		else
+			heap->last = new_node;
+
+		new_node->prev = node;
+		node->next = new_node;
+		node->size = aligned - addr - sizeof(hnode_t);
+
+		_heap_free(heap, addr);
+
+		node = new_node;
+		addr = aligned;
+	}
+
+	_heap_trim(heap, node, size);
+
+	return addr;
+}
+
+static void _heap_free(heap_t *heap, u32 addr)
+{
+	hnode_t *node = (hnode_t *)(addr - sizeof(hnode_t));
+
+	// Check for double free.
+	if (!node->used)
+		return;
+
+	node->used = 0;
+	heap->used -= node->size + sizeof(hnode_t);
+
+	// Merge with next node if unused.
+	hnode_t *neighbor = node->next;
+	if (neighbor && !neighbor->used)
+	{
+		_heap_unlink_free(heap, neighbor);
+		node->size += neighbor->size + sizeof(hnode_t);
+		node->next = neighbor->next;
+
+		if (node->next)
+			node->next->prev = node;
+		else
+			heap->last = node;
+	}
+
+	// Merge with previous node if unused.
+	neighbor = node->prev;
+	if (neighbor && !neighbor->used)
+	{
+		_heap_unlink_free(heap, neighbor);
+		neighbor->size += node->size + sizeof(hnode_t);
+		neighbor->next = node->next;
+
+		if (neighbor->next)
+			neighbor->next->prev = neighbor;
+		else
+			heap->last = neighbor;
+
+		node = neighbor;
+	}
+
+	_heap_link_free(heap, node);
+}
+
+heap_t _heap;
+
+#ifdef HEAP_TRACE
+static void _heap_trace_init()
+{
+	heap_trace_hdr_t *trace = (heap_trace_hdr_t *)HEAP_TRACE_ADDR;
+
+	memset(trace, 0, sizeof(heap_trace_hdr_t));
+	trace->magic = HEAP_TRACE_MAGIC;
+	trace->version = HEAP_TRACE_VERSION;
+	trace->entry_size = sizeof(heap_trace_entry_t);
+	trace->capacity = (HEAP_TRACE_SZ - sizeof(heap_trace_hdr_t)) / sizeof(heap_trace_entry_t);
+	trace->heap_start = _heap.start;
+}
+
+static void _heap_trace(u32 op, u32 caller, u32 addr, u32 size)
+{
+	heap_trace_hdr_t *trace = (heap_trace_hdr_t *)HEAP_TRACE_ADDR;
+	heap_trace_entry_t *entry = (heap_trace_entry_t *)(HEAP_TRACE_ADDR + sizeof(heap_trace_hdr_t));
+
+	entry += trace->head;
+	entry->timestamp = get_tmr_us();
+	entry->caller = caller;
+	entry->addr = addr;
+	entry->size = size;
+	entry->op = op;
+
+	trace->head++;
+	if (trace->head == trace->capacity)
+		trace->head = 0;
+	trace->count++;
+}
+#endif
+
+void heap_init(u32 base)
+{
+	_heap_create(&_heap, base);
+#ifdef HEAP_TRACE
+	_heap_trace_init();
+#endif
+}
+
+void heap_copy(heap_t *heap)
+{
+	memcpy(&_heap, heap, sizeof(heap_t));
+}
+
+void *malloc(u32 size)
+{
+	void *res = (void *)_heap_alloc(&_heap, size);
+#ifdef HEAP_TRACE
+	_heap_trace(HEAP_TRACE_ALLOC, (u32)__builtin_return_address(0), (u32)res, size);
+#endif
+	return res;
+}
+
+void *calloc(u32 num, u32 size)
+{
+	void *res = (void *)_heap_alloc(&_heap, num * size);
+	memset(res, 0, ALIGN(num * size, sizeof(hnode_t))); // Clear the aligned size.
+#ifdef HEAP_TRACE
+	_heap_trace(HEAP_TRACE_ALLOC, (u32)__builtin_return_address(0), (u32)res, num * size);
+#endif
+	return res;
+}
+
+void *memalign(u32 align, u32 size)
+{
+	void *res = (void *)_heap_alloc_aligned(&_heap, size, align);
+#ifdef HEAP_TRACE
+	_heap_trace(HEAP_TRACE_ALLOC, (u32)__builtin_return_address(0), (u32)res, size);
+#endif
+	return res;
+}
+
+void free(void *buf)
+{
+	if ((u32)buf >= _heap.start)
+	{
+#ifdef HEAP_TRACE
+		hnode_t *node = (hnode_t *)((u32)buf - sizeof(hnode_t));
+		_heap_trace(HEAP_TRACE_FREE, (u32)__builtin_return_address(0), (u32)buf, node->size);
+#endif
+		_heap_free(&_heap, (u32)buf);
+	}
+}
+
+void heap_monitor(heap_monitor_t *mon, bool print_node_stats)
+{
+	u32 count = 0;
+	memset(mon, 0, sizeof(heap_monitor_t));
+
+	hnode_t *node = _heap.first;
+	while (true)
+	{
+		if (node->used)
+			mon->used += node->size + sizeof(hnode_t);
+		else
+		{
+			mon->total += node->size + sizeof(hnode_t);
+			if (node->size > mon->free_largest)
+				mon->free_largest = node->size;
+		}
+
+		if (print_node_stats)
+			gfx_printf("%3d - %d, addr: 0x%08X, size: 0x%X\n",
+				count, node->used, (u32)node + sizeof(hnode_t), node->size);
+
+		count++;
+
+		if (node->next)
+			node = node->next;
+		else
+			break;
+	}
+
+	// Sizes are in cache line units, so the percentage can't overflow.
+	if (mon->total)
+		mon->frag = 100 - (mon->free_largest / sizeof(hnode_t)) * 100 / (mon->total / sizeof(hnode_t));
+
+	mon->total += mon->used;
+	mon->used_max = _heap.used_max;
+
+	if (print_node_stats)
+		gfx_printf("used: 0x%X, max: 0x%X, largest free: 0x%X, frag: %d%%\n",
+			mon->used, mon->used_max, mon->free_largest, mon->frag);
+}
+
+#ifdef HEAP_TRACE
+_Static_assert(OFFSET_OF(heap_trace_hdr_t, head) == OFFSET_OF(trace_ring_hdr_t, head), "Heap trace header must start like trace_ring_hdr_t!");
+
+int heap_trace_save(const char *path)
+{
+	heap_trace_hdr_t hdr;
+
+	// Snapshot the header, since the trace may grow while saving.
+	memcpy(&hdr, (void *)HEAP_TRACE_ADDR, sizeof(heap_trace_hdr_t));
+	hdr.used_max = _heap.used_max;
+
+	return trace_ring_save(path, &hdr, sizeof(heap_trace_hdr_t), (void *)(HEAP_TRACE_ADDR + sizeof(heap_trace_hdr_t)));
+}
+#endif
@@ -1,51 +1,107 @@
-/*
- * Copyright (c) 2018 naehrwert
- * Copyright (c) 2018-2020 CTCaer
- *
- * This program is free software; you can redistribute it and/or modify it
- * under the terms and conditions of the GNU General Public License,
- * version 2, as published by the Free Software Foundation.
- *
- * This program is distributed in the hope it will be useful, but WITHOUT
- * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
- * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
- * more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#ifndef _HEAP_H_
-#define _HEAP_H_
-
-#include <utils/types.h>
-
-typedef struct _hnode
-{
-	int used;
-	u32 size;
-	struct _hnode *prev;
-	struct _hnode *next;
-	u32 align[4]; // Align to arch cache line size.
-} hnode_t;
-
-typedef struct _heap
-{
-	u32 start;
-	hnode_t *first;
-} heap_t;
-
-typedef struct
-{
-    u32 total;
-    u32 used;
-} heap_monitor_t;
-
-void heap_init(u32 base);
-void heap_copy(heap_t *heap);
-void *malloc(u32 size);
-void *calloc(u32 num, u32 size);
-void free(void *buf);
-void heap_monitor(heap_monitor_t *mon, bool print_node_stats);
-
-#endif
+/*
+ * Copyright (c) 2018 naehrwert
+ * Copyright (c) 2018-2020 CTCaer
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HEAP_H_
+#define _HEAP_H_
+
+#include <utils/types.h>
+
+#define HEAP_BINS 32
+#define HEAP_FIT_SCAN 16 // Free list nodes checked for the best fit.
+
+typedef struct _hnode
+{
+	int used;
+	u32 size;
+	struct _hnode *prev;  // Previous node in address order.
+	struct _hnode *next;  // Next node in address order.
+	struct _hnode *fprev; // Previous node in size class free list. Valid only if unused.
+	struct _hnode *fnext; // Next node in size class free list. Valid only if unused.
+} __attribute__((aligned(0x20))) hnode_t; // Padded to arch cache line size. 64 bytes on 64-bit hosts.
+
+typedef struct _heap
+{
+	u32 start;
+	hnode_t *first;
+	hnode_t *last;
+	u32 bin_map; // Bitmap of non-empty size classes.
+	hnode_t *bins[HEAP_BINS];
+	u32 used;     // Used size including node info.
+	u32 used_max; // High-water mark of used size.
+} heap_t;
+
+typedef struct
+{
+    u32 total;
+    u32 used;
+    u32 used_max;     // High-water mark of used size.
+    u32 free_largest; // Largest unused node.
+    u32 frag;         // Fragmentation percentage. 0: all unused space is in one node.
+} heap_monitor_t;
+
+#ifdef HEAP_TRACE
+/*
+ * Trace file layout (little endian):
+ *  heap_trace_hdr_t, followed by hdr.entries heap_trace_entry_t in chronological order.
+ * hdr.count is the number of recorded operations. If it exceeds hdr.capacity,
+ * only the last hdr.capacity ones are kept.
+ */
+#define HEAP_TRACE_MAGIC   0x43525448 // "HTRC".
+#define HEAP_TRACE_VERSION 1
+
+enum
+{
+	HEAP_TRACE_ALLOC = 0,
+	HEAP_TRACE_FREE  = 1
+};
+
+typedef struct _heap_trace_entry_t
+{
+	u32 timestamp; // us.
+	u32 caller;    // Return address of the call site.
+	u32 addr;      // Returned or freed address.
+	u32 size;      // Requested size. Node size for frees.
+	u32 op;
+} heap_trace_entry_t;
+
+typedef struct _heap_trace_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 entry_size;
+	u32 entries;
+	u32 count;
+	u32 capacity;
+	u32 head;
+	u32 heap_start;
+	u32 used_max;
+	u32 rsvd[7];
+} heap_trace_hdr_t;
+#endif
+
+void heap_init(u32 base);
+void heap_copy(heap_t *heap);
+void *malloc(u32 size);
+void *calloc(u32 num, u32 size);
+void *memalign(u32 align, u32 size); // Align must be a power of 2.
+void free(void *buf);
+void heap_monitor(heap_monitor_t *mon, bool print_node_stats);
+#ifdef HEAP_TRACE
+int  heap_trace_save(const char *path);
+#endif
+
+#endif
@@ -21,6 +21,7 @@
 #include <mem/mc.h>
 #include <mem/emc.h>
 #include <mem/sdram.h>
+#include <mem/sdram_pack.h>
 #include <mem/sdram_param_t210.h>
 #include <mem/sdram_param_t210b01.h>
 #include <memory_map.h>
@@ -36,13 +37,6 @@
 
 #define CONFIG_SDRAM_KEEP_ALIVE
 
-typedef struct _sdram_vendor_patch_t
-{
-	u32 val;
-	u32 offset:16;
-	u32 dramcf:16;
-} sdram_vendor_patch_t;
-
 static const u8 dram_encoding_t210b01[] = {
 	LPDDR4X_UNUSED,
 	LPDDR4X_UNUSED,
@@ -75,8 +69,8 @@ static const u8 dram_encoding_t210b01[] = {
 	LPDDR4X_8GB_SAMSUNG_K4UBE3D4AA_MGCL,
 };
 
-#include "sdram_config.inl"
-#include "sdram_config_t210b01.inl"
+// Packed from sdram_config.inl and sdram_config_t210b01.inl by tools/sdram at build time.
+#include "sdram_config_packed.inl"
 
 static bool _sdram_wait_emc_status(u32 reg_offset, u32 bit_mask, bool updated_state, s32 emc_channel)
 {
@@ -1379,14 +1373,13 @@ static void *_sdram_get_params_t210()
 	// Check if id is proper.
 	u32 dramid = fuse_read_dramid(false);
 
-	// Copy base parameters.
+	// Unpack base parameters.
 	u32 *params = (u32 *)SDRAM_PARAMS_ADDR;
-	memcpy(params, &_dram_cfg_0_samsung_4gb, sizeof(sdram_params_t210_t));
+	memset(params, 0, sizeof(sdram_params_t210_t));
+	sdram_unpack(params, _dram_cfg_t210_packed);
 
 	// Patch parameters if needed.
-	for (u32 i = 0; i < ARRAY_SIZE(sdram_cfg_vendor_patches_t210); i++)
-		if (sdram_cfg_vendor_patches_t210[i].dramcf & DRAM_ID(dramid))
-			params[sdram_cfg_vendor_patches_t210[i].offset] = sdram_cfg_vendor_patches_t210[i].val;
+	sdram_unpack_patch(params, _dram_cfg_t210_patches, _dram_cfg_t210_patch_idx, dramid);
 
 	return (void *)params;
 }
@@ -1396,18 +1389,17 @@ void *sdram_get_params_t210b01()
 	// Check if id is proper.
 	u32 dramid = fuse_read_dramid(false);
 
-	// Copy base parameters.
+	// Unpack base parameters.
 	u32 *params = (u32 *)SDRAM_PARAMS_ADDR;
-	memcpy(params, &_dram_cfg_08_10_12_14_samsung_hynix_4gb, sizeof(sdram_params_t210b01_t));
+	memset(params, 0, sizeof(sdram_params_t210b01_t));
+	sdram_unpack(params, _dram_cfg_t210b01_packed);
 
 	// Patch parameters if needed.
 	u8 dram_code = dram_encoding_t210b01[dramid];
 	if (!dram_code)
 		return (void *)params;
 
-	for (u32 i = 0; i < ARRAY_SIZE(sdram_cfg_vendor_patches_t210b01); i++)
-		if (sdram_cfg_vendor_patches_t210b01[i].dramcf == dram_code)
-			params[sdram_cfg_vendor_patches_t210b01[i].offset] = sdram_cfg_vendor_patches_t210b01[i].val;
+	sdram_unpack_patch(params, _dram_cfg_t210b01_patches, _dram_cfg_t210b01_patch_idx, dram_code);
 
 	return (void *)params;
 }
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mem/sdram_pack.h>
+
+void sdram_unpack(u32 *params, const u8 *ops)
+{
+	u32 op;
+
+	while ((op = *ops++))
+	{
+		u32 n = op & SDRAM_PACK_MAX_RUN;
+
+		switch (op & ~SDRAM_PACK_MAX_RUN)
+		{
+		case SDRAM_PACK_SKIP:
+			params += n;
+			break;
+		case SDRAM_PACK_BYTE:
+			while (n--)
+				*params++ = *ops++;
+			break;
+		case SDRAM_PACK_WORD:
+			while (n--)
+			{
+				*params++ = ops[0] | (ops[1] << 8) | (ops[2] << 16) | ((u32)ops[3] << 24);
+				ops += 4;
+			}
+			break;
+		case SDRAM_PACK_REPEAT:
+			while (n--)
+			{
+				*params = params[-1];
+				params++;
+			}
+			break;
+		}
+	}
+}
+
+void sdram_unpack_patch(u32 *params, const u8 *patches, const u16 *index, u32 id)
+{
+	const u8 *patch = patches + index[id];
+
+	// Parents come first, chains are a few deep.
+	if (patch[0])
+		sdram_unpack_patch(params, patches, index, patch[0]);
+
+	sdram_unpack(params, patch + 1);
+}
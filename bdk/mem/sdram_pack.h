@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SDRAM_PACK_H_
+#define _SDRAM_PACK_H_
+
+#include <utils/types.h>
+
+/*
+ * Packed SDRAM parameter tables, generated by tools/sdram from sdram_config.inl and
+ * sdram_config_t210b01.inl.
+ *
+ * A stream edits the u32 words of a parameter struct in order. Each op is one byte, with
+ * the type in bits 7:6 and a word count of 1 to 63 in bits 5:0. 0 ends the stream.
+ */
+#define SDRAM_PACK_SKIP   0x00 // Leave n words.
+#define SDRAM_PACK_BYTE   0x40 // n words, one byte each follows.
+#define SDRAM_PACK_WORD   0x80 // n words, four bytes each follows, little endian.
+#define SDRAM_PACK_REPEAT 0xC0 // n copies of the previous word.
+
+#define SDRAM_PACK_MAX_RUN 0x3F
+
+/*
+ * The base parameters are a stream over a zeroed struct. The patches of each DRAM id or code
+ * are a stream that starts with a byte for the id it applies on top of, 0 for the base.
+ * index holds the offset of each id's patch in patches. Ids without patches point to an empty
+ * patch.
+ */
+void sdram_unpack(u32 *params, const u8 *ops);
+void sdram_unpack_patch(u32 *params, const u8 *patches, const u16 *index, u32 id);
+
+#endif
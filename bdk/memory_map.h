@@ -52,6 +52,12 @@
 #define  RAM_DISK_SZ      0x41000000 // 1040MB.
 #define  RAM_DISK2_SZ 0x21000000 //  528MB.
 
+// Trace rings, above the heap. They share the RAM disk area, which the payload does not use.
+#define HEAP_TRACE_ADDR   0xA4000000 // Only with HEAP_TRACE.
+#define  HEAP_TRACE_SZ       SZ_8M
+#define IO_TRACE_ADDR     (HEAP_TRACE_ADDR + HEAP_TRACE_SZ) // Only with IO_TRACE.
+#define  IO_TRACE_SZ         SZ_8M
+
 // NX BIS driver sector cache.
 #define NX_BIS_CACHE_ADDR  0xC5000000
 #define  NX_BIS_CACHE_SZ   0x10020000 // 256MB.
@@ -40,7 +40,7 @@ enum
 
 extern sdmmc_t sd_sdmmc;
 extern sdmmc_storage_t sd_storage;
-extern FATFS sd_fs;
+extern FATFS *sd_fs;
 
 void sd_error_count_increment(u8 type);
 u16 *sd_get_error_count();
@@ -55,5 +55,7 @@ void sd_end();
 bool sd_is_gpt();
 void *sd_file_read(const char *path, u32 *fsize);
 int  sd_save_to_file(void *buf, u32 size, const char *filename);
+void sd_stage_begin();
+int  sd_stage_flush();
 
 #endif
\ No newline at end of file
@@ -29,6 +29,9 @@
 #define DPRINTF(...)
 
 u32 sd_power_cycle_time_start;
+u32 sdmmc_bounce_count; // Transfers copied through SDMMC_UPPER_BUFFER.
+
+static void _sdmmc_storage_async_drain(sdmmc_t *sdmmc);
 
 static inline u32 unstuff_bits(u32 *resp, u32 start, u32 size)
 {
@@ -193,24 +196,30 @@ int sdmmc_storage_vendor_sandisk_report(sdmmc_storage_t *storage, void *buf)
 	return 1;
 }
 
-static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+static void _sdmmc_storage_init_rw_cmd(sdmmc_storage_t *storage, sdmmc_cmd_t *cmdbuf, sdmmc_req_t *reqbuf,
+	u32 sector, u32 num_sectors, void *buf, u32 is_write)
 {
-	u32 tmp = 0;
-	sdmmc_cmd_t cmdbuf;
-	sdmmc_req_t reqbuf;
-
 	// If SDSC convert block address to byte address.
 	if (!storage->has_sector_access)
 		sector <<= 9;
 
-	sdmmc_init_cmd(&cmdbuf, is_write ? MMC_WRITE_MULTIPLE_BLOCK : MMC_READ_MULTIPLE_BLOCK, sector, SDMMC_RSP_TYPE_1, 0);
+	sdmmc_init_cmd(cmdbuf, is_write ? MMC_WRITE_MULTIPLE_BLOCK : MMC_READ_MULTIPLE_BLOCK, sector, SDMMC_RSP_TYPE_1, 0);
 
-	reqbuf.buf = buf;
-	reqbuf.num_sectors = num_sectors;
-	reqbuf.blksize = 512;
-	reqbuf.is_write = is_write;
-	reqbuf.is_multi_block = 1;
-	reqbuf.is_auto_stop_trn = 1;
+	reqbuf->buf = buf;
+	reqbuf->num_sectors = num_sectors;
+	reqbuf->blksize = 512;
+	reqbuf->is_write = is_write;
+	reqbuf->is_multi_block = 1;
+	reqbuf->is_auto_stop_trn = 1;
+}
+
+static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	u32 tmp = 0;
+	sdmmc_cmd_t cmdbuf;
+	sdmmc_req_t reqbuf;
+
+	_sdmmc_storage_init_rw_cmd(storage, &cmdbuf, &reqbuf, sector, num_sectors, buf, is_write);
 
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, blkcnt_out))
 	{
@@ -225,6 +234,9 @@ static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out
 
 int sdmmc_storage_end(sdmmc_storage_t *storage)
 {
+	// Queued transfers must finish before the controller goes down.
+	_sdmmc_storage_async_drain(storage->sdmmc);
+
 	if (!_sdmmc_storage_go_idle_state(storage))
 		return 0;
 
@@ -308,8 +320,138 @@ out:
 	return 1;
 }
 
+/*
+* Async request queue. Transfers run one at a time, in submission order.
+* Blocking calls only wait for the queued transfers of their own controller, so a
+* transfer on another one keeps going during them.
+*/
+
+static sdmmc_async_t *async_queue[SDMMC_ASYNC_QUEUE_SZ];
+static u32 async_head;
+static u32 async_cnt;
+
+static void _sdmmc_storage_async_process()
+{
+	while (async_cnt)
+	{
+		sdmmc_async_t *async = async_queue[async_head];
+		sdmmc_storage_t *storage = async->storage;
+		int res;
+
+		if (!async->started)
+		{
+			_sdmmc_storage_init_rw_cmd(storage, &async->cmd, &async->req,
+				async->sector, async->num_sectors, async->buf, async->is_write);
+
+			async->started = 1;
+			res = sdmmc_execute_cmd_async(storage->sdmmc, &async->cmd, &async->req);
+			if (res)
+				return;
+		}
+		else
+		{
+			res = sdmmc_poll_cmd_async(storage->sdmmc, NULL);
+			if (res == SDMMC_CMD_BUSY)
+				return;
+		}
+
+		// Dequeue before a retry. An SD reinit drains the queue and would wait on it.
+		async_head = (async_head + 1) % SDMMC_ASYNC_QUEUE_SZ;
+		async_cnt--;
+
+		if (!res)
+		{
+			u32 tmp = 0;
+			sdmmc_stop_transmission(storage->sdmmc, &tmp);
+			_sdmmc_storage_get_status(storage, &tmp, 0);
+
+			// Retry in blocking mode. That also reinits SD if needed.
+			res = _sdmmc_storage_readwrite(storage, async->sector, async->num_sectors, async->buf, async->is_write);
+		}
+
+		async->status = res ? SDMMC_ASYNC_DONE : SDMMC_ASYNC_FAILED;
+	}
+}
+
+// Finishes the queued transfers of a controller and the ones ahead of them.
+static void _sdmmc_storage_async_drain(sdmmc_t *sdmmc)
+{
+	sdmmc_async_t *last = NULL;
+	for (u32 i = 0; i < async_cnt; i++)
+	{
+		sdmmc_async_t *async = async_queue[(async_head + i) % SDMMC_ASYNC_QUEUE_SZ];
+		if (async->storage->sdmmc == sdmmc)
+			last = async;
+	}
+
+	if (last)
+	{
+		while (last->status == SDMMC_ASYNC_BUSY)
+			_sdmmc_storage_async_process();
+	}
+}
+
+static int _sdmmc_storage_readwrite_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	async->storage = storage;
+	async->sector = sector;
+	async->num_sectors = num_sectors;
+	async->buf = buf;
+	async->is_write = is_write;
+	async->started = 0;
+
+	// Transfers that need bouncing or more than one command are done in place.
+	if (!storage->initialized || ((u32)buf < DRAM_START) || ((u32)buf % 8) || num_sectors > 0xFFFF)
+	{
+		int res = is_write ? sdmmc_storage_write(storage, sector, num_sectors, buf) :
+							 sdmmc_storage_read(storage, sector, num_sectors, buf);
+		async->status = res ? SDMMC_ASYNC_DONE : SDMMC_ASYNC_FAILED;
+
+		return async->status;
+	}
+
+	// Make room if queue is full.
+	while (async_cnt == SDMMC_ASYNC_QUEUE_SZ)
+		_sdmmc_storage_async_process();
+
+	async->status = SDMMC_ASYNC_BUSY;
+	async_queue[(async_head + async_cnt) % SDMMC_ASYNC_QUEUE_SZ] = async;
+	async_cnt++;
+
+	_sdmmc_storage_async_process();
+
+	return async->status;
+}
+
+int sdmmc_storage_read_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf)
+{
+	return _sdmmc_storage_readwrite_async(storage, async, sector, num_sectors, buf, 0);
+}
+
+int sdmmc_storage_write_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf)
+{
+	return _sdmmc_storage_readwrite_async(storage, async, sector, num_sectors, buf, 1);
+}
+
+int sdmmc_storage_poll(sdmmc_async_t *async)
+{
+	_sdmmc_storage_async_process();
+
+	return async->status;
+}
+
+int sdmmc_storage_wait(sdmmc_async_t *async)
+{
+	while (async->status == SDMMC_ASYNC_BUSY)
+		_sdmmc_storage_async_process();
+
+	return async->status;
+}
+
 int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
 {
+	_sdmmc_storage_async_drain(storage->sdmmc);
+
 	// Ensure that buffer resides in DRAM and it's DMA aligned.
 	if (((u32)buf >= DRAM_START) && !((u32)buf % 8))
 		return _sdmmc_storage_readwrite(storage, sector, num_sectors, buf, 0);
@@ -317,6 +459,8 @@ int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, vo
 	if (num_sectors > (SDMMC_UP_BUF_SZ / 512))
 		return 0;
 
+	sdmmc_bounce_count++;
+
 	u8 *tmp_buf = (u8 *)SDMMC_UPPER_BUFFER;
 	if (_sdmmc_storage_readwrite(storage, sector, num_sectors, tmp_buf, 0))
 	{
@@ -328,6 +472,8 @@ int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, vo
 
 int sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
 {
+	_sdmmc_storage_async_drain(storage->sdmmc);
+
 	// Ensure that buffer resides in DRAM and it's DMA aligned.
 	if (((u32)buf >= DRAM_START) && !((u32)buf % 8))
 		return _sdmmc_storage_readwrite(storage, sector, num_sectors, buf, 1);
@@ -335,11 +481,68 @@ int sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, v
 	if (num_sectors > (SDMMC_UP_BUF_SZ / 512))
 		return 0;
 
+	sdmmc_bounce_count++;
+
 	u8 *tmp_buf = (u8 *)SDMMC_UPPER_BUFFER;
 	memcpy(tmp_buf, buf, 512 * num_sectors);
 	return _sdmmc_storage_readwrite(storage, sector, num_sectors, tmp_buf, 1);
 }
 
+/*
+ * Discards sectors that hold no data anymore.
+ * SD cards get an erase, which is per block. eMMC only gets a trim, since an
+ * erase there would wipe whole erase groups.
+ */
+int sdmmc_storage_erase(sdmmc_storage_t *storage, u32 sector, u32 num_sectors)
+{
+	u32 start_cmd, end_cmd, arg;
+
+	_sdmmc_storage_async_drain(storage->sdmmc);
+
+	if (!storage->initialized || !(storage->csd.cmdclass & CCC_ERASE))
+		return 0;
+
+	if (storage->sdmmc->id == SDMMC_1)
+	{
+		start_cmd = SD_ERASE_WR_BLK_START;
+		end_cmd = SD_ERASE_WR_BLK_END;
+		arg = MMC_ERASE_ARG;
+	}
+	else
+	{
+		if (!(storage->ext_csd.sec_feature & EXT_CSD_SEC_GB_CL_EN))
+			return 0;
+
+		start_cmd = MMC_ERASE_GROUP_START;
+		end_cmd = MMC_ERASE_GROUP_END;
+		arg = MMC_TRIM_ARG;
+	}
+
+	while (num_sectors)
+	{
+		u32 cnt = MIN(num_sectors, SDMMC_ERASE_MAX_SECTORS);
+		u32 start = sector;
+		u32 end = sector + cnt - 1;
+
+		// If SDSC convert block address to byte address.
+		if (!storage->has_sector_access)
+		{
+			start <<= 9;
+			end <<= 9;
+		}
+
+		if (!_sdmmc_storage_execute_cmd_type1(storage, start_cmd, start, 0, R1_STATE_TRAN) ||
+			!_sdmmc_storage_execute_cmd_type1(storage, end_cmd, end, 0, R1_STATE_TRAN) ||
+			!_sdmmc_storage_execute_cmd_type1(storage, MMC_ERASE, arg, 1, R1_STATE_TRAN))
+			return 0;
+
+		sector += cnt;
+		num_sectors -= cnt;
+	}
+
+	return 1;
+}
+
 /*
 * MMC specific functions.
 */
@@ -467,6 +670,7 @@ static void _mmc_storage_parse_ext_csd(sdmmc_storage_t *storage, u8 *buf)
 	storage->ext_csd.dev_version = *(u16 *)&buf[EXT_CSD_DEVICE_VERSION];
 	storage->ext_csd.boot_mult = buf[EXT_CSD_BOOT_MULT];
 	storage->ext_csd.rpmb_mult = buf[EXT_CSD_RPMB_MULT];
+	storage->ext_csd.sec_feature = buf[EXT_CSD_SEC_FEATURE_SUPPORT];
 	//storage->ext_csd.bkops = buf[EXT_CSD_BKOPS_SUPPORT];
 	//storage->ext_csd.bkops_en = buf[EXT_CSD_BKOPS_EN];
 	//storage->ext_csd.bkops_status = buf[EXT_CSD_BKOPS_STATUS];
@@ -485,6 +689,7 @@ static void _mmc_storage_parse_ext_csd(sdmmc_storage_t *storage, u8 *buf)
 		(buf[EXT_CSD_MAX_ENH_SIZE_MULT + 1] << 8)   |
 		(buf[EXT_CSD_MAX_ENH_SIZE_MULT + 2] << 16)) *
 		buf[EXT_CSD_HC_WP_GRP_SIZE] * buf[EXT_CSD_HC_ERASE_GRP_SIZE];
+	storage->csd.erase_size = buf[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024; // 512KB units.
 
 	storage->sec_cnt = *(u32 *)&buf[EXT_CSD_SEC_CNT];
 }
@@ -641,6 +846,8 @@ static int _mmc_storage_enable_bkops(sdmmc_storage_t *storage)
 
 int sdmmc_storage_init_mmc(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 bus_width, u32 type)
 {
+	_sdmmc_storage_async_drain(sdmmc);
+
 	memset(storage, 0, sizeof(sdmmc_storage_t));
 	storage->sdmmc = sdmmc;
 	storage->rca = 2; // Set default device address. This could be a config item.
@@ -720,6 +927,8 @@ DPRINTF("[MMC] successfully switched to HS mode\n");
 
 int sdmmc_storage_set_mmc_partition(sdmmc_storage_t *storage, u32 partition)
 {
+	_sdmmc_storage_async_drain(storage->sdmmc);
+
 	if (!_mmc_storage_switch(storage, SDMMC_SWITCH(MMC_SWITCH_MODE_WRITE_BYTE, EXT_CSD_PART_CONFIG, partition)))
 		return 0;
 
@@ -1332,6 +1541,8 @@ int sdmmc_storage_init_sd(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 bus_widt
 
 DPRINTF("[SD] init: bus: %d, type: %d\n", bus_width, type);
 
+	_sdmmc_storage_async_drain(sdmmc);
+
 	// Some cards (SanDisk U1), do not like a fast power cycle. Wait min 100ms.
 	sdmmc_storage_init_wait_sd();
 
@@ -1479,6 +1690,8 @@ int _gc_storage_custom_cmd(sdmmc_storage_t *storage, void *buf)
 
 int sdmmc_storage_init_gc(sdmmc_storage_t *storage, sdmmc_t *sdmmc)
 {
+	_sdmmc_storage_async_drain(sdmmc);
+
 	memset(storage, 0, sizeof(sdmmc_storage_t));
 	storage->sdmmc = sdmmc;
 
@@ -22,6 +22,7 @@
 #include <storage/sdmmc_driver.h>
 
 extern u32 sd_power_cycle_time_start;
+extern u32 sdmmc_bounce_count;
 
 typedef enum _sdmmc_type
 {
@@ -151,6 +152,7 @@ typedef struct _mmc_ext_csd
 	u8  dev_life_est_b;
 	u8  boot_mult;
 	u8  rpmb_mult;
+	u8  sec_feature;
 	u16 dev_version;
 	u32 cache_size;
 	u32 max_enh_mult;
@@ -197,9 +199,40 @@ typedef struct _sdmmc_storage_t
 	sd_ssr_t      ssr;
 } sdmmc_storage_t;
 
+#define SDMMC_ASYNC_QUEUE_SZ 4
+
+#define SDMMC_ERASE_MAX_SECTORS 0x4000 // 8MB per erase command, so it finishes before the busy timeout.
+
+/*! SDMMC async request status. */
+enum
+{
+	SDMMC_ASYNC_FAILED = 0,
+	SDMMC_ASYNC_DONE   = 1,
+	SDMMC_ASYNC_BUSY   = 2
+};
+
+/*! SDMMC async request. Buffer and request must not be touched while busy. */
+typedef struct _sdmmc_async_t
+{
+	sdmmc_storage_t *storage;
+	u32 sector;
+	u32 num_sectors;
+	void *buf;
+	u32 is_write;
+	int started;
+	int status;
+	sdmmc_cmd_t cmd;
+	sdmmc_req_t req;
+} sdmmc_async_t;
+
 int  sdmmc_storage_end(sdmmc_storage_t *storage);
 int  sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf);
 int  sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf);
+int  sdmmc_storage_erase(sdmmc_storage_t *storage, u32 sector, u32 num_sectors);
+int  sdmmc_storage_read_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf);
+int  sdmmc_storage_write_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf);
+int  sdmmc_storage_poll(sdmmc_async_t *async);
+int  sdmmc_storage_wait(sdmmc_async_t *async);
 int  sdmmc_storage_init_mmc(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 bus_width, u32 type);
 int  sdmmc_storage_set_mmc_partition(sdmmc_storage_t *storage, u32 partition);
 void sdmmc_storage_init_wait_sd();
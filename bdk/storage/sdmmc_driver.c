@@ -954,61 +954,84 @@ static int _sdmmc_config_dma(sdmmc_t *sdmmc, u32 *blkcnt_out, sdmmc_req_t *req)
 	return 1;
 }
 
-static int _sdmmc_update_dma(sdmmc_t *sdmmc)
+// Returns 1 when transfer is complete, 0 on error and SDMMC_CMD_BUSY if still in progress.
+static int _sdmmc_update_dma_poll(sdmmc_t *sdmmc)
 {
-	u16 blkcnt = 0;
-	do
+	int result = 0;
+	while (true)
 	{
-		blkcnt = sdmmc->regs->blkcnt;
-		u32 timeout = get_tmr_ms() + 1500;
-		do
+		u16 intr = 0;
+		result = _sdmmc_check_mask_interrupt(sdmmc, &intr,
+			SDHCI_INT_DATA_END | SDHCI_INT_DMA_END);
+		if (result < 0)
+			break;
+
+		if (intr & SDHCI_INT_DATA_END)
+			return 1; // Transfer complete.
+
+		if (intr & SDHCI_INT_DMA_END)
 		{
-			int result = 0;
-			while (true)
-			{
-				u16 intr = 0;
-				result = _sdmmc_check_mask_interrupt(sdmmc, &intr,
-					SDHCI_INT_DATA_END | SDHCI_INT_DMA_END);
-				if (result < 0)
-					break;
-
-				if (intr & SDHCI_INT_DATA_END)
-					return 1; // Transfer complete.
-
-				if (intr & SDHCI_INT_DMA_END)
-				{
-					// Update DMA.
-					sdmmc->regs->admaaddr = sdmmc->dma_addr_next;
-					sdmmc->regs->admaaddr_hi = 0;
-					sdmmc->dma_addr_next += 0x80000;
-				}
-			}
-			if (result != SDMMC_MASKINT_NOERROR)
-			{
+			// Update DMA.
+			sdmmc->regs->admaaddr = sdmmc->dma_addr_next;
+			sdmmc->regs->admaaddr_hi = 0;
+			sdmmc->dma_addr_next += 0x80000;
+		}
+	}
+	if (result != SDMMC_MASKINT_NOERROR)
+	{
 #ifdef ERROR_EXTRA_PRINTING
-				EPRINTFARGS("%08X!", result);
+		EPRINTFARGS("%08X!", result);
 #endif
-				_sdmmc_reset(sdmmc);
-				return 0;
-			}
-		} while (get_tmr_ms() < timeout);
-	} while (sdmmc->regs->blkcnt != blkcnt);
+		_sdmmc_reset(sdmmc);
+		return 0;
+	}
 
-	_sdmmc_reset(sdmmc);
-	return 0;
+	// Timeout if no block was transferred in 1.5s.
+	u16 blkcnt = sdmmc->regs->blkcnt;
+	if (blkcnt != sdmmc->dma_blkcnt)
+	{
+		sdmmc->dma_blkcnt = blkcnt;
+		sdmmc->dma_timeout = get_tmr_ms() + 1500;
+	}
+	else if (get_tmr_ms() >= sdmmc->dma_timeout)
+	{
+		_sdmmc_reset(sdmmc);
+		return 0;
+	}
+
+	return SDMMC_CMD_BUSY;
 }
 
-static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+static void _sdmmc_update_dma_init(sdmmc_t *sdmmc)
+{
+	sdmmc->dma_blkcnt = sdmmc->regs->blkcnt;
+	sdmmc->dma_timeout = get_tmr_ms() + 1500;
+}
+
+static int _sdmmc_update_dma(sdmmc_t *sdmmc)
+{
+	int result;
+
+	_sdmmc_update_dma_init(sdmmc);
+	do
+	{
+		result = _sdmmc_update_dma_poll(sdmmc);
+	} while (result == SDMMC_CMD_BUSY);
+
+	return result;
+}
+
+// Configures DMA, sends the command and gets its response.
+static int _sdmmc_execute_cmd_start(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt)
 {
 	int has_req_or_check_busy = req || cmd->check_busy;
 	if (!_sdmmc_wait_cmd_data_inhibit(sdmmc, has_req_or_check_busy))
 		return 0;
 
-	u32 blkcnt = 0;
 	bool is_data_present = false;
 	if (req)
 	{
-		if (!_sdmmc_config_dma(sdmmc, &blkcnt, req))
+		if (!_sdmmc_config_dma(sdmmc, blkcnt, req))
 		{
 #ifdef ERROR_EXTRA_PRINTING
 			EPRINTF("SDMMC: DMA Wrong cfg!");
@@ -1048,18 +1071,15 @@ DPRINTF("rsp(%d): %08X, %08X, %08X, %08X\n", result,
 #ifdef ERROR_EXTRA_PRINTING
 			if (!result)
 				EPRINTF("SDMMC: Unknown response type!");
-#endif
-		}
-		if (req && result)
-		{
-			result = _sdmmc_update_dma(sdmmc);
-#ifdef ERROR_EXTRA_PRINTING
-			if (!result)
-				EPRINTF("SDMMC: DMA Update failed!");
 #endif
 		}
 	}
 
+	return result;
+}
+
+static int _sdmmc_execute_cmd_finish(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, int result, u32 blkcnt, u32 *blkcnt_out)
+{
 	_sdmmc_mask_interrupts(sdmmc);
 
 	if (result)
@@ -1090,6 +1110,22 @@ DPRINTF("rsp(%d): %08X, %08X, %08X, %08X\n", result,
 	return result;
 }
 
+static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	u32 blkcnt = 0;
+	int result = _sdmmc_execute_cmd_start(sdmmc, cmd, req, &blkcnt);
+	if (req && result)
+	{
+		result = _sdmmc_update_dma(sdmmc);
+#ifdef ERROR_EXTRA_PRINTING
+		if (!result)
+			EPRINTF("SDMMC: DMA Update failed!");
+#endif
+	}
+
+	return _sdmmc_execute_cmd_finish(sdmmc, cmd, req, result, blkcnt, blkcnt_out);
+}
+
 bool sdmmc_get_sd_inserted()
 {
 	return (!gpio_read(GPIO_PORT_Z, GPIO_PIN_1));
@@ -1417,6 +1453,57 @@ int sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *b
 	return result;
 }
 
+static int _sdmmc_execute_cmd_async_end(sdmmc_t *sdmmc, int result, u32 *blkcnt_out)
+{
+	result = _sdmmc_execute_cmd_finish(sdmmc, sdmmc->async_cmd, sdmmc->async_req, result, sdmmc->async_blkcnt, blkcnt_out);
+	usleep((8000 + sdmmc->divisor - 1) / sdmmc->divisor);
+
+	if (sdmmc->async_disable_clock)
+		sdmmc->regs->clkcon &= ~SDHCI_CLOCK_CARD_EN;
+
+	return result;
+}
+
+int sdmmc_execute_cmd_async(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req)
+{
+	if (!sdmmc->card_clock_enabled || !req)
+		return 0;
+
+	// Recalibrate periodically for SDMMC1.
+	if (sdmmc->manual_cal && sdmmc->powersave_enabled)
+		_sdmmc_autocal_execute(sdmmc, sdmmc_get_io_power(sdmmc));
+
+	sdmmc->async_disable_clock = 0;
+	if (!(sdmmc->regs->clkcon & SDHCI_CLOCK_CARD_EN))
+	{
+		sdmmc->async_disable_clock = 1;
+		sdmmc->regs->clkcon |= SDHCI_CLOCK_CARD_EN;
+		_sdmmc_commit_changes(sdmmc);
+		usleep((8000 + sdmmc->divisor - 1) / sdmmc->divisor);
+	}
+
+	// Command and request must stay valid until the transfer ends.
+	sdmmc->async_cmd = cmd;
+	sdmmc->async_req = req;
+	sdmmc->async_blkcnt = 0;
+
+	if (!_sdmmc_execute_cmd_start(sdmmc, cmd, req, &sdmmc->async_blkcnt))
+		return _sdmmc_execute_cmd_async_end(sdmmc, 0, NULL);
+
+	_sdmmc_update_dma_init(sdmmc);
+
+	return 1;
+}
+
+int sdmmc_poll_cmd_async(sdmmc_t *sdmmc, u32 *blkcnt_out)
+{
+	int result = _sdmmc_update_dma_poll(sdmmc);
+	if (result == SDMMC_CMD_BUSY)
+		return SDMMC_CMD_BUSY;
+
+	return _sdmmc_execute_cmd_async_end(sdmmc, result, blkcnt_out);
+}
+
 int sdmmc_enable_low_voltage(sdmmc_t *sdmmc)
 {
 	if(sdmmc->id != SDMMC_1)
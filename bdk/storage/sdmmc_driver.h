@@ -50,6 +50,9 @@
 #define SDMMC_MASKINT_NOERROR -1
 #define SDMMC_MASKINT_ERROR   -2
 
+/*! SDMMC async command still in progress. */
+#define SDMMC_CMD_BUSY 2
+
 /*! SDMMC present state. */
 #define SDHCI_CMD_INHIBIT      0x1
 #define SDHCI_DATA_INHIBIT     0x2
@@ -220,9 +223,15 @@ typedef struct _sdmmc_t
 	u32 venclkctl_tap;
 	u32 expected_rsp_type;
 	u32 dma_addr_next;
+	u32 dma_blkcnt;
+	u32 dma_timeout;
 	u32 rsp[4];
 	u32 rsp3;
 	int t210b01;
+	int async_disable_clock;
+	u32 async_blkcnt;
+	struct _sdmmc_cmd_t *async_cmd;
+	struct _sdmmc_req_t *async_req;
 } sdmmc_t;
 
 /*! SDMMC command. */
@@ -259,6 +268,8 @@ int  sdmmc_init(sdmmc_t *sdmmc, u32 id, u32 power, u32 bus_width, u32 type, int
 void sdmmc_end(sdmmc_t *sdmmc);
 void sdmmc_init_cmd(sdmmc_cmd_t *cmdbuf, u16 cmd, u32 arg, u32 rsp_type, u32 check_busy);
 int  sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out);
+int  sdmmc_execute_cmd_async(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req);
+int  sdmmc_poll_cmd_async(sdmmc_t *sdmmc, u32 *blkcnt_out);
 int  sdmmc_enable_low_voltage(sdmmc_t *sdmmc);
 
 #endif
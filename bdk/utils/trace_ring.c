@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace_ring.h"
+#include <libs/fatfs/ff.h>
+
+int trace_ring_save(const char *path, void *hdr, u32 hdr_size, const void *entries)
+{
+	FIL fp;
+	u32 bw;
+	trace_ring_hdr_t *ring = (trace_ring_hdr_t *)hdr;
+
+	int res = f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res)
+		return res;
+
+	// Oldest entries start at head, if the ring buffer wrapped.
+	u32 start = 0;
+	ring->entries = ring->count;
+	if (ring->count > ring->capacity)
+	{
+		ring->entries = ring->capacity;
+		start = ring->head;
+	}
+
+	res = f_write(&fp, hdr, hdr_size, &bw);
+	if (!res)
+		res = f_write(&fp, (const u8 *)entries + start * ring->entry_size, (ring->entries - start) * ring->entry_size, &bw);
+	if (!res && start)
+		res = f_write(&fp, entries, start * ring->entry_size, &bw);
+
+	f_close(&fp);
+
+	return res;
+}
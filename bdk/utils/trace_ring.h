@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TRACE_RING_H_
+#define _TRACE_RING_H_
+
+#include <utils/types.h>
+
+// Common start of the heap and I/O trace headers. Entries follow the header in memory.
+typedef struct _trace_ring_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 entry_size;
+	u32 entries;
+	u32 count;
+	u32 capacity;
+	u32 head;
+} trace_ring_hdr_t;
+
+/*
+ * Writes hdr and the entries in chronological order, and sets hdr->entries.
+ * hdr is a snapshot of the ring header, taken before anything that gets traced.
+ */
+int trace_ring_save(const char *path, void *hdr, u32 hdr_size, const void *entries);
+
+#endif
@@ -21,14 +21,16 @@
 #include "payload_01.h"
 
 #include <memory_map.h>
-#include <libs/compr/lz.h>
+#include <libs/compr/lzrev.h>
 #include <soc/clock.h>
 #include <soc/t210.h>
 
-// 0x4003D000: Safe for panic preserving, 0x40038000: Safe for debugging needs.
-#define IPL_RELOC_TOP  0x40038000
 #define IPL_PATCHED_RELOC_SZ 0x94
 
+// Uncompressed part sizes, from the layout lz77 -i generates. link.ld checks it.
+extern u8 __payload_00_size[];
+extern u8 __payload_01_size[];
+
 boot_cfg_t __attribute__((section ("._boot_cfg"))) b_cfg;
 const volatile ipl_ver_meta_t __attribute__((section ("._ipl_version"))) ipl_ver = {
 	.magic = LP_MAGIC,
@@ -37,6 +39,16 @@ const volatile ipl_ver_meta_t __attribute__((section ("._ipl_version"))) ipl_ver
 	.rsvd1 = 0
 };
 
+// Parts are packed back to front, so they decode downwards from dst_end in place.
+static void _payload_uncompress(const u8 *src, u32 size, u8 *dst_end)
+{
+#ifdef PAYLOAD_LZ4
+	lz4_uncompress_rev(src, size, dst_end);
+#else
+	lz_uncompress_rev(src, size, dst_end);
+#endif
+}
+
 void loader_main()
 {
 	// Preliminary BPMP clocks init.
@@ -47,32 +59,11 @@ void loader_main()
 	CLOCK(CLK_RST_CONTROLLER_CLK_SYSTEM_RATE) = 2;             // Set HCLK div to 1 and PCLK div to 3.
 	CLOCK(CLK_RST_CONTROLLER_SCLK_BURST_POLICY) = 0x20003333;  // Set SCLK to PLLP_OUT (408MHz).
 
-	// Get Loader and Payload size.
-	u32 payload_size = sizeof(payload_00) + sizeof(payload_01);             // Actual payload size.
-	payload_size += (u32)payload_01 - (u32)payload_00 - sizeof(payload_00); // Add array alignment.
-	u32 *payload_addr = (u32 *)payload_00;
-
-	// Relocate payload to a safer place.
-	u32 bytes = ALIGN(payload_size, 4) >> 2;
-	u32 *addr = payload_addr + bytes - 1;
-	u32 *dst = (u32 *)(IPL_RELOC_TOP - 4);
-	while (bytes)
-	{
-		*dst = *addr;
-		dst--;
-		addr--;
-		bytes--;
-	}
-
-	// Set source address of the first part.
-	u8 *src_addr = (void *)(IPL_RELOC_TOP - ALIGN(payload_size, 4));
-	// Uncompress first part.
-	u32 dst_pos = LZ_Uncompress((const u8 *)src_addr, (u8*)IPL_LOAD_ADDR, sizeof(payload_00));
-
-	// Set source address of the second part. Includes array alignment.
-	src_addr += (u32)payload_01 - (u32)payload_00;
-	// Uncompress second part.
-	LZ_Uncompress((const u8 *)src_addr, (u8*)IPL_LOAD_ADDR + dst_pos, sizeof(payload_01));
+	// Uncompress the parts from where they were loaded, without relocating them first.
+	// Second part goes first, since its output ends above all packed data.
+	u8 *dst_end = (u8 *)IPL_LOAD_ADDR + (u32)__payload_00_size + (u32)__payload_01_size;
+	_payload_uncompress(payload_01, sizeof(payload_01), dst_end);
+	_payload_uncompress(payload_00, sizeof(payload_00), (u8 *)IPL_LOAD_ADDR + (u32)__payload_00_size);
 
 	// Copy over boot configuration storage.
 	memcpy((u8 *)(IPL_LOAD_ADDR + IPL_PATCHED_RELOC_SZ), &b_cfg, sizeof(boot_cfg_t));
@@ -81,9 +81,6 @@ int save_fb_to_bmp()
 
 	sd_mount();
 
-	f_mkdir("sd:/switch");
-	f_mkdir("sd:/switch/screenshot");
-
 	// Generate unique filename with RTC timestamp
 	rtc_time_t time;
 	max77620_rtc_get_time(&time);
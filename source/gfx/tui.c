@@ -165,10 +165,6 @@ void *tui_do_menu(menu_t *menu)
 		// Check for VOL+ and VOL- pressed together for screenshot
 		if (btn == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
-			// Create screenshot directory if it doesn't exist
-			f_mkdir("sd:/switch");
-			f_mkdir("sd:/switch/screenshot");
-
 			int save_fb_to_bmp();
 			int res = save_fb_to_bmp();
 			u32 cx, cy;
@@ -26,10 +26,401 @@
 #include <string.h>
 
 #include <libs/fatfs/diskio.h>	/* FatFs lower layer API */
+#include <mem/dma_pool.h>
+#include <mem/heap.h>
 #include <memory_map.h>
 #include <storage/nx_sd.h>
+#include "../../storage/io_trace.h"
 #include "../../storage/nx_emmc_bis.h"
 #include <storage/sdmmc.h>
+#include <utils/util.h>
+
+/*-----------------------------------------------------------------------*/
+/* SD sector cache                                                       */
+/*-----------------------------------------------------------------------*/
+/*
+ * Write-back LRU cache for the SD drive. FatFs has a single sector window
+ * per volume, so FAT and directory sectors get re-read on every path lookup.
+ * Small transfers go through the cache, larger ones (file data) bypass it.
+ * Dirty sectors are written back on eviction and on CTRL_SYNC.
+ */
+#ifndef SD_CACHE_SECTORS
+#define SD_CACHE_SECTORS  256 // 128KB. 0 disables the cache.
+#endif
+#define SD_CACHE_MAX_XFER 1   // Larger transfers (file data) bypass the cache.
+#define SD_CACHE_HASH_SZ  64
+
+#if SD_CACHE_SECTORS
+
+typedef struct _sd_cache_entry_t
+{
+	u32 sector;
+	u8  valid;
+	u8  dirty;
+	s16 prev;
+	s16 next;
+	s16 hnext;
+} sd_cache_entry_t;
+
+typedef struct _sd_cache_t
+{
+	u8  data[SD_CACHE_SECTORS][512]; // First, so it's DMA aligned.
+	sd_cache_entry_t entries[SD_CACHE_SECTORS];
+	s16 hash[SD_CACHE_HASH_SZ];
+	s16 lru_head; // Most recently used.
+	s16 lru_tail;
+	disk_cache_stats_t stats;
+} sd_cache_t;
+
+static sd_cache_t *sd_cache;
+
+#define SD_CACHE_HASH(sector) ((sector) % SD_CACHE_HASH_SZ)
+
+static void _sd_cache_lru_unlink(s16 idx)
+{
+	sd_cache_entry_t *entry = &sd_cache->entries[idx];
+
+	if (entry->prev >= 0)
+		sd_cache->entries[entry->prev].next = entry->next;
+	else
+		sd_cache->lru_head = entry->next;
+
+	if (entry->next >= 0)
+		sd_cache->entries[entry->next].prev = entry->prev;
+	else
+		sd_cache->lru_tail = entry->prev;
+}
+
+static void _sd_cache_lru_push(s16 idx)
+{
+	sd_cache_entry_t *entry = &sd_cache->entries[idx];
+
+	entry->prev = -1;
+	entry->next = sd_cache->lru_head;
+	if (sd_cache->lru_head >= 0)
+		sd_cache->entries[sd_cache->lru_head].prev = idx;
+	sd_cache->lru_head = idx;
+	if (sd_cache->lru_tail < 0)
+		sd_cache->lru_tail = idx;
+}
+
+static void _sd_cache_touch(s16 idx)
+{
+	if (sd_cache->lru_head == idx)
+		return;
+
+	_sd_cache_lru_unlink(idx);
+	_sd_cache_lru_push(idx);
+}
+
+static void _sd_cache_clear()
+{
+	memset(sd_cache->entries, 0, sizeof(sd_cache->entries));
+	memset(sd_cache->hash, 0xFF, sizeof(sd_cache->hash));
+
+	sd_cache->lru_head = -1;
+	sd_cache->lru_tail = -1;
+	for (s16 i = 0; i < SD_CACHE_SECTORS; i++)
+		_sd_cache_lru_push(i);
+}
+
+static bool _sd_cache_init()
+{
+	if (sd_cache)
+		return true;
+
+	sd_cache = (sd_cache_t *)malloc(sizeof(sd_cache_t));
+	if (!sd_cache)
+		return false;
+
+	memset(&sd_cache->stats, 0, sizeof(disk_cache_stats_t));
+	_sd_cache_clear();
+
+	return true;
+}
+
+static s16 _sd_cache_find(u32 sector)
+{
+	s16 idx = sd_cache->hash[SD_CACHE_HASH(sector)];
+
+	while (idx >= 0 && sd_cache->entries[idx].sector != sector)
+		idx = sd_cache->entries[idx].hnext;
+
+	return idx;
+}
+
+static void _sd_cache_hash_remove(s16 idx)
+{
+	s16 *link = &sd_cache->hash[SD_CACHE_HASH(sd_cache->entries[idx].sector)];
+
+	while (*link != idx)
+		link = &sd_cache->entries[*link].hnext;
+	*link = sd_cache->entries[idx].hnext;
+}
+
+// Gets the least recently used entry and assigns it to sector. Writes back its old contents if dirty.
+static s16 _sd_cache_alloc(u32 sector)
+{
+	s16 idx = sd_cache->lru_tail;
+	sd_cache_entry_t *entry = &sd_cache->entries[idx];
+
+	if (entry->valid)
+	{
+		if (entry->dirty)
+		{
+			if (!sdmmc_storage_write(&sd_storage, entry->sector, 1, sd_cache->data[idx]))
+				return -1;
+			sd_cache->stats.writebacks++;
+		}
+		_sd_cache_hash_remove(idx);
+	}
+
+	u32 hash = SD_CACHE_HASH(sector);
+	entry->sector = sector;
+	entry->valid = 1;
+	entry->dirty = 0;
+	entry->hnext = sd_cache->hash[hash];
+	sd_cache->hash[hash] = idx;
+
+	return idx;
+}
+
+static DRESULT _sd_cache_read(BYTE *buff, u32 sector, u32 count)
+{
+	u32 miss_start = 0;
+	u32 miss_cnt = 0;
+
+	for (u32 i = 0; i <= count; i++)
+	{
+		s16 idx = i < count ? _sd_cache_find(sector + i) : -1;
+		if (idx >= 0)
+		{
+			sd_cache->stats.hits++;
+			memcpy(buff + i * 512, sd_cache->data[idx], 512);
+			_sd_cache_touch(idx);
+		}
+		else if (i < count)
+		{
+			sd_cache->stats.misses++;
+			if (!miss_cnt)
+				miss_start = i;
+			miss_cnt++;
+			continue;
+		}
+
+		// Read a run of missed sectors in one go and insert them.
+		if (!miss_cnt)
+			continue;
+
+		if (!sdmmc_storage_read(&sd_storage, sector + miss_start, miss_cnt, buff + miss_start * 512))
+			return RES_ERROR;
+
+		for (u32 j = miss_start; j < miss_start + miss_cnt; j++)
+		{
+			s16 new_idx = _sd_cache_alloc(sector + j);
+			if (new_idx < 0)
+				return RES_ERROR;
+			memcpy(sd_cache->data[new_idx], buff + j * 512, 512);
+			_sd_cache_touch(new_idx);
+		}
+		miss_cnt = 0;
+	}
+
+	return RES_OK;
+}
+
+static DRESULT _sd_cache_write(const BYTE *buff, u32 sector, u32 count)
+{
+	for (u32 i = 0; i < count; i++)
+	{
+		s16 idx = _sd_cache_find(sector + i);
+		if (idx >= 0)
+			sd_cache->stats.hits++;
+		else
+		{
+			sd_cache->stats.misses++;
+			idx = _sd_cache_alloc(sector + i);
+			if (idx < 0)
+				return RES_ERROR;
+		}
+
+		memcpy(sd_cache->data[idx], buff + i * 512, 512);
+		sd_cache->entries[idx].dirty = 1;
+		_sd_cache_touch(idx);
+	}
+
+	return RES_OK;
+}
+
+// Keeps cached sectors coherent with a transfer that went around the cache.
+static void _sd_cache_bypass(BYTE *buff, u32 sector, u32 count, bool write)
+{
+	for (s16 idx = 0; idx < SD_CACHE_SECTORS; idx++)
+	{
+		sd_cache_entry_t *entry = &sd_cache->entries[idx];
+		if (!entry->valid || entry->sector < sector || entry->sector >= sector + count)
+			continue;
+
+		BYTE *sector_buf = buff + (entry->sector - sector) * 512;
+		if (write)
+		{
+			memcpy(sd_cache->data[idx], sector_buf, 512);
+			entry->dirty = 0;
+		}
+		else if (entry->dirty)
+			memcpy(sector_buf, sd_cache->data[idx], 512);
+	}
+}
+
+static DRESULT _sd_cache_flush()
+{
+	s16 dirty[SD_CACHE_SECTORS];
+	u32 dirty_cnt = 0;
+
+	if (!sd_cache)
+		return RES_OK;
+
+	// Sort dirty sectors, so contiguous ones are written with one command.
+	for (s16 idx = 0; idx < SD_CACHE_SECTORS; idx++)
+	{
+		if (!sd_cache->entries[idx].valid || !sd_cache->entries[idx].dirty)
+			continue;
+
+		u32 pos = dirty_cnt++;
+		u32 sector = sd_cache->entries[idx].sector;
+		while (pos && sd_cache->entries[dirty[pos - 1]].sector > sector)
+		{
+			dirty[pos] = dirty[pos - 1];
+			pos--;
+		}
+		dirty[pos] = idx;
+	}
+
+	if (!dirty_cnt)
+		return RES_OK;
+
+	u8 *buf = (u8 *)dma_pool_alloc();
+	const u32 buf_sectors = DMA_POOL_BUF_SZ / 512;
+	DRESULT res = RES_OK;
+
+	for (u32 i = 0; i < dirty_cnt;)
+	{
+		u32 start = sd_cache->entries[dirty[i]].sector;
+		u32 run = 0;
+		while (i + run < dirty_cnt && run < buf_sectors && sd_cache->entries[dirty[i + run]].sector == start + run)
+		{
+			memcpy(buf + run * 512, sd_cache->data[dirty[i + run]], 512);
+			run++;
+		}
+
+		if (!sdmmc_storage_write(&sd_storage, start, run, buf))
+		{
+			res = RES_ERROR;
+			break;
+		}
+
+		for (u32 j = i; j < i + run; j++)
+			sd_cache->entries[dirty[j]].dirty = 0;
+		sd_cache->stats.writebacks += run;
+		i += run;
+	}
+
+	dma_pool_free(buf);
+
+	return res;
+}
+
+// Drops pending writes of discarded sectors.
+static void _sd_cache_trim(u32 sector, u32 count)
+{
+	for (s16 idx = 0; idx < SD_CACHE_SECTORS; idx++)
+	{
+		sd_cache_entry_t *entry = &sd_cache->entries[idx];
+		if (entry->valid && entry->sector >= sector && entry->sector < sector + count)
+			entry->dirty = 0;
+	}
+}
+
+static DRESULT _sd_read(BYTE *buff, u32 sector, u32 count)
+{
+	if (count <= SD_CACHE_MAX_XFER && _sd_cache_init())
+		return _sd_cache_read(buff, sector, count);
+
+	if (!sdmmc_storage_read(&sd_storage, sector, count, buff))
+		return RES_ERROR;
+
+	if (sd_cache)
+		_sd_cache_bypass(buff, sector, count, false);
+
+	return RES_OK;
+}
+
+static DRESULT _sd_write(const BYTE *buff, u32 sector, u32 count)
+{
+	if (count <= SD_CACHE_MAX_XFER && _sd_cache_init())
+		return _sd_cache_write(buff, sector, count);
+
+	if (!sdmmc_storage_write(&sd_storage, sector, count, (void *)buff))
+		return RES_ERROR;
+
+	if (sd_cache)
+		_sd_cache_bypass((BYTE *)buff, sector, count, true);
+
+	return RES_OK;
+}
+
+static DRESULT _sd_trim(u32 sector, u32 count)
+{
+	if (sd_cache)
+		_sd_cache_trim(sector, count);
+
+	return sdmmc_storage_erase(&sd_storage, sector, count) ? RES_OK : RES_ERROR;
+}
+
+void disk_sd_cache_reset()
+{
+	if (!sd_cache)
+		return;
+
+	_sd_cache_flush();
+	_sd_cache_clear();
+}
+
+void disk_sd_cache_stats(disk_cache_stats_t *stats)
+{
+	if (sd_cache)
+		memcpy(stats, &sd_cache->stats, sizeof(disk_cache_stats_t));
+	else
+		memset(stats, 0, sizeof(disk_cache_stats_t));
+}
+
+#else
+
+static DRESULT _sd_read(BYTE *buff, u32 sector, u32 count)
+{
+	return sdmmc_storage_read(&sd_storage, sector, count, buff) ? RES_OK : RES_ERROR;
+}
+
+static DRESULT _sd_write(const BYTE *buff, u32 sector, u32 count)
+{
+	return sdmmc_storage_write(&sd_storage, sector, count, (void *)buff) ? RES_OK : RES_ERROR;
+}
+
+static DRESULT _sd_trim(u32 sector, u32 count)
+{
+	return sdmmc_storage_erase(&sd_storage, sector, count) ? RES_OK : RES_ERROR;
+}
+
+static DRESULT _sd_cache_flush() { return RES_OK; }
+
+void disk_sd_cache_reset() {}
+
+void disk_sd_cache_stats(disk_cache_stats_t *stats)
+{
+	memset(stats, 0, sizeof(disk_cache_stats_t));
+}
+
+#endif
 
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
@@ -54,17 +445,12 @@ DSTATUS disk_initialize (
 /*-----------------------------------------------------------------------*/
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
-DRESULT disk_read (
-	BYTE pdrv,		/* Physical drive number to identify the drive */
-	BYTE *buff,		/* Data buffer to store read data */
-	DWORD sector,	/* Start sector in LBA */
-	UINT count		/* Number of sectors to read */
-)
+static DRESULT _disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
 {
 	switch (pdrv)
 	{
 	case DRIVE_SD:
-		return sdmmc_storage_read(&sd_storage, sector, count, buff) ? RES_OK : RES_ERROR;
+		return _sd_read(buff, sector, count);
 
 	case DRIVE_BIS:
 		return nx_emmc_bis_read(sector, count, buff);
@@ -73,20 +459,33 @@ DRESULT disk_read (
 	return RES_ERROR;
 }
 
+DRESULT disk_read (
+	BYTE pdrv,		/* Physical drive number to identify the drive */
+	BYTE *buff,		/* Data buffer to store read data */
+	DWORD sector,	/* Start sector in LBA */
+	UINT count		/* Number of sectors to read */
+)
+{
+#ifdef IO_TRACE
+	u32 start = get_tmr_us();
+	DRESULT res = _disk_read(pdrv, buff, sector, count);
+	io_trace_record(pdrv, IO_TRACE_READ, sector, count, start, res);
+
+	return res;
+#else
+	return _disk_read(pdrv, buff, sector, count);
+#endif
+}
+
 /*-----------------------------------------------------------------------*/
 /* Write Sector(s)                                                       */
 /*-----------------------------------------------------------------------*/
-DRESULT disk_write (
-	BYTE pdrv,			/* Physical drive number to identify the drive */
-	const BYTE *buff,	/* Data to be written */
-	DWORD sector,		/* Start sector in LBA */
-	UINT count			/* Number of sectors to write */
-)
+static DRESULT _disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
 {
 	switch (pdrv)
 	{
 	case DRIVE_SD:
-		return sdmmc_storage_write(&sd_storage, sector, count, (void *)buff) ? RES_OK : RES_ERROR;
+		return _sd_write(buff, sector, count);
 
 	case DRIVE_BIS:
 		return nx_emmc_bis_write(sector, count, (void *)buff);
@@ -95,6 +494,24 @@ DRESULT disk_write (
 	return RES_ERROR;
 }
 
+DRESULT disk_write (
+	BYTE pdrv,			/* Physical drive number to identify the drive */
+	const BYTE *buff,	/* Data to be written */
+	DWORD sector,		/* Start sector in LBA */
+	UINT count			/* Number of sectors to write */
+)
+{
+#ifdef IO_TRACE
+	u32 start = get_tmr_us();
+	DRESULT res = _disk_write(pdrv, buff, sector, count);
+	io_trace_record(pdrv, IO_TRACE_WRITE, sector, count, start, res);
+
+	return res;
+#else
+	return _disk_write(pdrv, buff, sector, count);
+#endif
+}
+
 /*-----------------------------------------------------------------------*/
 /* Miscellaneous Functions                                               */
 /*-----------------------------------------------------------------------*/
@@ -104,5 +521,52 @@ DRESULT disk_ioctl (
 	void *buff		/* Buffer to send/receive control data */
 )
 {
+	DWORD *buf = (DWORD *)buff;
+
+	switch (pdrv)
+	{
+	case DRIVE_SD:
+		switch (cmd)
+		{
+		case CTRL_SYNC:
+			return _sd_cache_flush();
+
+		case GET_SECTOR_COUNT:
+			*buf = sd_storage.sec_cnt;
+			break;
+
+		case GET_BLOCK_SIZE:
+			// Erase block is the allocation unit. SSR reports it in KB.
+			*buf = sd_storage_get_ssr_au(&sd_storage) * 2;
+			if (!*buf)
+				*buf = 1; // Unknown.
+			break;
+
+		case CTRL_TRIM:
+			return _sd_trim(buf[0], buf[1] - buf[0] + 1);
+		}
+		break;
+
+	case DRIVE_BIS:
+		switch (cmd)
+		{
+		case CTRL_SYNC:
+			nx_emmc_bis_finalize();
+			break;
+
+		case GET_SECTOR_COUNT:
+			*buf = nx_emmc_bis_get_sector_count();
+			break;
+
+		case GET_BLOCK_SIZE:
+			*buf = emmc_storage.csd.erase_size ? emmc_storage.csd.erase_size : 1;
+			break;
+
+		case CTRL_TRIM:
+			return nx_emmc_bis_trim(buf[0], buf[1] - buf[0] + 1) ? RES_ERROR : RES_OK;
+		}
+		break;
+	}
+
 	return RES_OK;
 }
@@ -51,7 +51,7 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND	0
+#define FF_USE_EXPAND	1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -155,6 +155,18 @@
 */
 
 
+#define FF_UPCASE_TBL	2
+/* This option selects how ff_wtoupper() up-converts characters, which is done on
+/  every character of LFN matching and f_findfirst()/f_findnext() pattern matching.
+/
+/   0: Search the compressed conversion tables. (smallest)
+/   1: 0 plus a fast path for ASCII.
+/   2: ASCII fast path and page tables. About 1.5 KiB of tables, 0.8 KiB more than
+/      the compressed ones, but a character takes four loads.
+/
+/  When LFN is not enabled, this option has no effect. */
+
+
 #define FF_FS_RPATH		0
 /* This option configures support for relative path.
 /
@@ -206,7 +218,7 @@
 /  GET_SECTOR_SIZE command. */
 
 
-#define FF_USE_TRIM		0
+#define FF_USE_TRIM		1
 /* This option switches support for ATA-TRIM. (0:Disable or 1:Enable)
 /  To enable Trim function, also CTRL_TRIM command should be implemented to the
 /  disk_ioctl() function. */
@@ -268,6 +280,17 @@
 /      lock control is independent of re-entrancy. */
 
 
+#define FF_DIR_INDEX	4
+/* The option FF_DIR_INDEX switches the directory name index. A directory looked up
+/  twice gets a hash table of its names in the heap, so later lookups compare only the
+/  entries with a matching hash instead of scanning the whole directory.
+/
+/  0:  Disable directory name index.
+/  >0: Enable directory name index. The value defines how many directories are
+/      indexed at a time. The least recently used index is replaced.
+/      FF_USE_LFN must be 3. */
+
+
 /* #include <somertos.h>	// O/S definitions */
 #define FF_FS_REENTRANT	0
 #define FF_FS_TIMEOUT	1000
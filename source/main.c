@@ -22,6 +22,7 @@
 #include <soc/hw_init.h>
 #include <soc/t210.h>
 #include "storage/emummc.h"
+#include "storage/io_trace.h"
 #include "storage/nx_emmc.h"
 #include <storage/nx_sd.h>
 #include <storage/sdmmc.h>
@@ -193,6 +194,43 @@ void print_info(int x, int y, const char *label, const char *value) {
     RESETCOLOR;
 }
 
+#ifdef BOOT_BACKUP
+// Throughput in MB/s
+static u32 _backup_mbps(u32 bytes, u32 us) {
+    return us ? bytes / us : 0;
+}
+
+// Print BOOT0/BOOT1 backup result and per stage throughput, returns next line
+int print_backup(int x, int y, const warmboot_info_t *wb_info) {
+    char temp[128];
+    const boot_backup_stats_t *st = &wb_info->backup;
+
+    // Not run, extraction failed before it
+    if (wb_info->backup_res < 0)
+        return y;
+
+    if (wb_info->backup_res) {
+        s_printf(temp, "BOOT0/BOOT1 backup failed (FatFs error %d)", wb_info->backup_res);
+        print_status(x, y, temp, COLOR_ORANGE);
+        return y + 32;
+    }
+
+    s_printf(temp, "BOOT0/BOOT1 backed up to " BOOT_BACKUP_DIR " (%d KB -> %d KB)",
+             st->bytes / 1024, st->packed / 1024);
+    print_status(x, y, temp, COLOR_GREEN);
+    y += 32;
+
+    s_printf(temp, "read %d, hash %d, pack %d, total %d MB/s (%d ms read wait)",
+             _backup_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_READ]),
+             _backup_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_HASH]),
+             _backup_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_PACK]),
+             _backup_mbps(st->bytes, st->total_us), st->read_wait_us / 1000);
+    print_info(x, y, "Backup", temp);
+
+    return y + 32;
+}
+#endif
+
 // Main extraction workflow
 void warmboot_extraction_workflow(void) {
     warmboot_info_t wb_info;
@@ -201,6 +239,11 @@ void warmboot_extraction_workflow(void) {
 
     print_header();
 
+#ifdef BOOT_BACKUP
+    // Backup manifest and warmboot are kept in RAM and written to SD together
+    sd_stage_begin();
+#endif
+
     // Display system information
     int y_pos = 148;
     SETCOLOR(COLOR_CYAN, COLOR_DEFAULT);
@@ -221,12 +264,17 @@ void warmboot_extraction_workflow(void) {
 
     y_pos += 48;
 
+    u32 flags = 0;
+#ifdef BOOT_BACKUP
+    flags |= WB_EXTRACT_BACKUP_BOOT;
+#endif
+
     // Extract warmboot (Mariko only - Erista uses embedded warmboot)
     if (mariko) {
         print_status(251, y_pos, "Extracting warmboot firmware from Package1...", COLOR_WHITE);
         y_pos += 32;
 
-        wb_extract_error_t err = extract_warmboot_from_pkg1_ex(&wb_info);
+        wb_extract_error_t err = extract_warmboot_from_pkg1_ex(&wb_info, flags);
         if (err != WB_SUCCESS) {
             print_status(251, y_pos, "Failed to extract warmboot!", COLOR_RED);
             y_pos += 32;
@@ -245,7 +293,12 @@ void warmboot_extraction_workflow(void) {
             SETCOLOR(COLOR_ORANGE, COLOR_DEFAULT);
             gfx_printf("%s", wb_error_to_string(err));
             RESETCOLOR;
-            y_pos += 48;
+            y_pos += 32;
+#ifdef BOOT_BACKUP
+            // Backup runs before Package1 is decrypted, so it may be done
+            y_pos = print_backup(251, y_pos, &wb_info);
+#endif
+            y_pos += 16;
 
             goto wait_exit;
         }
@@ -254,11 +307,21 @@ void warmboot_extraction_workflow(void) {
         print_status(251, y_pos, "Erista detected - warmboot is embedded in Atmosphere", COLOR_WHITE);
         y_pos += 32;
         print_status(251, y_pos, "No extraction needed for Erista consoles", COLOR_CYAN);
+        y_pos += 32;
+#ifdef BOOT_BACKUP
+        // Only backs up BOOT0/BOOT1 on Erista
+        extract_warmboot_from_pkg1_ex(&wb_info, flags);
+        y_pos = print_backup(251, y_pos, &wb_info);
+#endif
         goto wait_exit;
     }
 
     print_status(251, y_pos, "Warmboot extracted successfully!", COLOR_GREEN);
-    y_pos += 48;
+    y_pos += 32;
+#ifdef BOOT_BACKUP
+    y_pos = print_backup(251, y_pos, &wb_info);
+#endif
+    y_pos += 16;
 
     // Display warmboot information
     SETCOLOR(COLOR_CYAN, COLOR_DEFAULT);
@@ -318,6 +381,12 @@ void warmboot_extraction_workflow(void) {
         goto cleanup_exit;
     }
 
+    // Staged files are only on SD after the flush
+    if (sd_stage_flush()) {
+        print_status(251, y_pos, "Failed to write files to SD card!", COLOR_RED);
+        goto cleanup_exit;
+    }
+
     print_status(251, y_pos, "Warmboot saved successfully!", COLOR_GREEN);
     y_pos += 48;
 
@@ -327,6 +396,17 @@ cleanup_exit:
         free(wb_info.data);
 
 wait_exit:
+    // Writes what is still staged on the early exits
+    if (sd_stage_flush())
+        print_status(251, y_pos, "Failed to write files to SD card!", COLOR_RED);
+
+#ifdef HEAP_TRACE
+    heap_trace_save("sd:/switch/heap_trace.bin");
+#endif
+#ifdef IO_TRACE
+    io_trace_save("sd:/switch/io_trace.bin");
+#endif
+
     // Footer
     SETCOLOR(COLOR_RED, COLOR_DEFAULT);
     print_centered(680, "Power: Turn Off | Vol-: Back to Hekate | 3-Finger: Screenshot");
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "boot_backup.h"
+#include "nx_emmc.h"
+#include <libs/compr/lz4f.h>
+#include <libs/fatfs/ff.h>
+#include <mem/heap.h>
+#include <sec/se.h>
+#include <sec/se_t210.h>
+#include <storage/nx_sd.h>
+#include <storage/sdmmc.h>
+#include <utils/sprintf.h>
+#include <utils/util.h>
+
+#define BOOT_BACKUP_PIECE_SZ SZ_64K // LZ4 input between polls of the next read.
+
+typedef struct _boot_backup_chunk_t
+{
+	sdmmc_async_t async;
+	u8 *buf;
+	u32 size;
+	u32 start;
+	bool timed;
+} boot_backup_chunk_t;
+
+static void _boot_backup_read(boot_backup_chunk_t *chunk, u32 offset, u32 size)
+{
+	chunk->size = size;
+	chunk->start = get_tmr_us();
+	chunk->timed = false;
+	sdmmc_storage_read_async(&emmc_storage, &chunk->async, offset / NX_EMMC_BLOCKSIZE, size / NX_EMMC_BLOCKSIZE, chunk->buf);
+}
+
+/*
+ * Polling also moves the DMA over its 512KB boundaries. The read is charged when it is
+ * seen done, so its time is an upper bound. Blocking SD writes only wait for SD transfers,
+ * so the read is not finished inside the pack stage.
+ */
+static int _boot_backup_poll(boot_backup_chunk_t *chunk, boot_backup_stats_t *stats, bool wait)
+{
+	int status;
+
+	if (wait)
+	{
+		u32 start = get_tmr_us();
+		status = sdmmc_storage_wait(&chunk->async);
+		stats->read_wait_us += get_tmr_us() - start;
+	}
+	else
+		status = sdmmc_storage_poll(&chunk->async);
+
+	if (status != SDMMC_ASYNC_BUSY && !chunk->timed)
+	{
+		stats->stage_us[BOOT_BACKUP_STAGE_READ] += get_tmr_us() - chunk->start;
+		chunk->timed = true;
+	}
+
+	return status;
+}
+
+static int _boot_backup_part(u32 partition, const char *dir, char *manifest, boot_backup_chunk_t *chunks,
+	boot_backup_stats_t *stats)
+{
+	FIL fp;
+	lz4f_t lz;
+	char path[64];
+	u32 hash[SE_SHA_256_SIZE / 4];
+	u32 msg_left[2];
+	u32 start;
+
+	u32 part_size = emmc_storage.ext_csd.boot_mult * SZ_128K;
+	if (!part_size)
+		part_size = SZ_4M;
+
+	if (!sdmmc_storage_set_mmc_partition(&emmc_storage, partition))
+		return FR_DISK_ERR;
+
+	s_printf(path, "%s/BOOT%d.lz4", dir, partition - EMMC_BOOT0);
+	int res = f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res)
+		return res;
+
+	// Content checksum is left out, the manifest covers it.
+	res = lz4f_write_open(&lz, &fp, LZ4F_BLOCK_64K, false);
+	if (res)
+	{
+		f_close(&fp);
+		return res;
+	}
+
+	u32 count = DIV_ROUND_UP(part_size, BOOT_BACKUP_CHUNK_SZ);
+	_boot_backup_read(&chunks[0], 0, MIN(part_size, BOOT_BACKUP_CHUNK_SZ));
+	for (u32 i = 0; i < count; i++)
+	{
+		boot_backup_chunk_t *cur = &chunks[i & 1];
+		boot_backup_chunk_t *next = (i + 1 < count) ? &chunks[(i + 1) & 1] : NULL;
+
+		if (_boot_backup_poll(cur, stats, true) != SDMMC_ASYNC_DONE)
+		{
+			res = FR_DISK_ERR;
+			break;
+		}
+
+		// Next chunk is read while this one is hashed and packed.
+		if (next)
+		{
+			u32 offset = (i + 1) * BOOT_BACKUP_CHUNK_SZ;
+			_boot_backup_read(next, offset, MIN(part_size - offset, BOOT_BACKUP_CHUNK_SZ));
+		}
+
+		start = get_tmr_us();
+		if (!se_calc_sha256(hash, msg_left, cur->buf, cur->size, part_size, i ? SHA_CONTINUE : SHA_INIT_HASH, true))
+			res = FR_INT_ERR;
+		stats->stage_us[BOOT_BACKUP_STAGE_HASH] += get_tmr_us() - start;
+
+		for (u32 off = 0; !res && off < cur->size; off += BOOT_BACKUP_PIECE_SZ)
+		{
+			start = get_tmr_us();
+			res = lz4f_write(&lz, cur->buf + off, MIN(cur->size - off, BOOT_BACKUP_PIECE_SZ));
+			stats->stage_us[BOOT_BACKUP_STAGE_PACK] += get_tmr_us() - start;
+
+			if (next)
+				_boot_backup_poll(next, stats, false);
+		}
+		if (res)
+			break;
+
+		stats->bytes += cur->size;
+	}
+
+	// Buffers must not be in use when freed.
+	sdmmc_storage_wait(&chunks[0].async);
+	sdmmc_storage_wait(&chunks[1].async);
+
+	start = get_tmr_us();
+	int close_res = lz4f_write_close(&lz);
+	stats->stage_us[BOOT_BACKUP_STAGE_PACK] += get_tmr_us() - start;
+	res = res ? res : close_res;
+
+	stats->packed += f_size(&fp);
+	close_res = f_close(&fp);
+	res = res ? res : close_res;
+
+	if (res)
+		return res;
+
+	// Hash is big endian words, as sha256sum prints it.
+	char *line = manifest + strlen(manifest);
+	for (u32 i = 0; i < SE_SHA_256_SIZE; i++)
+		line += s_printf(line, "%02x", ((u8 *)hash)[i]);
+	s_printf(line, "  BOOT%d\n", partition - EMMC_BOOT0);
+
+	return FR_OK;
+}
+
+int boot_backup_save(boot_backup_stats_t *stats)
+{
+	char dir[32];
+	char path[64];
+	char manifest[2 * (SE_SHA_256_SIZE * 2 + 8) + 1];
+	boot_backup_chunk_t chunks[2];
+
+	memset(stats, 0, sizeof(boot_backup_stats_t));
+	memset(chunks, 0, sizeof(chunks));
+	manifest[0] = 0;
+
+	if (!emmc_storage.initialized)
+		return FR_NOT_READY;
+
+	s_printf(dir, BOOT_BACKUP_DIR "/%08X", emmc_storage.cid.serial);
+	f_mkdir(BOOT_BACKUP_DIR);
+	int res = f_mkdir(dir);
+	if (res && res != FR_EXIST)
+		return res;
+
+	chunks[0].buf = (u8 *)malloc(BOOT_BACKUP_CHUNK_SZ);
+	chunks[1].buf = (u8 *)malloc(BOOT_BACKUP_CHUNK_SZ);
+	if (!chunks[0].buf || !chunks[1].buf)
+	{
+		free(chunks[0].buf);
+		free(chunks[1].buf);
+		return FR_NOT_ENOUGH_CORE;
+	}
+
+	u32 start = get_tmr_us();
+	res = _boot_backup_part(EMMC_BOOT0, dir, manifest, chunks, stats);
+	if (!res)
+		res = _boot_backup_part(EMMC_BOOT1, dir, manifest, chunks, stats);
+	stats->total_us = get_tmr_us() - start;
+
+	free(chunks[0].buf);
+	free(chunks[1].buf);
+
+	if (res)
+		return res;
+
+	s_printf(path, "%s/" BOOT_BACKUP_MANIFEST, dir);
+
+	return sd_save_to_file(manifest, strlen(manifest), path);
+}
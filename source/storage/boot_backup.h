@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BOOT_BACKUP_H_
+#define _BOOT_BACKUP_H_
+
+#include <utils/types.h>
+
+#define BOOT_BACKUP_DIR      "sd:/backup"
+#define BOOT_BACKUP_MANIFEST "boot.sha256" // sha256sum format, of the decompressed partitions.
+#define BOOT_BACKUP_CHUNK_SZ SZ_1M
+
+enum
+{
+	BOOT_BACKUP_STAGE_READ = 0, // eMMC, from request to completion.
+	BOOT_BACKUP_STAGE_HASH,     // SE SHA256.
+	BOOT_BACKUP_STAGE_PACK,     // LZ4 and SD write.
+	BOOT_BACKUP_STAGES
+};
+
+typedef struct _boot_backup_stats_t
+{
+	u32 bytes;                        // Read from eMMC.
+	u32 packed;                       // Written to SD.
+	u32 stage_us[BOOT_BACKUP_STAGES];
+	u32 read_wait_us;                 // Read time not hidden behind the other stages.
+	u32 total_us;
+} boot_backup_stats_t;
+
+/*
+ * Backs up BOOT0 and BOOT1 of the initialized eMMC to BOOT_BACKUP_DIR/<eMMC serial>/ as
+ * LZ4 frames, with a manifest of their hashes. Each chunk is hashed and compressed while
+ * the next one is read. The eMMC is left on BOOT1.
+ * Returns 0 or a FatFs error. FR_DISK_ERR is an eMMC read error.
+ */
+int boot_backup_save(boot_backup_stats_t *stats);
+
+#endif
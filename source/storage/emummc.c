@@ -23,10 +23,13 @@
 #include <utils/ini.h>
 #include <gfx_utils.h>
 #include <libs/fatfs/ff.h>
+#include <mem/dma_pool.h>
 #include <mem/heap.h>
+#include "../storage/io_trace.h"
 #include "../storage/nx_emmc.h"
 #include <storage/nx_sd.h>
 #include <utils/list.h>
+#include <utils/util.h>
 #include <utils/types.h>
 
 extern hekate_config h_cfg;
@@ -190,9 +193,8 @@ int emummc_storage_end()
 	return 1;
 }
 
-int emummc_storage_read(u32 sector, u32 num_sectors, void *buf)
+static int _emummc_storage_read(u32 sector, u32 num_sectors, void *buf)
 {
-	FIL fp;
 	if (!emu_cfg.enabled || h_cfg.emummc_force_disable)
 		return sdmmc_storage_read(&emmc_storage, sector, num_sectors, buf);
 	else if (emu_cfg.sector)
@@ -215,29 +217,33 @@ int emummc_storage_read(u32 sector, u32 num_sectors, void *buf)
 				itoa(file_part, emu_cfg.emummc_file_based_path + strlen(emu_cfg.emummc_file_based_path) - 1, 10);
 			}
 		}
-		if (f_open(&fp, emu_cfg.emummc_file_based_path, FA_READ))
+		// File object from DMA pool, so partial sectors avoid the sdmmc bounce copy.
+		FIL *fp = (FIL *)dma_pool_alloc();
+		if (f_open(fp, emu_cfg.emummc_file_based_path, FA_READ))
 		{
 			EPRINTF("Failed to open emuMMC image.");
+			dma_pool_free(fp);
 			return 0;
 		}
-		f_lseek(&fp, (u64)sector << 9);
-		if (f_read(&fp, buf, (u64)num_sectors << 9, NULL))
+		f_lseek(fp, (u64)sector << 9);
+		if (f_read(fp, buf, (u64)num_sectors << 9, NULL))
 		{
 			EPRINTF("Failed to read emuMMC image.");
-			f_close(&fp);
+			f_close(fp);
+			dma_pool_free(fp);
 			return 0;
 		}
 
-		f_close(&fp);
+		f_close(fp);
+		dma_pool_free(fp);
 		return 1;
 	}
 
 	return 1;
 }
 
-int emummc_storage_write(u32 sector, u32 num_sectors, void *buf)
+static int _emummc_storage_write(u32 sector, u32 num_sectors, void *buf)
 {
-	FIL fp;
 	if (!emu_cfg.enabled || h_cfg.emummc_force_disable)
 		return sdmmc_storage_write(&emmc_storage, sector, num_sectors, buf);
 	else if (emu_cfg.sector)
@@ -261,21 +267,68 @@ int emummc_storage_write(u32 sector, u32 num_sectors, void *buf)
 			}
 		}
 
-		if (f_open(&fp, emu_cfg.emummc_file_based_path, FA_WRITE))
+		FIL *fp = (FIL *)dma_pool_alloc();
+		if (f_open(fp, emu_cfg.emummc_file_based_path, FA_WRITE))
+		{
+			dma_pool_free(fp);
 			return 0;
+		}
 
-		f_lseek(&fp, (u64)sector << 9);
-		if (f_write(&fp, buf, (u64)num_sectors << 9, NULL))
+		f_lseek(fp, (u64)sector << 9);
+		if (f_write(fp, buf, (u64)num_sectors << 9, NULL))
 		{
-			f_close(&fp);
+			f_close(fp);
+			dma_pool_free(fp);
 			return 0;
 		}
 
-		f_close(&fp);
+		f_close(fp);
+		dma_pool_free(fp);
 		return 1;
 	}
 }
 
+int emummc_storage_read(u32 sector, u32 num_sectors, void *buf)
+{
+#ifdef IO_TRACE
+	u32 start = get_tmr_us();
+	int res = _emummc_storage_read(sector, num_sectors, buf);
+	io_trace_record(IO_TRACE_DEV_EMUMMC + emu_cfg.active_part, IO_TRACE_READ, sector, num_sectors, start, !res);
+
+	return res;
+#else
+	return _emummc_storage_read(sector, num_sectors, buf);
+#endif
+}
+
+int emummc_storage_write(u32 sector, u32 num_sectors, void *buf)
+{
+#ifdef IO_TRACE
+	u32 start = get_tmr_us();
+	int res = _emummc_storage_write(sector, num_sectors, buf);
+	io_trace_record(IO_TRACE_DEV_EMUMMC + emu_cfg.active_part, IO_TRACE_WRITE, sector, num_sectors, start, !res);
+
+	return res;
+#else
+	return _emummc_storage_write(sector, num_sectors, buf);
+#endif
+}
+
+int emummc_storage_trim(u32 sector, u32 num_sectors)
+{
+	if (!emu_cfg.enabled || h_cfg.emummc_force_disable)
+		return sdmmc_storage_erase(&emmc_storage, sector, num_sectors);
+	else if (emu_cfg.sector)
+	{
+		sector += emu_cfg.sector;
+		sector += emummc_raw_get_part_off(emu_cfg.active_part) * 0x2000;
+		return sdmmc_storage_erase(&sd_storage, sector, num_sectors);
+	}
+
+	// File based emuMMC can't discard image contents.
+	return 1;
+}
+
 int emummc_storage_set_mmc_partition(u32 partition)
 {
 	emu_cfg.active_part = partition;
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef IO_TRACE
+
+#include <string.h>
+
+#include "io_trace.h"
+#include <libs/fatfs/ff.h>
+#include <memory_map.h>
+#include <utils/trace_ring.h>
+#include <utils/util.h>
+
+static bool trace_init = false;
+
+void io_trace_record(u32 dev, u32 op, u32 sector, u32 count, u32 start, u32 error)
+{
+	io_trace_hdr_t *trace = (io_trace_hdr_t *)IO_TRACE_ADDR;
+	io_trace_entry_t *entry = (io_trace_entry_t *)(IO_TRACE_ADDR + sizeof(io_trace_hdr_t));
+
+	if (!trace_init)
+	{
+		memset(trace, 0, sizeof(io_trace_hdr_t));
+		trace->magic = IO_TRACE_MAGIC;
+		trace->version = IO_TRACE_VERSION;
+		trace->entry_size = sizeof(io_trace_entry_t);
+		trace->capacity = (IO_TRACE_SZ - sizeof(io_trace_hdr_t)) / sizeof(io_trace_entry_t);
+		trace_init = true;
+	}
+
+	entry += trace->head;
+	entry->timestamp = start;
+	entry->duration = get_tmr_us() - start;
+	entry->sector = sector;
+	entry->count = count;
+	entry->dev = dev;
+	entry->op = op;
+	entry->error = error ? 1 : 0;
+	entry->rsvd = 0;
+
+	trace->head++;
+	if (trace->head == trace->capacity)
+		trace->head = 0;
+	trace->count++;
+}
+
+_Static_assert(OFFSET_OF(io_trace_hdr_t, head) == OFFSET_OF(trace_ring_hdr_t, head), "I/O trace header must start like trace_ring_hdr_t!");
+
+int io_trace_save(const char *path)
+{
+	io_trace_hdr_t hdr;
+
+	if (!trace_init)
+		return FR_OK;
+
+	// Snapshot the header. Saving the trace also gets traced.
+	memcpy(&hdr, (void *)IO_TRACE_ADDR, sizeof(io_trace_hdr_t));
+
+	return trace_ring_save(path, &hdr, sizeof(io_trace_hdr_t), (void *)(IO_TRACE_ADDR + sizeof(io_trace_hdr_t)));
+}
+
+#endif
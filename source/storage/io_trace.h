@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _IO_TRACE_H_
+#define _IO_TRACE_H_
+
+#include <utils/types.h>
+
+/*
+ * Trace file layout (little endian):
+ *  io_trace_hdr_t, followed by hdr.entries io_trace_entry_t in chronological order.
+ * hdr.count is the number of recorded operations. If it exceeds hdr.capacity,
+ * only the last hdr.capacity ones are kept.
+ */
+#define IO_TRACE_MAGIC   0x52544F49 // "IOTR".
+#define IO_TRACE_VERSION 1
+
+enum
+{
+	IO_TRACE_READ  = 0,
+	IO_TRACE_WRITE = 1
+};
+
+// Devices. FatFs drives use their physical drive number.
+enum
+{
+	IO_TRACE_DEV_EMUMMC = 0x10 // + eMMC partition.
+};
+
+typedef struct _io_trace_entry_t
+{
+	u32 timestamp; // us.
+	u32 duration;  // us.
+	u32 sector;
+	u32 count;
+	u8  dev;
+	u8  op;
+	u8  error;
+	u8  rsvd;
+} io_trace_entry_t;
+
+typedef struct _io_trace_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 entry_size;
+	u32 entries;
+	u32 count;
+	u32 capacity;
+	u32 head;
+	u32 rsvd[9];
+} io_trace_hdr_t;
+
+#ifdef IO_TRACE
+void io_trace_record(u32 dev, u32 op, u32 sector, u32 count, u32 start, u32 error);
+int  io_trace_save(const char *path);
+#endif
+
+#endif
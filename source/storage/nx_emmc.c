@@ -19,6 +19,7 @@
 
 #include "nx_emmc.h"
 #include "emummc.h"
+#include <mem/arena.h>
 #include <mem/heap.h>
 #include <soc/fuse.h>
 #include <storage/mbr_gpt.h>
@@ -28,8 +29,9 @@ sdmmc_t emmc_sdmmc;
 sdmmc_storage_t emmc_storage;
 FATFS emmc_fs;
 
-void nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage)
+arena_t *nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage)
 {
+	arena_t *arena = NULL;
 	gpt_t *gpt_buf = (gpt_t *)calloc(NX_GPT_NUM_BLOCKS, NX_EMMC_BLOCKSIZE);
 
 	emummc_storage_read(NX_GPT_FIRST_LBA, NX_GPT_NUM_BLOCKS, gpt_buf);
@@ -38,13 +40,18 @@ void nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage)
 	if (memcmp(&gpt_buf->header.signature, "EFI PART", 8) || gpt_buf->header.num_part_ents > 128)
 		goto out;
 
+	// Partition entries are allocated from one arena, sized for all of them.
+	arena = arena_create(ALIGN(sizeof(emmc_part_t), ARENA_ALIGN) * gpt_buf->header.num_part_ents);
+	if (!arena)
+		goto out;
+
 	for (u32 i = 0; i < gpt_buf->header.num_part_ents; i++)
 	{
-		emmc_part_t *part = (emmc_part_t *)calloc(sizeof(emmc_part_t), 1);
-
 		if (gpt_buf->entries[i].lba_start < gpt_buf->header.first_use_lba)
 			continue;
 
+		emmc_part_t *part = (emmc_part_t *)arena_calloc(arena, sizeof(emmc_part_t), 1);
+
 		part->index = i;
 		part->lba_start = gpt_buf->entries[i].lba_start;
 		part->lba_end = gpt_buf->entries[i].lba_end;
@@ -60,12 +67,15 @@ void nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage)
 
 out:
 	free(gpt_buf);
+
+	return arena;
 }
 
-void nx_emmc_gpt_free(link_t *gpt)
+void nx_emmc_gpt_free(link_t *gpt, arena_t *arena)
 {
-	LIST_FOREACH_SAFE(iter, gpt)
-		free(CONTAINER_OF(iter, emmc_part_t, link));
+	arena_destroy(arena);
+
+	list_init(gpt);
 }
 
 emmc_part_t *nx_emmc_part_find(link_t *gpt, const char *name)
@@ -95,6 +105,15 @@ int nx_emmc_part_write(sdmmc_storage_t *storage, emmc_part_t *part, u32 sector_o
 	return emummc_storage_write(part->lba_start + sector_off, num_sectors, buf);
 }
 
+int nx_emmc_part_trim(emmc_part_t *part, u32 sector_off, u32 num_sectors)
+{
+	// The last LBA is inclusive.
+	if (!num_sectors || part->lba_start + sector_off + num_sectors - 1 > part->lba_end)
+		return 0;
+
+	return emummc_storage_trim(part->lba_start + sector_off, num_sectors);
+}
+
 void nx_emmc_get_autorcm_masks(u8 *mod0, u8 *mod1)
 {
 	if (fuse_read_hw_state() == FUSE_NX_HW_STATE_PROD)
@@ -20,6 +20,7 @@
 
 #include <storage/sdmmc.h>
 #include <libs/fatfs/ff.h>
+#include <mem/arena.h>
 #include <utils/types.h>
 #include <utils/list.h>
 
@@ -41,11 +42,13 @@ extern sdmmc_t emmc_sdmmc;
 extern sdmmc_storage_t emmc_storage;
 extern FATFS emmc_fs;
 
-void nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage);
-void nx_emmc_gpt_free(link_t *gpt);
+// Returns the arena that holds the entries of gpt. Free them with nx_emmc_gpt_free.
+arena_t *nx_emmc_gpt_parse(link_t *gpt, sdmmc_storage_t *storage);
+void nx_emmc_gpt_free(link_t *gpt, arena_t *arena);
 emmc_part_t *nx_emmc_part_find(link_t *gpt, const char *name);
 int  nx_emmc_part_read(sdmmc_storage_t *storage, emmc_part_t *part, u32 sector_off, u32 num_sectors, void *buf);
 int  nx_emmc_part_write(sdmmc_storage_t *storage, emmc_part_t *part, u32 sector_off, u32 num_sectors, void *buf);
+int  nx_emmc_part_trim(emmc_part_t *part, u32 sector_off, u32 num_sectors);
 
 void nx_emmc_get_autorcm_masks(u8 *mod0, u8 *mod1);
 
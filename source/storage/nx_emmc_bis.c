@@ -306,6 +306,37 @@ int nx_emmc_bis_write(u32 sector, u32 count, void *buff)
 	return res;
 }
 
+int nx_emmc_bis_trim(u32 sector, u32 count)
+{
+	if (!system_part)
+		return 3; // Not ready.
+
+	// Drop pending writes of trimmed clusters, or a flush would write them back.
+	// Partly trimmed clusters still hold live sectors and are kept.
+	u32 cluster_start = DIV_ROUND_UP(sector, SECTORS_PER_CLUSTER);
+	u32 cluster_end = (sector + count) / SECTORS_PER_CLUSTER;
+	u32 limit = cache_filled == 1 ? MAX_CLUSTER_CACHE_ENTRIES : cluster_cache_end_index;
+	for (u32 i = 0; i < limit && dirty_cluster_count; i++)
+	{
+		cluster_cache_t *entry = &bis_cache->cluster_cache[i];
+		if (entry->dirty && entry->cluster_num >= cluster_start && entry->cluster_num < cluster_end)
+		{
+			entry->dirty = 0;
+			dirty_cluster_count--;
+		}
+	}
+
+	return nx_emmc_part_trim(system_part, sector, count) ? 0 : 1;
+}
+
+u32 nx_emmc_bis_get_sector_count()
+{
+	if (!system_part)
+		return 0;
+
+	return system_part->lba_end - system_part->lba_start + 1;
+}
+
 void nx_emmc_bis_cluster_cache_init()
 {
 	u32 cluster_lookup_size = (system_part->lba_end - system_part->lba_start + 1) / SECTORS_PER_CLUSTER * sizeof(*cluster_lookup);
@@ -240,6 +240,8 @@ typedef struct _nx_emmc_cal0_t
 
 int nx_emmc_bis_read(u32 sector, u32 count, void *buff);
 int nx_emmc_bis_write(u32 sector, u32 count, void *buff);
+int nx_emmc_bis_trim(u32 sector, u32 count);
+u32 nx_emmc_bis_get_sector_count();
 void nx_emmc_bis_cluster_cache_init();
 void nx_emmc_bis_init(emmc_part_t *part);
 void nx_emmc_bis_finalize();
@@ -15,20 +15,39 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <storage/nx_sd.h>
 #include <storage/sdmmc.h>
 #include <storage/sdmmc_driver.h>
 #include <gfx_utils.h>
+#include <libs/fatfs/diskio.h>
 #include <libs/fatfs/ff.h>
+#include <mem/dma_pool.h>
 #include <mem/heap.h>
+#include <utils/list.h>
+#include <utils/util.h>
+
+#define SD_SAVE_DIRECT_MIN SZ_1M // Smaller files use plain f_write.
+#define SD_SAVE_CHUNK_SZ   SZ_4M
+
+typedef struct _sd_stage_file_t
+{
+	link_t link;
+	char  *path;
+	u8    *data;
+	u32    size;
+} sd_stage_file_t;
 
 static bool sd_mounted = false;
+static bool sd_staging = false;
+LIST_INIT_STATIC(sd_stage_files); // Sorted by path.
 static u16  sd_errors[3] = { 0 }; // Init and Read/Write errors.
 static u32  sd_mode = SD_UHS_SDR82;
 
 sdmmc_t sd_sdmmc;
 sdmmc_storage_t sd_storage;
-FATFS sd_fs;
+FATFS *sd_fs; // In DRAM, so its window is DMA capable.
 
 void sd_error_count_increment(u8 type)
 {
@@ -153,7 +172,10 @@ bool sd_mount()
 	}
 	else
 	{
-		res = f_mount(&sd_fs, "", 1);
+		if (!sd_fs)
+			sd_fs = (FATFS *)dma_pool_alloc();
+
+		res = f_mount(sd_fs, "", 1);
 		if (res == FR_OK)
 		{
 			sd_mounted = true;
@@ -177,6 +199,7 @@ static void _sd_deinit()
 	if (sd_mounted)
 	{
 		f_mount(NULL, "", 1);
+		disk_sd_cache_reset();
 		sdmmc_storage_end(&sd_storage);
 		sd_mounted = false;
 	}
@@ -187,7 +210,7 @@ void sd_end()     { _sd_deinit(); }
 
 bool sd_is_gpt()
 {
-	return sd_fs.part_type;
+	return sd_fs && sd_fs->part_type;
 }
 
 void *sd_file_read(const char *path, u32 *fsize)
@@ -215,19 +238,283 @@ void *sd_file_read(const char *path, u32 *fsize)
 	return buf;
 }
 
-int sd_save_to_file(void *buf, u32 size, const char *filename)
+// First cluster from clst on that starts an SD allocation unit. 0 if there is none.
+static u32 _sd_au_cluster(FATFS *fs, u32 au, u32 clst)
+{
+	for (u32 i = 0; i < au / fs->csize && clst < fs->n_fatent; i++, clst++)
+	{
+		if (!((fs->database + (clst - 2) * fs->csize) % au))
+			return clst;
+	}
+
+	return 0;
+}
+
+/*
+ * Finds a free extent for size bytes that starts at an SD allocation unit, and points
+ * f_expand to it. The search starts at the next allocation point and wraps around.
+ * If no such extent is free, f_expand takes the first free extent it finds.
+ */
+static int _sd_save_align(FIL *fp, u32 size)
+{
+	FATFS *fs = fp->obj.fs;
+	u32 au = sd_storage_get_ssr_au(&sd_storage) * 2; // KB to sectors.
+	if (fs->pdrv != DRIVE_SD || au <= fs->csize)
+		return FR_OK;
+
+	u32 hint = fs->last_clst;
+	if (hint < 2 || hint >= fs->n_fatent)
+		hint = 2;
+
+	u32 start = _sd_au_cluster(fs, au, hint);
+	u32 clst = start;
+	bool wrapped = false;
+
+	if (!start)
+		start = fs->n_fatent;
+
+	for (;;)
+	{
+		if (!clst || (wrapped && clst >= start))
+		{
+			if (wrapped)
+				break;
+
+			wrapped = true;
+			clst = _sd_au_cluster(fs, au, 2);
+			if (!clst || clst >= start)
+				break;
+		}
+
+		// Only finds the first free extent from clst on and points last_clst before it.
+		fs->last_clst = clst;
+		int res = f_expand(fp, size, 0);
+		if (res)
+			return res;
+
+		u32 scl = fs->last_clst + 1;
+		if (_sd_au_cluster(fs, au, scl) == scl)
+		{
+			fs->last_clst = scl; // f_expand allocates from here.
+			return FR_OK;
+		}
+
+		// Search went past the end of the volume.
+		if (scl < clst)
+		{
+			if (wrapped)
+				break;
+			wrapped = true;
+		}
+
+		clst = _sd_au_cluster(fs, au, scl);
+	}
+
+	fs->last_clst = hint;
+
+	return FR_OK;
+}
+
+/*
+ * Preallocates a contiguous extent and writes the file straight to its sectors,
+ * in chunks aligned to SD_SAVE_CHUNK_SZ. Returns FR_DENIED if no extent is free.
+ */
+static int _sd_save_direct(FIL *fp, const u8 *buf, u32 size)
+{
+	FATFS *fs = fp->obj.fs;
+
+	int res = _sd_save_align(fp, size);
+	if (!res)
+		res = f_expand(fp, size, 1);
+	if (res)
+		return res;
+
+	u32 sector = fs->database + (fp->obj.sclust - 2) * fs->csize;
+	u32 sectors = size / 512;
+	const u32 chunk = SD_SAVE_CHUNK_SZ / 512;
+
+	while (sectors)
+	{
+		u32 cnt = MIN(sectors, chunk - (sector % chunk));
+		if (disk_write(fs->pdrv, buf, sector, cnt))
+			return FR_DISK_ERR;
+
+		buf += cnt * 512;
+		sector += cnt;
+		sectors -= cnt;
+	}
+
+	// Zero pad the last partial sector.
+	if (size % 512)
+	{
+		u8 *tail = (u8 *)dma_pool_alloc();
+		memset(tail, 0, 512);
+		memcpy(tail, buf, size % 512);
+		res = disk_write(fs->pdrv, tail, sector, 1) ? FR_DISK_ERR : FR_OK;
+		dma_pool_free(tail);
+	}
+
+	return res;
+}
+
+static void _sd_mkdir_parents(const char *path)
+{
+	char dir[256];
+
+	if (strlen(path) >= sizeof(dir))
+		return;
+	strcpy(dir, path);
+
+	// Skip drive and root.
+	char *p = strchr(dir, ':');
+	p = p ? p + 1 : dir;
+	if (*p == '/')
+		p++;
+
+	for (; *p; p++)
+	{
+		if (*p == '/')
+		{
+			*p = 0;
+			f_mkdir(dir);
+			*p = '/';
+		}
+	}
+}
+
+static int _sd_save_file(void *buf, u32 size, const char *filename)
 {
 	FIL fp;
 	u32 res = 0;
 	res = f_open(&fp, filename, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res == FR_NO_PATH)
+	{
+		_sd_mkdir_parents(filename);
+		res = f_open(&fp, filename, FA_CREATE_ALWAYS | FA_WRITE);
+	}
 	if (res)
 	{
 		EPRINTFARGS("Error (%d) creating file\n%s.\n", res, filename);
 		return res;
 	}
 
-	f_write(&fp, buf, size, NULL);
-	f_close(&fp);
+	res = FR_DENIED;
+	if (size >= SD_SAVE_DIRECT_MIN)
+		res = _sd_save_direct(&fp, buf, size);
+
+	// Fragmented volume or small file.
+	if (res == FR_DENIED)
+	{
+		UINT bytes_written = 0;
+		res = f_write(&fp, buf, size, &bytes_written);
+		if (!res && bytes_written != size)
+			res = FR_DENIED; // Volume is full.
+	}
+
+	// Cached data and the directory entry are written back here.
+	u32 close_res = f_close(&fp);
+	if (!res)
+		res = close_res;
+
+	if (res)
+	{
+		EPRINTFARGS("Error (%d) writing file\n%s.\n", res, filename);
+		return res;
+	}
 
 	return 0;
 }
+
+// Keeps a copy of the file in RAM. A newer copy of the same path replaces the old one.
+static bool _sd_stage_file(void *buf, u32 size, const char *filename)
+{
+	sd_stage_file_t *file = (sd_stage_file_t *)malloc(sizeof(sd_stage_file_t));
+	char *path = (char *)malloc(strlen(filename) + 1);
+	u8 *data = (u8 *)malloc(size ? size : 1);
+	if (!file || !path || !data)
+	{
+		free(file);
+		free(path);
+		free(data);
+
+		return false;
+	}
+
+	strcpy(path, filename);
+	memcpy(data, buf, size);
+	file->path = path;
+	file->data = data;
+	file->size = size;
+
+	link_t *pos = &sd_stage_files;
+	LIST_FOREACH_SAFE(iter, &sd_stage_files)
+	{
+		sd_stage_file_t *staged = CONTAINER_OF(iter, sd_stage_file_t, link);
+		int cmp = strcmp(staged->path, path);
+		if (cmp > 0)
+			break;
+
+		pos = iter;
+		if (!cmp)
+		{
+			pos = iter->prev;
+			list_remove(iter);
+			free(staged->path);
+			free(staged->data);
+			free(staged);
+			break;
+		}
+	}
+
+	// Insert after pos.
+	list_prepend(pos, &file->link);
+
+	return true;
+}
+
+int sd_save_to_file(void *buf, u32 size, const char *filename)
+{
+	// Write through if staging can't get memory.
+	if (sd_staging && _sd_stage_file(buf, size, filename))
+		return 0;
+
+	return _sd_save_file(buf, size, filename);
+}
+
+void sd_stage_begin()
+{
+	sd_staging = true;
+}
+
+/*
+ * Writes all staged files to SD in path order, so files of the same directory
+ * are written together and each missing directory is created once.
+ * Ends staging. Returns the first error.
+ */
+int sd_stage_flush()
+{
+	int res = 0;
+
+	sd_staging = false;
+
+	if (list_empty(&sd_stage_files))
+		return 0;
+
+	if (!sd_mount())
+		res = FR_NOT_READY;
+
+	LIST_FOREACH_SAFE(iter, &sd_stage_files)
+	{
+		sd_stage_file_t *file = CONTAINER_OF(iter, sd_stage_file_t, link);
+
+		if (!res)
+			res = _sd_save_file(file->data, file->size, file->path);
+
+		list_remove(iter);
+		free(file->path);
+		free(file->data);
+		free(file);
+	}
+
+	return res;
+}
@@ -10,6 +10,7 @@
  */
 
 #include "warmboot_extractor.h"
+#include "wb_archive.h"
 #include <string.h>
 #include <stdio.h>
 #include <mem/heap.h>
@@ -130,18 +131,37 @@ const char *wb_error_to_string(wb_extract_error_t err) {
     }
 }
 
+// Erista only opens the eMMC for the BOOT0/BOOT1 backup
+static int backup_boot_only(boot_backup_stats_t *stats) {
+    if (emmc_storage.sdmmc != NULL) {
+        sdmmc_storage_end(&emmc_storage);
+    }
+    usleep(1000);
+
+    if (!sdmmc_storage_init_mmc(&emmc_storage, &emmc_sdmmc, SDMMC_BUS_WIDTH_8, SDHCI_TIMING_MMC_HS400))
+        return FR_NOT_READY;
+
+    int res = boot_backup_save(stats);
+    sdmmc_storage_end(&emmc_storage);
+
+    return res;
+}
+
 // Extended extraction with detailed error codes
-wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info) {
+wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info, u32 flags) {
     if (!wb_info)
         return WB_ERR_NULL_INFO;
 
     // Initialize result
     memset(wb_info, 0, sizeof(warmboot_info_t));
+    wb_info->backup_res = -1;
     wb_info->is_erista = !is_mariko();
     wb_info->fuse_count = get_burnt_fuses();
 
-    // Erista doesn't need warmboot extraction from Package1
+    // Erista doesn't need warmboot extraction from Package1, only the backup runs
     if (wb_info->is_erista) {
+        if (flags & WB_EXTRACT_BACKUP_BOOT)
+            wb_info->backup_res = backup_boot_only(&wb_info->backup);
         return WB_ERR_ERISTA_NOT_SUPPORTED;
     }
 
@@ -192,6 +212,10 @@ wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info) {
         return WB_ERR_MMC_READ;
     }
 
+    // Backup is of the physical eMMC and does not affect the extraction result
+    if (flags & WB_EXTRACT_BACKUP_BOOT)
+        wb_info->backup_res = boot_backup_save(&wb_info->backup);
+
     emummc_storage_end();
 
     // On Mariko, Package1 is encrypted and needs decryption
@@ -365,7 +389,7 @@ wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info) {
 
 // Original wrapper for backward compatibility
 bool extract_warmboot_from_pkg1(warmboot_info_t *wb_info) {
-    return extract_warmboot_from_pkg1_ex(wb_info) == WB_SUCCESS;
+    return extract_warmboot_from_pkg1_ex(wb_info, 0) == WB_SUCCESS;
 }
 
 // Save warmboot to SD card
@@ -373,17 +397,6 @@ bool save_warmboot_to_sd(const warmboot_info_t *wb_info, const char *path) {
     if (!wb_info || !wb_info->data || !path)
         return false;
 
-    FIL fp;
-    UINT bytes_written;
-
-    // Create directory if needed
-    const char *dir_path = wb_info->is_erista ? "sd:/warmboot_erista" : "sd:/warmboot_mariko";
-    f_mkdir(dir_path);
-
-    // Open file for writing
-    if (f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
-        return false;
-
     // CRITICAL: Atmosphere's format is ALWAYS: [size_u32][warmboot_binary...]
     // Our wb_info->data already contains this format because we copied from pk11_data
     // which points to the size field. The size value (wb_info->size) is the total
@@ -392,13 +405,45 @@ bool save_warmboot_to_sd(const warmboot_info_t *wb_info, const char *path) {
     // where warmboot_src points to the size field and warmboot_src_size is the total.
     //
     // So we just write the data as-is, no conditional logic needed.
-    if (f_write(&fp, wb_info->data, wb_info->size, &bytes_written) != FR_OK) {
-        f_close(&fp);
+    // The warmboot directory is created on demand and the write may be staged until sd_stage_flush().
+    return sd_save_to_file(wb_info->data, wb_info->size, path) == 0;
+}
+
+// Load a warmboot from an archive built by tools/wbarc
+// On success wb_info->data is allocated and must be freed by the caller.
+bool load_warmboot_from_archive(warmboot_info_t *wb_info, const char *path, u8 fuse_count) {
+    wb_archive_t arc;
+    u32 arc_size;
+
+    if (!wb_info || !path)
+        return false;
+
+    u8 *arc_data = sd_file_read(path, &arc_size);
+    if (!arc_data)
         return false;
-    }
 
-    f_close(&fp);
+    bool res = false;
+    int idx = -1;
+    if (wb_archive_open(&arc, arc_data, arc_size))
+        idx = wb_archive_find(&arc, fuse_count);
+
+    // Same size limits as extraction, plus the size field
+    if (idx >= 0 && arc.index[idx].size >= WARMBOOT_MIN_SIZE && arc.index[idx].size <= WARMBOOT_MAX_SIZE + 4) {
+        u8 *wb = (u8 *)malloc(arc.index[idx].size);
+        if (wb && wb_archive_read(&arc, idx, wb, arc.index[idx].size)) {
+            memset(wb_info, 0, sizeof(warmboot_info_t));
+            wb_info->data = wb;
+            wb_info->size = arc.index[idx].size;
+            wb_info->fuse_count = fuse_count;
+            wb_info->burnt_fuses = fuse_count;
+            wb_info->is_erista = !is_mariko();
+            wb_info->backup_res = -1;
+            res = true;
+        } else {
+            free(wb);
+        }
+    }
 
-    // Verify write succeeded
-    return (bytes_written == wb_info->size);
+    free(arc_data);
+    return res;
 }
\ No newline at end of file
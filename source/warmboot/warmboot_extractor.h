@@ -14,6 +14,7 @@
 
 #include <stddef.h>
 #include <utils/types.h>
+#include "../storage/boot_backup.h"
 
 // Warmboot binary size constraints
 #define WARMBOOT_MIN_SIZE 0x800   // 2048 bytes
@@ -31,6 +32,9 @@
 #define SIG_SECURE_MONITOR_1 0xE328F0C0
 #define SIG_SECURE_MONITOR_2 0xF0C0A7F0
 
+// Extraction flags
+#define WB_EXTRACT_BACKUP_BOOT BIT(0)  // Also back up BOOT0/BOOT1 to SD. Erista only does the backup
+
 // Warmboot metadata structure
 typedef struct {
     u32 magic;              // "WBT0" (0x30544257)
@@ -55,6 +59,9 @@ typedef struct {
     u8 debug_warmboot_preview[16];  // First 16 bytes of warmboot data (encrypted)
     u8 pkg1_date[12];       // Package1 date string (8 chars + null)
     u8 pkg1_version;        // Package1 version byte at offset 0x1F
+    // BOOT0/BOOT1 backup, with WB_EXTRACT_BACKUP_BOOT
+    int backup_res;         // FatFs result, -1 if not run
+    boot_backup_stats_t backup;
 } warmboot_info_t;
 
 // Extraction error codes for debugging
@@ -73,9 +80,10 @@ typedef enum {
 } wb_extract_error_t;
 
 // Function prototypes
-wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info);
+wb_extract_error_t extract_warmboot_from_pkg1_ex(warmboot_info_t *wb_info, u32 flags);
 bool extract_warmboot_from_pkg1(warmboot_info_t *wb_info);
 bool save_warmboot_to_sd(const warmboot_info_t *wb_info, const char *path);
+bool load_warmboot_from_archive(warmboot_info_t *wb_info, const char *path, u8 fuse_count);
 u8 get_burnt_fuses(void);
 bool is_mariko(void);
 void get_warmboot_path(char *path, size_t path_size, u8 fuse_count);
@@ -0,0 +1,65 @@
+/*
+ * Warmboot Extractor
+ * Warmboot archive reader
+ *
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+#include "wb_archive.h"
+#include <libs/compr/lz4.h>
+#include <utils/util.h>
+
+bool wb_archive_open(wb_archive_t *arc, const void *data, u32 size) {
+    const wb_archive_header_t *hdr = (const wb_archive_header_t *)data;
+
+    if (!data || size < sizeof(wb_archive_header_t))
+        return false;
+
+    if (hdr->magic != WB_ARCHIVE_MAGIC || hdr->version != WB_ARCHIVE_VERSION ||
+        hdr->dict_size > WB_ARCHIVE_DICT_MAX)
+        return false;
+
+    u32 dict_off = sizeof(wb_archive_header_t) + hdr->count * sizeof(wb_archive_entry_t);
+    if (dict_off > size || hdr->dict_size > size - dict_off)
+        return false;
+
+    arc->data = (const u8 *)data;
+    arc->size = size;
+    arc->index = (const wb_archive_entry_t *)(arc->data + sizeof(wb_archive_header_t));
+    arc->count = hdr->count;
+    arc->dict = arc->data + dict_off;
+    arc->dict_size = hdr->dict_size;
+
+    return true;
+}
+
+int wb_archive_find(const wb_archive_t *arc, u8 fuses) {
+    // Index is small, a scan is enough
+    for (u32 i = 0; i < arc->count; i++) {
+        if (arc->index[i].fuses == fuses)
+            return i;
+    }
+
+    return -1;
+}
+
+u32 wb_archive_read(const wb_archive_t *arc, u32 idx, void *buf, u32 buf_size) {
+    if (idx >= arc->count)
+        return 0;
+
+    const wb_archive_entry_t *entry = &arc->index[idx];
+    if (entry->size > buf_size || entry->offset > arc->size || entry->comp_size > arc->size - entry->offset)
+        return 0;
+
+    int size = LZ4_decompress_safe_usingDict((const char *)arc->data + entry->offset, (char *)buf,
+                                             entry->comp_size, entry->size,
+                                             (const char *)arc->dict, arc->dict_size);
+    if (size != (int)entry->size || crc32_calc(0, buf, entry->size) != entry->crc32)
+        return 0;
+
+    return entry->size;
+}
@@ -0,0 +1,57 @@
+/*
+ * Warmboot Extractor
+ * Warmboot archive reader
+ *
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+#ifndef _WB_ARCHIVE_H_
+#define _WB_ARCHIVE_H_
+
+#include <utils/types.h>
+
+// Archive of wb_xx.bin files, built by tools/wbarc.
+// Layout: header, index, LZ4 dictionary, then each entry as an LZ4 block compressed
+// with the dictionary. Any entry is decoded from its block and the dictionary alone.
+#define WB_ARCHIVE_MAGIC     0x30414257  // "WBA0"
+#define WB_ARCHIVE_VERSION   1
+#define WB_ARCHIVE_DICT_MAX  0x10000     // LZ4 window
+
+typedef struct {
+    u32 magic;
+    u16 version;
+    u16 count;              // Index entries, sorted by fuse count
+    u32 dict_size;          // Dictionary follows the index
+    u32 reserved;
+} wb_archive_header_t;
+
+typedef struct {
+    u8 fuses;               // Burnt fuse count of wb_xx.bin
+    u8 reserved[3];
+    u32 offset;             // LZ4 block, from the archive start
+    u32 comp_size;
+    u32 size;               // Decompressed size
+    u32 crc32;              // Of the decompressed data
+} wb_archive_entry_t;
+
+typedef struct {
+    const u8 *data;
+    u32 size;
+    const wb_archive_entry_t *index;
+    u32 count;
+    const u8 *dict;
+    u32 dict_size;
+} wb_archive_t;
+
+// Checks the header and that the index and dictionary fit. data must stay valid and u32 aligned.
+bool wb_archive_open(wb_archive_t *arc, const void *data, u32 size);
+// Returns the index of the entry for fuses, or -1.
+int wb_archive_find(const wb_archive_t *arc, u8 fuses);
+// Decodes entry idx into buf. Returns its size, or 0 if buf is too small or the entry is corrupt.
+u32 wb_archive_read(const wb_archive_t *arc, u32 idx, void *buf, u32 buf_size);
+
+#endif
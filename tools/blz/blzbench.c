@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * blz_uncompress_inplace() benchmark and differential test.
+ * Every BLZ stream is decoded by bdk/libs/compr/blz.c and by the byte copy decoder it
+ * replaced, and both results must match. Streams come from the files given, which are
+ * KIP1 files, INI1 blobs (as found in a decrypted package2) or raw BLZ data with footer.
+ * With -r, random streams are checked too, including broken ones.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libs/compr/blz.h>
+#include "kip1.h"
+
+#define BLZB_SLACK 0x2000 // Broken streams can copy from up to 4 KiB past the end.
+
+typedef struct _blzb_stream_t
+{
+	const u8 *data;
+	u32 comp_size;
+	u32 out_size;
+	char name[48];
+} blzb_stream_t;
+
+static blzb_stream_t *blzb_streams;
+static u32 blzb_count;
+static u32 blzb_failed;
+
+static double _time_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The decoder before the fast paths, copying every segment a byte at a time.
+// Only the control byte bounds check was added, as without it broken streams read out of bounds.
+static int _blz_uncompress_ref(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer)
+{
+	u32 addl_size = footer->addl_size;
+	u32 header_size = footer->header_size;
+	u32 cmp_and_hdr_size = footer->cmp_and_hdr_size;
+
+	unsigned char* cmp_start = &dataBuf[compSize] - cmp_and_hdr_size;
+	u32 cmp_ofs = cmp_and_hdr_size - header_size;
+	u32 out_ofs = cmp_and_hdr_size + addl_size;
+
+	while (out_ofs)
+	{
+		if (cmp_ofs < 1)
+			return 0;
+
+		unsigned char control = cmp_start[--cmp_ofs];
+		for (unsigned int i=0; i<8; i++)
+		{
+			if (control & 0x80)
+			{
+				if (cmp_ofs < 2)
+					return 0;
+
+				cmp_ofs -= 2;
+				u16 seg_val = ((unsigned int)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+				u32 seg_size = ((seg_val >> 12) & 0xF) + 3;
+				u32 seg_ofs = (seg_val & 0x0FFF) + 3;
+				if (out_ofs < seg_size)
+					seg_size = out_ofs;
+
+				out_ofs -= seg_size;
+
+				for (unsigned int j = 0; j < seg_size; j++)
+					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+			}
+			else
+			{
+				if (cmp_ofs < 1)
+					return 0;
+
+				cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+			}
+			control <<= 1;
+			if (out_ofs == 0)
+				return 1;
+		}
+	}
+
+	return 1;
+}
+
+static void _add_stream(const u8 *data, u32 comp_size, u32 out_size, const char *name)
+{
+	blzb_streams = realloc(blzb_streams, sizeof(blzb_stream_t) * (blzb_count + 1));
+	blzb_stream_t *stream = &blzb_streams[blzb_count++];
+
+	stream->data = data;
+	stream->comp_size = comp_size;
+	stream->out_size = out_size;
+	snprintf(stream->name, sizeof(stream->name), "%s", name);
+}
+
+// Adds the compressed sections of a KIP1 and returns its size, or 0 if it is not one.
+static u32 _add_kip(const u8 *data, u32 size)
+{
+	kip1_hdr_t hdr;
+
+	if (size < KIP1_HDR_SZ)
+		return 0;
+	memcpy(&hdr, data, sizeof(hdr));
+	if (hdr.magic != KIP1_MAGIC)
+		return 0;
+
+	u32 pos = KIP1_HDR_SZ;
+	for (u32 i = 0; i < KIP1_SECTIONS; i++)
+	{
+		kip1_section_t *sect = &hdr.sections[i];
+		if (pos + sect->comp_size > size)
+			return 0;
+
+		char name[48];
+		snprintf(name, sizeof(name), "%.12s %s", hdr.name, kip1_section_names[i]);
+		if ((hdr.flags & (1 << i)) && sect->comp_size >= sizeof(blz_footer))
+			_add_stream(data + pos, sect->comp_size, sect->out_size, name);
+		pos += sect->comp_size;
+	}
+
+	return pos;
+}
+
+static void _add_file(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		perror(path);
+		exit(1);
+	}
+
+	fseek(file, 0, SEEK_END);
+	u32 size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 *data = malloc(size ? size : 1);
+	if (fread(data, 1, size, file) != size)
+	{
+		perror(path);
+		exit(1);
+	}
+	fclose(file);
+
+	u32 magic = 0;
+	if (size >= 4)
+		memcpy(&magic, data, 4);
+
+	const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+	if (magic == INI1_MAGIC && size >= INI1_HDR_SZ)
+	{
+		u32 num_kips;
+		memcpy(&num_kips, data + 8, 4);
+
+		u32 pos = INI1_HDR_SZ;
+		for (u32 i = 0; i < num_kips && pos < size; i++)
+		{
+			u32 kip_size = _add_kip(data + pos, size - pos);
+			if (!kip_size)
+				break;
+			pos += kip_size;
+		}
+	}
+	else if (!_add_kip(data, size))
+	{
+		blz_footer footer;
+		if (!blz_get_footer(data, size, &footer) || footer.cmp_and_hdr_size > size ||
+			footer.header_size > footer.cmp_and_hdr_size)
+		{
+			fprintf(stderr, "%s: not a KIP1, INI1 or BLZ file\n", path);
+			exit(1);
+		}
+		_add_stream(data, size, size + footer.addl_size, name);
+	}
+}
+
+// Decodes a stream with both decoders, like blz_uncompress_srcdest() does.
+static int _check(const u8 *data, u32 comp_size, u32 out_size, u8 *buf_ref, u8 *buf)
+{
+	blz_footer footer;
+
+	blz_get_footer(data, comp_size, &footer);
+	memset(buf_ref, 0, out_size + BLZB_SLACK);
+	memcpy(buf_ref, data, comp_size - sizeof(blz_footer));
+	memcpy(buf, buf_ref, out_size + BLZB_SLACK);
+
+	int res_ref = _blz_uncompress_ref(buf_ref, comp_size, &footer);
+	int res = blz_uncompress_inplace(buf, comp_size, &footer);
+
+	return res != res_ref || memcmp(buf, buf_ref, out_size + BLZB_SLACK);
+}
+
+static u32 _rand(u64 *state)
+{
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+	return *state >> 33;
+}
+
+// Random streams of any kind: working or truncated ones, long and short distances, overlaps.
+static void _random_check(u32 count, u64 seed)
+{
+	u8 *data = malloc(0x10000 + 16);
+	u8 *buf_ref = malloc(0x50000 + BLZB_SLACK);
+	u8 *buf = malloc(0x50000 + BLZB_SLACK);
+	u64 state = seed;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 prefix = _rand(&state) % 64;
+		u32 cmp_size = 1 + _rand(&state) % 0x8000;
+		u32 hdr_size = sizeof(blz_footer) + (_rand(&state) & 3);
+		u32 max_dist = (_rand(&state) & 1) ? 0xFFF : (_rand(&state) & 0x1F);
+		u32 comp_size = prefix + cmp_size + hdr_size;
+
+		for (u32 j = 0; j < comp_size; j++)
+			data[j] = _rand(&state);
+		// Mostly references over max_dist, to hit short overlapping copies often enough.
+		for (u32 j = prefix; j + 1 < prefix + cmp_size; j += 2)
+		{
+			u32 seg = _rand(&state);
+			data[j] = (seg & 0xFF) & max_dist;
+			data[j + 1] = ((seg >> 8) & 0xF0) | ((seg >> 8) & 0xF & (max_dist >> 8));
+		}
+
+		blz_footer footer = { cmp_size + hdr_size, hdr_size, cmp_size + _rand(&state) % (cmp_size * 4) };
+		memcpy(data + comp_size - sizeof(blz_footer), &footer, sizeof(footer));
+
+		if (_check(data, comp_size, comp_size + footer.addl_size, buf_ref, buf))
+		{
+			if (blzb_failed < 10)
+				fprintf(stderr, "Random stream %u (seed %llu) decodes differently!\n", i, (unsigned long long)seed);
+			blzb_failed++;
+		}
+	}
+
+	printf("%u random streams checked\n", count);
+
+	free(data);
+	free(buf_ref);
+	free(buf);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: blzbench [-n <runs>] [-r <count>] [-s <seed>] [files]\n"
+		"Files are KIP1, INI1 or raw BLZ data with footer.\n"
+		"  -n <runs>   Decode runs, the best one counts (default: 100)\n"
+		"  -r <count>  Check random streams too (default: 0)\n"
+		"  -s <seed>   Random stream seed (default: 1)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	u32 runs = 100, rand_count = 0;
+	u64 seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': runs = strtoul(optarg, NULL, 0); break;
+		case 'r': rand_count = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	if ((optind == argc && !rand_count) || !runs)
+		_usage();
+
+	for (int i = optind; i < argc; i++)
+		_add_file(argv[i]);
+
+	if (rand_count)
+		_random_check(rand_count, seed);
+
+	if (blzb_count)
+		printf("%-24s %9s %9s %10s %10s %8s\n", "stream", "comp", "out", "byte MB/s", "fast MB/s", "speedup");
+
+	u64 total_out = 0;
+	double total_ref = 0, total_fast = 0;
+	for (u32 i = 0; i < blzb_count; i++)
+	{
+		blzb_stream_t *stream = &blzb_streams[i];
+		u8 *buf_ref = malloc(stream->out_size + BLZB_SLACK);
+		u8 *buf = malloc(stream->out_size + BLZB_SLACK);
+		blz_footer footer;
+
+		if (_check(stream->data, stream->comp_size, stream->out_size, buf_ref, buf))
+		{
+			fprintf(stderr, "%s decodes differently!\n", stream->name);
+			blzb_failed++;
+		}
+
+		// Both start from the same copy of the stream, which blz_uncompress_srcdest() makes.
+		blz_get_footer(stream->data, stream->comp_size, &footer);
+		double secs[2];
+		for (int fast = 0; fast < 2; fast++)
+		{
+			// Best run, the decode is short enough for noise to dominate an average.
+			secs[fast] = 1e9;
+			for (u32 r = 0; r < runs; r++)
+			{
+				memcpy(buf, stream->data, stream->comp_size - sizeof(blz_footer));
+				double start = _time_now();
+				if (fast)
+					blz_uncompress_inplace(buf, stream->comp_size, &footer);
+				else
+					_blz_uncompress_ref(buf, stream->comp_size, &footer);
+				double elapsed = _time_now() - start;
+				if (elapsed < secs[fast])
+					secs[fast] = elapsed;
+			}
+		}
+
+		printf("%-24s %9u %9u %10.1f %10.1f %7.2fx\n", stream->name, stream->comp_size, stream->out_size,
+			stream->out_size / secs[0] / 1e6, stream->out_size / secs[1] / 1e6, secs[0] / secs[1]);
+
+		total_out += stream->out_size;
+		total_ref += secs[0];
+		total_fast += secs[1];
+
+		free(buf_ref);
+		free(buf);
+	}
+
+	if (blzb_count)
+		printf("%-24s %9s %9llu %10.1f %10.1f %7.2fx\n", "all", "", (unsigned long long)total_out,
+			total_out / total_ref / 1e6, total_out / total_fast / 1e6, total_ref / total_fast);
+
+	if (blzb_failed)
+		fprintf(stderr, "%u streams failed\n", blzb_failed);
+
+	return blzb_failed ? 1 : 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libs/compr/blz.h>
+#include "blzenc.h"
+
+#define BLZ_MIN_MATCH  3
+#define BLZ_MAX_MATCH  18   // 4 bit length + 3.
+#define BLZ_MIN_DIST   3
+#define BLZ_MAX_DIST   4098 // 12 bit offset + 3.
+#define BLZ_HASH_BITS  15
+#define BLZ_PAD_BYTE   0xFF
+
+typedef struct _blz_token_t
+{
+	u16 len; // 1 for a literal.
+	u16 dist;
+} blz_token_t;
+
+static inline u32 _blz_hash(const u8 *p)
+{
+	return (((u32)p[0] << 16 | (u32)p[1] << 8 | p[2]) * 2654435761u) >> (32 - BLZ_HASH_BITS);
+}
+
+static u32 _blz_store(const u8 *in, u32 in_size, u8 *out)
+{
+	blz_footer footer = { sizeof(blz_footer), sizeof(blz_footer), -(u32)sizeof(blz_footer) };
+
+	memcpy(out, in, in_size);
+	memcpy(out + in_size, &footer, sizeof(footer));
+
+	return in_size + sizeof(footer);
+}
+
+/*
+ * Decoding starts at the end of the data and works down, so the match finder runs on the
+ * input reversed and the first token is the last input byte. Tokens go in groups of 8 after
+ * a control byte, MSB first. A segment is 2 bytes, (length - 3) << 12 | (distance - 3), and
+ * its copy never overlaps, so its length is at most its distance.
+ */
+u32 blz_compress(const u8 *in, u32 in_size, u8 *out, u32 chain)
+{
+	u8 *rev = malloc(in_size + 1);
+	s32 *head = malloc(sizeof(s32) << BLZ_HASH_BITS);
+	s32 *prev = malloc(sizeof(s32) * (in_size + 1));
+	blz_token_t *tokens = malloc(sizeof(blz_token_t) * (in_size + 1));
+	if (!rev || !head || !prev || !tokens)
+	{
+		free(rev);
+		free(head);
+		free(prev);
+		free(tokens);
+		return 0;
+	}
+
+	for (u32 i = 0; i < in_size; i++)
+		rev[i] = in[in_size - 1 - i];
+	memset(head, 0xFF, sizeof(s32) << BLZ_HASH_BITS);
+
+	u32 pos = 0, num_tokens = 0;
+	s64 saved = 0, best_saved = 0;
+	u32 best_tokens = 0, best_covered = 0;
+	while (pos < in_size)
+	{
+		u32 best_len = 0, best_dist = 0;
+		if (pos + BLZ_MIN_MATCH <= in_size)
+		{
+			u32 max_len = in_size - pos < BLZ_MAX_MATCH ? in_size - pos : BLZ_MAX_MATCH;
+			u32 left = chain ? chain : ~0u;
+			for (s32 cand = head[_blz_hash(rev + pos)]; cand >= 0 && left; cand = prev[cand], left--)
+			{
+				u32 dist = pos - cand;
+				if (dist > BLZ_MAX_DIST)
+					break;
+				if (dist < BLZ_MIN_DIST)
+					continue;
+
+				u32 lim = max_len < dist ? max_len : dist;
+				u32 len = 0;
+				while (len < lim && rev[cand + len] == rev[pos + len])
+					len++;
+
+				if (len > best_len)
+				{
+					best_len = len;
+					best_dist = dist;
+					if (len == max_len)
+						break;
+				}
+			}
+		}
+
+		blz_token_t *token = &tokens[num_tokens];
+		token->len = best_len >= BLZ_MIN_MATCH ? best_len : 1;
+		token->dist = best_dist;
+
+		// Bytes saved so far. A control byte is paid by the first token of its group.
+		saved += (token->len > 1 ? token->len - 2 : 0) - !(num_tokens & 7);
+		num_tokens++;
+
+		for (u32 end = pos + token->len; pos < end; pos++)
+		{
+			if (pos + BLZ_MIN_MATCH > in_size)
+				continue;
+			u32 hash = _blz_hash(rev + pos);
+			prev[pos] = head[hash];
+			head[hash] = pos;
+		}
+
+		/*
+		 * Input below the last token kept is stored raw. Keeping the tokens with the most
+		 * savings gives the smallest output, and it also decodes in place: any run of tokens
+		 * after the first then saves at least what it costs, so writes stay above the input
+		 * still to be read.
+		 */
+		if (saved > best_saved)
+		{
+			best_saved = saved;
+			best_tokens = num_tokens;
+			best_covered = pos;
+		}
+	}
+
+	free(rev);
+	free(head);
+	free(prev);
+
+	// Padding must be paid for too, or the head would not fit in front of the output.
+	if (best_saved < 4)
+	{
+		free(tokens);
+		return _blz_store(in, in_size, out);
+	}
+
+	// Raw head, then the token stream in decode order, reversed after.
+	u32 raw_size = in_size - best_covered;
+	memcpy(out, in, raw_size);
+
+	u8 *cmp = out + raw_size;
+	u32 cmp_size = 0;
+	const u8 *src = in + in_size;
+	for (u32 i = 0; i < best_tokens; i += 8)
+	{
+		u32 ctrl_pos = cmp_size++;
+		u8 ctrl = 0;
+		for (u32 j = i; j < i + 8 && j < best_tokens; j++)
+		{
+			if (tokens[j].len > 1)
+			{
+				u32 seg = ((tokens[j].len - BLZ_MIN_MATCH) << 12) | (tokens[j].dist - BLZ_MIN_DIST);
+				ctrl |= 0x80 >> (j - i);
+				cmp[cmp_size++] = seg >> 8;
+				cmp[cmp_size++] = seg & 0xFF;
+			}
+			else
+				cmp[cmp_size++] = src[-1];
+			src -= tokens[j].len;
+		}
+		cmp[ctrl_pos] = ctrl;
+	}
+	free(tokens);
+
+	for (u32 i = 0; i < cmp_size / 2; i++)
+	{
+		u8 tmp = cmp[i];
+		cmp[i] = cmp[cmp_size - 1 - i];
+		cmp[cmp_size - 1 - i] = tmp;
+	}
+
+	u32 pad = -(raw_size + cmp_size) & 3;
+	memset(cmp + cmp_size, BLZ_PAD_BYTE, pad);
+
+	u32 out_size = raw_size + cmp_size + pad + sizeof(blz_footer);
+	blz_footer footer = { cmp_size + pad + sizeof(blz_footer), pad + sizeof(blz_footer), in_size - out_size };
+	memcpy(out + out_size - sizeof(blz_footer), &footer, sizeof(footer));
+
+	return out_size;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BLZENC_H_
+#define _BLZENC_H_
+
+#include <utils/types.h>
+
+// Output never exceeds the input plus padding and footer.
+#define BLZ_ENC_BOUND(size) ((size) + 16)
+
+/*
+ * Compresses in to the format blz_uncompress_inplace() and the kernel decode: a raw
+ * head, the compressed rest written back to front, padding to 4 bytes and a blz_footer.
+ * The raw head is as short as it can be while the data still decodes in place.
+ * chain is the number of match candidates to check per position, 0 checks all of them.
+ * Returns the compressed size. Input that does not compress is stored with a footer only.
+ */
+u32 blz_compress(const u8 *in, u32 in_size, u8 *out, u32 chain);
+
+#endif
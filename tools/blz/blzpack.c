@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * BLZ compressor, decompressor and KIP1 repacker.
+ * Everything compressed is decoded again with blz_uncompress_srcdest() from
+ * bdk/libs/compr/blz.c and compared to the input before it is written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libs/compr/blz.h>
+#include "blzenc.h"
+#include "kip1.h"
+
+#define BLZP_CHAIN_DEF 16
+
+static u32 blzp_chain = BLZP_CHAIN_DEF;
+
+static double _time_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static u8 *_read_file(const char *path, u32 *size)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 *data = malloc(*size ? *size : 1);
+	if (data && fread(data, 1, *size, file) != *size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+
+	return data;
+}
+
+static int _write_file(const char *path, const u8 *data, u32 size)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+		return 1;
+
+	int res = fwrite(data, 1, size, file) != size;
+
+	return fclose(file) || res;
+}
+
+// Returns the uncompressed size of a BLZ stream, or 0 if its footer does not fit.
+static u32 _blz_out_size(const u8 *comp, u32 comp_size)
+{
+	blz_footer footer;
+
+	if (!blz_get_footer(comp, comp_size, &footer) || footer.header_size < sizeof(blz_footer) ||
+		footer.header_size > footer.cmp_and_hdr_size || footer.cmp_and_hdr_size > comp_size)
+		return 0;
+
+	return comp_size + footer.addl_size;
+}
+
+// Decodes comp with blz.c and compares it to in.
+static int _round_trip(const u8 *in, u32 in_size, const u8 *comp, u32 comp_size)
+{
+	u8 *dec = malloc(in_size + 1);
+	int res = !dec || _blz_out_size(comp, comp_size) != in_size ||
+		!blz_uncompress_srcdest(comp, comp_size, dec, in_size) || memcmp(dec, in, in_size);
+
+	free(dec);
+
+	return res;
+}
+
+static u8 *_compress(const u8 *in, u32 in_size, u32 *comp_size)
+{
+	u8 *comp = malloc(BLZ_ENC_BOUND(in_size));
+	if (!comp)
+		return NULL;
+
+	*comp_size = blz_compress(in, in_size, comp, blzp_chain);
+	if (!*comp_size || _round_trip(in, in_size, comp, *comp_size))
+	{
+		fprintf(stderr, "Compressed data does not decode to the input!\n");
+		free(comp);
+		return NULL;
+	}
+
+	return comp;
+}
+
+static int _cmd_compress(const u8 *in, u32 in_size, const char *out_path)
+{
+	u32 comp_size;
+	u8 *comp = _compress(in, in_size, &comp_size);
+	if (!comp)
+		return 1;
+
+	blz_footer footer;
+	blz_get_footer(comp, comp_size, &footer);
+	printf("%u -> %u bytes (%.3f), %u bytes stored raw\n", in_size, comp_size, (double)comp_size / (in_size ? in_size : 1),
+		comp_size - footer.cmp_and_hdr_size);
+
+	int res = _write_file(out_path, comp, comp_size);
+	free(comp);
+
+	return res;
+}
+
+static int _cmd_decompress(const u8 *comp, u32 comp_size, const char *out_path)
+{
+	u32 out_size = _blz_out_size(comp, comp_size);
+	u8 *out = malloc(out_size + 1);
+
+	if (!out_size || !out || !blz_uncompress_srcdest(comp, comp_size, out, out_size))
+	{
+		fprintf(stderr, "Not a valid BLZ stream\n");
+		return 1;
+	}
+
+	int res = _write_file(out_path, out, out_size);
+	free(out);
+
+	return res;
+}
+
+// Compresses every section with contents again. Sections that do not get smaller are stored.
+static int _cmd_kip(const u8 *kip, u32 kip_size, const char *out_path)
+{
+	kip1_hdr_t hdr;
+
+	if (kip_size >= KIP1_HDR_SZ)
+		memcpy(&hdr, kip, sizeof(hdr));
+	if (kip_size < KIP1_HDR_SZ || hdr.magic != KIP1_MAGIC)
+	{
+		fprintf(stderr, "Not a KIP1\n");
+		return 1;
+	}
+
+	u8 *out = malloc(KIP1_HDR_SZ);
+	u8 *sect_data[KIP1_SECTIONS] = { NULL };
+	u32 pos = KIP1_HDR_SZ, out_pos = KIP1_HDR_SZ;
+	int res = 0;
+
+	for (u32 i = 0; i < KIP1_SECTIONS && !res; i++)
+	{
+		kip1_section_t *sect = &hdr.sections[i];
+		u32 out_size = sect->out_size;
+
+		res = pos + sect->comp_size > kip_size;
+		if (res)
+			break;
+
+		sect_data[i] = malloc(out_size + 1);
+		if (hdr.flags & (1 << i))
+			res = _blz_out_size(kip + pos, sect->comp_size) != out_size ||
+				!blz_uncompress_srcdest(kip + pos, sect->comp_size, sect_data[i], out_size);
+		else if (sect->comp_size == out_size)
+			memcpy(sect_data[i], kip + pos, out_size);
+		else
+			res = 1;
+		pos += sect->comp_size;
+		if (res)
+			break;
+
+		u32 comp_size;
+		u8 *comp = _compress(sect_data[i], out_size, &comp_size);
+		if (!comp)
+		{
+			res = 1;
+			break;
+		}
+
+		out = realloc(out, out_pos + (comp_size > out_size ? comp_size : out_size));
+		if (comp_size < out_size)
+		{
+			memcpy(out + out_pos, comp, comp_size);
+			hdr.flags |= 1 << i;
+		}
+		else
+		{
+			comp_size = out_size;
+			memcpy(out + out_pos, sect_data[i], out_size);
+			hdr.flags &= ~(1 << i);
+		}
+		printf("%-8s %8u -> %8u bytes (was %u)\n", kip1_section_names[i], out_size, comp_size, sect->comp_size);
+
+		sect->comp_size = comp_size;
+		out_pos += comp_size;
+		free(comp);
+	}
+
+	if (res)
+		fprintf(stderr, "Failed to repack the KIP1\n");
+	else
+	{
+		memcpy(out, &hdr, sizeof(hdr));
+		memcpy(out + sizeof(hdr), kip + sizeof(hdr), KIP1_HDR_SZ - sizeof(hdr));
+		printf("%u -> %u bytes\n", kip_size, out_pos);
+		res = _write_file(out_path, out, out_pos);
+	}
+
+	for (u32 i = 0; i < KIP1_SECTIONS; i++)
+		free(sect_data[i]);
+	free(out);
+
+	return res;
+}
+
+// Compression and blz.c decode speed at a few match finder depths.
+static int _cmd_bench(const u8 *in, u32 in_size, u32 runs)
+{
+	static const u32 chains[] = { 1, 4, 16, 64, 0 };
+	u8 *dec = malloc(in_size + 1);
+
+	printf("%u bytes, best of %u runs\n", in_size, runs);
+	printf("%6s %9s %7s %10s %10s\n", "chain", "comp", "ratio", "comp MB/s", "dec MB/s");
+	for (u32 c = 0; c < sizeof(chains) / sizeof(chains[0]); c++)
+	{
+		u32 comp_size = 0;
+		u8 *comp = NULL;
+		double comp_secs = 1e9, dec_secs = 1e9;
+
+		blzp_chain = chains[c];
+		for (u32 r = 0; r < runs; r++)
+		{
+			free(comp);
+			double start = _time_now();
+			comp = _compress(in, in_size, &comp_size);
+			double secs = _time_now() - start;
+			if (!comp)
+				return 1;
+			if (secs < comp_secs)
+				comp_secs = secs;
+		}
+
+		for (u32 r = 0; r < runs; r++)
+		{
+			double start = _time_now();
+			blz_uncompress_srcdest(comp, comp_size, dec, in_size);
+			double secs = _time_now() - start;
+			if (secs < dec_secs)
+				dec_secs = secs;
+		}
+
+		char name[8];
+		snprintf(name, sizeof(name), chains[c] ? "%u" : "all", chains[c]);
+		printf("%6s %9u %7.3f %10.1f %10.1f\n", name, comp_size, (double)comp_size / in_size,
+			in_size / comp_secs / 1e6, in_size / dec_secs / 1e6);
+		free(comp);
+	}
+	printf("Compression time includes the round trip check.\n");
+
+	free(dec);
+
+	return 0;
+}
+
+static u32 _rand(u64 *state)
+{
+	*state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+	return *state >> 33;
+}
+
+// Round trips of random data: noise, runs, short repeats and copies, at sizes from 0 bytes up.
+static int _cmd_random(u32 count, u64 seed)
+{
+	u8 *data = malloc(0x20000);
+	u64 state = seed;
+	u32 failed = 0;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		u32 size = (i < 64) ? i : _rand(&state) % ((_rand(&state) & 1) ? 0x400 : 0x20000);
+		u32 kind = _rand(&state) % 4;
+
+		for (u32 j = 0; j < size; j++)
+		{
+			switch (kind)
+			{
+			case 0:
+				data[j] = _rand(&state);
+				break;
+			case 1:
+				data[j] = (_rand(&state) % 16) ? (j ? data[j - 1] : 0) : _rand(&state);
+				break;
+			case 2:
+				data[j] = "ab\0"[_rand(&state) % 3];
+				break;
+			default:
+				// Copies from up to 5000 bytes back, past the longest distance.
+				if (j > 16 && (_rand(&state) % 4))
+				{
+					u32 dist = 1 + _rand(&state) % (j < 5000 ? j : 5000);
+					u32 len = 1 + _rand(&state) % 24;
+					for (; len && j < size; len--, j++)
+						data[j] = data[j - dist];
+					j--;
+				}
+				else
+					data[j] = _rand(&state) % 64;
+				break;
+			}
+		}
+
+		blzp_chain = _rand(&state) % 3 ? 1 + _rand(&state) % 32 : 0;
+
+		u32 comp_size;
+		u8 *comp = _compress(data, size, &comp_size);
+		if (!comp)
+		{
+			if (failed < 10)
+				fprintf(stderr, "Random data %u (seed %llu) failed\n", i, (unsigned long long)seed);
+			failed++;
+		}
+		free(comp);
+	}
+
+	printf("%u random round trips, %u failed\n", count, failed);
+	free(data);
+
+	return failed ? 1 : 0;
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: blzpack [-l <chain>] [-d | -k] <in> <out>\n"
+		"       blzpack -b [-n <runs>] <in>\n"
+		"       blzpack -r <count> [-s <seed>]\n"
+		"Compresses <in> to BLZ with footer, as in KIP1 sections.\n"
+		"  -l <chain>  Match candidates to check per position, 0 checks all of them\n"
+		"              (default: %u)\n"
+		"  -d          Decompress instead\n"
+		"  -k          Repack a KIP1: compress every section again\n"
+		"  -b          Benchmark compression and decompression at a few -l values\n"
+		"  -n <runs>   Benchmark runs, the best one counts (default: 5)\n"
+		"  -r <count>  Round trip random data\n"
+		"  -s <seed>   Random data seed (default: 1)\n", BLZP_CHAIN_DEF);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	int decompress = 0, kip = 0, bench = 0;
+	u32 runs = 5, rand_count = 0;
+	u64 seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:dkbn:r:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'l': blzp_chain = strtoul(optarg, NULL, 0); break;
+		case 'd': decompress = 1; break;
+		case 'k': kip = 1; break;
+		case 'b': bench = 1; break;
+		case 'n': runs = strtoul(optarg, NULL, 0); break;
+		case 'r': rand_count = strtoul(optarg, NULL, 0); break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	if (rand_count)
+		return optind == argc ? _cmd_random(rand_count, seed) : (_usage(), 1);
+
+	if (decompress + kip + bench > 1 || !runs || optind != argc - 2 + bench)
+		_usage();
+
+	u32 in_size;
+	u8 *in = _read_file(argv[optind], &in_size);
+	if (!in)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	int res;
+	if (bench)
+		res = _cmd_bench(in, in_size, runs);
+	else if (decompress)
+		res = _cmd_decompress(in, in_size, argv[optind + 1]);
+	else if (kip)
+		res = _cmd_kip(in, in_size, argv[optind + 1]);
+	else
+		res = _cmd_compress(in, in_size, argv[optind + 1]);
+
+	free(in);
+
+	return res;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _KIP1_H_
+#define _KIP1_H_
+
+#include <utils/types.h>
+
+#define KIP1_HDR_SZ    0x100
+#define KIP1_MAGIC     0x3150494B // "KIP1".
+#define KIP1_SECTIONS  3          // .text, .rodata and .data have contents, BLZ compressed if flagged.
+#define INI1_HDR_SZ    0x10
+#define INI1_MAGIC     0x31494E49 // "INI1".
+
+typedef struct _kip1_section_t
+{
+	u32 out_offset;
+	u32 out_size;
+	u32 comp_size;
+	u32 attribute;
+} kip1_section_t;
+
+typedef struct _kip1_hdr_t
+{
+	u32 magic;
+	char name[12];
+	u64 tid;
+	u32 category;
+	u8 priority;
+	u8 core;
+	u8 rsvd;
+	u8 flags;     // Bits 0-2: section is compressed.
+	kip1_section_t sections[6];
+	u32 caps[0x20];
+} kip1_hdr_t;
+
+static const char *const kip1_section_names[KIP1_SECTIONS] = { ".text", ".rodata", ".data" };
+
+#endif
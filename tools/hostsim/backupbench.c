@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * BOOT0/BOOT1 backup benchmark.
+ * Runs source/storage/boot_backup.c on generated boot partition images and an SD image,
+ * with both devices waited for in real time, so reads overlap the hash and pack stages
+ * like on the BPMP. The SE hash is replaced by a software SHA256. Host CPU stages are
+ * much faster than the BPMP ones, so slow devices give comparable overlap.
+ *
+ * The packed files are then decompressed and compared to the images, and the manifest
+ * is checked against a one shot hash of each image.
+ */
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libs/compr/lz4f.h>
+#include <libs/fatfs/ff.h>
+#include <sec/se.h>
+#include <sec/se_t210.h>
+#include <storage/nx_sd.h>
+#include <utils/sprintf.h>
+#include "../../source/storage/boot_backup.h"
+#include "../../source/storage/nx_emmc.h"
+#include "hostsim.h"
+
+#define BENCH_PART_SZ  SZ_4M
+#define BENCH_MKFS_BUF SZ_1M
+#define BENCH_SERIAL   0x0BADF00D
+
+static u8 *parts[2];
+static u32 rng = 0x2545F491;
+
+/*
+ * Stand-ins of the payload functions boot_backup.c uses.
+ */
+
+// Real time, the devices are waited for in real time too.
+u32 get_tmr_us()
+{
+	return hostsim_time_us();
+}
+
+u32 s_printf(char *buffer, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	int len = vsprintf(buffer, fmt, ap);
+	va_end(ap);
+
+	return len;
+}
+
+static const u32 sha256_k[64] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void _sha256_block(u32 *state, const u8 *blk)
+{
+	u32 w[64];
+	u32 v[8];
+
+	for (u32 i = 0; i < 16; i++)
+		w[i] = (blk[i * 4] << 24) | (blk[i * 4 + 1] << 16) | (blk[i * 4 + 2] << 8) | blk[i * 4 + 3];
+	for (u32 i = 16; i < 64; i++)
+	{
+		u32 s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		u32 s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	memcpy(v, state, sizeof(v));
+	for (u32 i = 0; i < 64; i++)
+	{
+		u32 t1 = v[7] + (ROR32(v[4], 6) ^ ROR32(v[4], 11) ^ ROR32(v[4], 25)) +
+			((v[4] & v[5]) ^ (~v[4] & v[6])) + sha256_k[i] + w[i];
+		u32 t2 = (ROR32(v[0], 2) ^ ROR32(v[0], 13) ^ ROR32(v[0], 22)) +
+			((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(v + 1, v, 7 * sizeof(u32));
+		v[4] += t1;
+		v[0] = t1 + t2;
+	}
+	for (u32 i = 0; i < 8; i++)
+		state[i] += v[i];
+}
+
+/*
+ * Keeps the SE interface: the intermediate hash is in hash and the bits left in msg_left.
+ * Chunks but the last must be 64 byte multiples. The last one pads and finishes the hash.
+ */
+int se_calc_sha256(void *hash, u32 *msg_left, const void *src, u32 src_size, u64 total_size, u32 sha_cfg, bool is_oneshot)
+{
+	static const u32 sha256_h0[8] = {
+		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+	};
+	u32 state[8];
+	u8 *out = (u8 *)hash;
+	const u8 *data = (const u8 *)src;
+
+	if (!total_size)
+		total_size = src_size;
+
+	u64 left = total_size << 3;
+	if (sha_cfg == SHA_CONTINUE && msg_left)
+	{
+		left = ((u64)msg_left[1] << 32) | msg_left[0];
+		for (u32 i = 0; i < 8; i++)
+			state[i] = (out[i * 4] << 24) | (out[i * 4 + 1] << 16) | (out[i * 4 + 2] << 8) | out[i * 4 + 3];
+	}
+	else
+		memcpy(state, sha256_h0, sizeof(state));
+
+	if ((u64)src_size << 3 > left)
+		return 0;
+
+	u32 full = src_size & ~63;
+	for (u32 off = 0; off < full; off += 64)
+		_sha256_block(state, data + off);
+	left -= (u64)full << 3;
+
+	u32 tail = src_size - full;
+	if (tail || left == ((u64)tail << 3))
+	{
+		// Last chunk.
+		u8 blk[128] = {0};
+		u64 bits = total_size << 3;
+		u32 len = tail < 56 ? 64 : 128;
+
+		memcpy(blk, data + full, tail);
+		blk[tail] = 0x80;
+		for (u32 i = 0; i < 8; i++)
+			blk[len - 1 - i] = bits >> (i * 8);
+		_sha256_block(state, blk);
+		if (len == 128)
+			_sha256_block(state, blk + 64);
+		left = 0;
+	}
+
+	for (u32 i = 0; i < 8; i++)
+	{
+		out[i * 4]     = state[i] >> 24;
+		out[i * 4 + 1] = state[i] >> 16;
+		out[i * 4 + 2] = state[i] >> 8;
+		out[i * 4 + 3] = state[i];
+	}
+
+	if (msg_left)
+	{
+		msg_left[0] = left;
+		msg_left[1] = left >> 32;
+	}
+
+	return 1;
+}
+
+/*
+ * Benchmark.
+ */
+
+static u32 _bench_rand()
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+
+	return rng;
+}
+
+// Boot partitions are mostly erased, with Package1 and BCT like code and encrypted areas.
+static void _bench_gen(u8 *buf, u32 size)
+{
+	u8 pattern[256];
+	for (u32 i = 0; i < sizeof(pattern); i++)
+		pattern[i] = _bench_rand();
+
+	for (u32 pos = 0; pos < size; pos += SZ_4K)
+	{
+		u32 kind = _bench_rand() % 100;
+
+		if (kind < 60)
+			memset(buf + pos, 0, SZ_4K);
+		else if (kind < 80)
+		{
+			for (u32 i = 0; i < SZ_4K; i++)
+				buf[pos + i] = (_bench_rand() & 7) ? pattern[(pos + i) & 0xFF] : (u8)_bench_rand() & 0xF;
+		}
+		else
+		{
+			for (u32 i = 0; i < SZ_4K; i++)
+				buf[pos + i] = _bench_rand();
+		}
+	}
+}
+
+static int _bench_write_file(const char *path, const void *buf, u64 size)
+{
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return 0;
+
+	int res = buf ? write(fd, buf, size) == (ssize_t)size : !ftruncate(fd, size);
+	close(fd);
+
+	return res;
+}
+
+static int _bench_format(const char *path)
+{
+	if (!_bench_write_file(path, NULL, (u64)SZ_1K << 20))
+		return FR_DENIED;
+
+	if (!hostsim_attach(&sd_storage, 0, path, 1) || !sd_initialize(false))
+		return FR_NOT_READY;
+
+	void *work = malloc(BENCH_MKFS_BUF);
+	int res = f_mkfs("sd:", FM_EXFAT, 0, work, BENCH_MKFS_BUF);
+	free(work);
+
+	sdmmc_storage_end(&sd_storage);
+
+	return res;
+}
+
+// Decompresses the packed partitions and checks them and the manifest.
+static int _bench_verify()
+{
+	FIL fp;
+	lz4f_t lz;
+	char path[64];
+	char line[80];
+	u32 hash[SE_SHA_256_SIZE / 4];
+	u32 br;
+
+	u8 *buf = malloc(BENCH_PART_SZ + 1);
+	char *manifest = sd_file_read(BOOT_BACKUP_DIR "/0BADF00D/" BOOT_BACKUP_MANIFEST, NULL);
+	int res = manifest ? FR_OK : FR_NO_FILE;
+
+	for (u32 i = 0; !res && i < 2; i++)
+	{
+		s_printf(path, BOOT_BACKUP_DIR "/%08X/BOOT%d.lz4", BENCH_SERIAL, i);
+		res = f_open(&fp, path, FA_READ);
+		if (res)
+			break;
+
+		res = lz4f_read_open(&lz, &fp);
+		if (!res)
+			res = lz4f_read(&lz, buf, BENCH_PART_SZ + 1, &br);
+		lz4f_read_close(&lz);
+		f_close(&fp);
+
+		if (!res && (br != BENCH_PART_SZ || memcmp(buf, parts[i], BENCH_PART_SZ)))
+		{
+			fprintf(stderr, "backupbench: BOOT%d data mismatch\n", i);
+			res = FR_INT_ERR;
+		}
+
+		se_calc_sha256(hash, NULL, parts[i], BENCH_PART_SZ, 0, SHA_INIT_HASH, true);
+		char *pos = line;
+		for (u32 j = 0; j < SE_SHA_256_SIZE; j++)
+			pos += s_printf(pos, "%02x", ((u8 *)hash)[j]);
+		s_printf(pos, "  BOOT%d\n", i);
+
+		if (!res && !strstr(manifest, line))
+		{
+			fprintf(stderr, "backupbench: BOOT%d hash mismatch\n", i);
+			res = FR_INT_ERR;
+		}
+	}
+
+	free(manifest);
+	free(buf);
+
+	return res;
+}
+
+static u32 _bench_mbps(u32 bytes, u32 us)
+{
+	return us ? bytes / us : 0;
+}
+
+static void _bench_print(const boot_backup_stats_t *st)
+{
+	u32 stages = 0;
+	for (u32 i = 0; i < BOOT_BACKUP_STAGES; i++)
+		stages += st->stage_us[i];
+
+	printf("%u KiB -> %u KiB, %s drain\n", st->bytes / SZ_1K, st->packed / SZ_1K,
+		hostsim_cfg.drain_all ? "global" : "per device");
+	printf("  %-10s %10s %8s\n", "stage", "ms", "MB/s");
+	printf("  %-10s %10.1f %8u\n", "read", st->stage_us[BOOT_BACKUP_STAGE_READ] / 1000.0,
+		_bench_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_READ]));
+	printf("  %-10s %10.1f %8u\n", "hash", st->stage_us[BOOT_BACKUP_STAGE_HASH] / 1000.0,
+		_bench_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_HASH]));
+	printf("  %-10s %10.1f %8u\n", "pack", st->stage_us[BOOT_BACKUP_STAGE_PACK] / 1000.0,
+		_bench_mbps(st->bytes, st->stage_us[BOOT_BACKUP_STAGE_PACK]));
+	printf("  %-10s %10.1f\n", "read wait", st->read_wait_us / 1000.0);
+	printf("  %-10s %10.1f %8u\n", "total", st->total_us / 1000.0, _bench_mbps(st->bytes, st->total_us));
+	printf("  %-10s %10.1f (%.0f%% of the stages hidden)\n", "stage sum", stages / 1000.0,
+		stages ? 100.0 * (stages - MIN(stages, st->total_us)) / stages : 0.0);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: backupbench [options]\n"
+		"Creates %u MiB BOOT0/BOOT1 images and a 1 GiB exFAT SD image, backs them up and\n"
+		"deletes them.\n"
+		"  -e <us>:<ns>  eMMC command latency and transfer time per sector (default: %u:%u)\n"
+		"  -s <us>:<ns>  SD command latency and transfer time per sector (default: %u:%u)\n"
+		"  -g            Blocking calls drain the queued requests of all devices\n"
+		"  -d <dir>      Directory for the images (default: .)\n",
+		BENCH_PART_SZ / SZ_1M, 100, 5000, 500, 20000);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dir = ".";
+	char paths[4][256];
+	u32 emmc_lat = 100, emmc_ns = 5000, sd_lat = 500, sd_ns = 20000;
+	boot_backup_stats_t st;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "e:s:gd:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'e':
+			if (sscanf(optarg, "%u:%u", &emmc_lat, &emmc_ns) != 2)
+				_usage();
+			break;
+		case 's':
+			if (sscanf(optarg, "%u:%u", &sd_lat, &sd_ns) != 2)
+				_usage();
+			break;
+		case 'g': hostsim_cfg.drain_all = 1; break;
+		case 'd': dir = optarg; break;
+		default: _usage();
+		}
+	}
+
+	if (optind != argc)
+		_usage();
+
+	snprintf(paths[0], sizeof(paths[0]), "%s/backupbench_sd.img", dir);
+	snprintf(paths[1], sizeof(paths[1]), "%s/backupbench_gpp.img", dir);
+	snprintf(paths[2], sizeof(paths[2]), "%s/backupbench_boot0.img", dir);
+	snprintf(paths[3], sizeof(paths[3]), "%s/backupbench_boot1.img", dir);
+
+	for (u32 i = 0; i < 2; i++)
+	{
+		parts[i] = malloc(BENCH_PART_SZ);
+		_bench_gen(parts[i], BENCH_PART_SZ);
+	}
+
+	int res = _bench_format(paths[0]);
+	if (!res && (!_bench_write_file(paths[1], NULL, SZ_1M) || !_bench_write_file(paths[2], parts[0], BENCH_PART_SZ) ||
+		!_bench_write_file(paths[3], parts[1], BENCH_PART_SZ)))
+		res = FR_DENIED;
+	if (!res && (!hostsim_attach(&emmc_storage, EMMC_GPP, paths[1], 0) ||
+		!hostsim_attach(&emmc_storage, EMMC_BOOT0, paths[2], 0) || !hostsim_attach(&emmc_storage, EMMC_BOOT1, paths[3], 0) ||
+		!sdmmc_storage_init_mmc(&emmc_storage, &emmc_sdmmc, SDMMC_BUS_WIDTH_8, SDHCI_TIMING_MMC_HS400)))
+		res = FR_NOT_READY;
+	if (!res && !sd_mount())
+		res = FR_NO_FILESYSTEM;
+	if (res)
+	{
+		fprintf(stderr, "backupbench: setup failed (FatFs error %d)\n", res);
+		return 1;
+	}
+
+	emmc_storage.ext_csd.boot_mult = BENCH_PART_SZ / SZ_128K;
+	emmc_storage.cid.serial = BENCH_SERIAL;
+
+	hostsim_set_timing(&emmc_storage, emmc_lat, emmc_ns);
+	hostsim_set_timing(&sd_storage, sd_lat, sd_ns);
+	hostsim_cfg.realtime = 1;
+
+	res = boot_backup_save(&st);
+
+	hostsim_cfg.realtime = 0;
+	if (!res)
+		res = _bench_verify();
+
+	sd_unmount();
+	sdmmc_storage_end(&emmc_storage);
+	hostsim_detach_all();
+	for (u32 i = 0; i < 4; i++)
+		unlink(paths[i]);
+
+	if (res)
+	{
+		fprintf(stderr, "backupbench: backup failed (FatFs error %d)\n", res);
+		return 1;
+	}
+
+	_bench_print(&st);
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// bdk globals and functions the storage stack links against.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gfx_utils.h>
+#include <libs/fatfs/diskio.h>
+#include "../../source/storage/nx_emmc_bis.h"
+#include "hostsim.h"
+
+gfx_con_t gfx_con;
+sdmmc_t emmc_sdmmc;
+sdmmc_storage_t emmc_storage;
+sdmmc_storage_t bis_storage;
+
+// Console output of bdk code. Color arguments (%k) are dropped.
+void gfx_printf(const char *fmt, ...)
+{
+	char spec[16];
+	va_list ap;
+
+	va_start(ap, fmt);
+	while (*fmt)
+	{
+		if (*fmt != '%')
+		{
+			fputc(*fmt++, stderr);
+			continue;
+		}
+
+		// Copy flags, width and length modifiers.
+		u32 len = 0;
+		spec[len++] = *fmt++;
+		while (*fmt && strchr("0123456789-+ #.l", *fmt) && len < sizeof(spec) - 2)
+			spec[len++] = *fmt++;
+		char conv = *fmt ? *fmt++ : '%';
+		spec[len++] = conv;
+		spec[len] = 0;
+
+		int is_long = strchr(spec, 'l') != NULL;
+		switch (conv)
+		{
+		case 'k':
+			va_arg(ap, u32);
+			break;
+		case 's':
+			fprintf(stderr, spec, va_arg(ap, const char *));
+			break;
+		case 'p':
+			fprintf(stderr, spec, va_arg(ap, void *));
+			break;
+		case '%':
+			fputc('%', stderr);
+			break;
+		default:
+			if (is_long)
+				fprintf(stderr, spec, va_arg(ap, long));
+			else
+				fprintf(stderr, spec, va_arg(ap, int));
+			break;
+		}
+	}
+	va_end(ap);
+}
+
+int nx_emmc_bis_read(u32 sector, u32 count, void *buff)
+{
+	return sdmmc_storage_read(&bis_storage, sector, count, buff) ? RES_OK : RES_ERROR;
+}
+
+int nx_emmc_bis_write(u32 sector, u32 count, void *buff)
+{
+	return sdmmc_storage_write(&bis_storage, sector, count, buff) ? RES_OK : RES_ERROR;
+}
+
+int nx_emmc_bis_trim(u32 sector, u32 count)
+{
+	return sdmmc_storage_erase(&bis_storage, sector, count) ? RES_OK : RES_ERROR;
+}
+
+u32 nx_emmc_bis_get_sector_count()
+{
+	return bis_storage.sec_cnt;
+}
+
+void nx_emmc_bis_finalize() {}
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * DMA pool benchmark.
+ * Runs small file workloads with the FATFS and FIL objects in BSS, which is IRAM on the
+ * BPMP, and in DMA pool buffers, and counts the bounce copies of the host sdmmc backend.
+ * FatFs reads its window and the partial sectors of a file into these objects, so in
+ * IRAM every such read is copied through the upper buffer.
+ *
+ * Every test remounts first, so it starts with cold FatFs and sector caches.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libs/fatfs/ff.h>
+#include <mem/dma_pool.h>
+#include <storage/nx_sd.h>
+#include "hostsim.h"
+
+#define BENCH_DIR      "sd:/dmabench"
+#define BENCH_MKFS_BUF SZ_1M
+#define BENCH_REC_MAX  SZ_4K
+
+enum
+{
+	BENCH_STAT = 0,
+	BENCH_READ,
+	BENCH_WRITE,
+	BENCH_MAX
+};
+
+static const char *bench_names[BENCH_MAX] = { "stat", "read", "write" };
+
+typedef struct _bench_result_t
+{
+	int res;
+	u64 host_us;
+	u64 dev_us;
+	u64 reads;
+	u64 bounces;
+	u64 sectors_bounced;
+	u64 bounce_ns;
+} bench_result_t;
+
+typedef struct _bench_snap_t
+{
+	hostsim_stats_t stats;
+	u64 time;
+} bench_snap_t;
+
+static u32 files = 256;
+static u32 file_size = 3000;
+static u32 rec_size = 64;
+static u8 *rec; // Heap, so only the FatFs objects differ.
+
+// IRAM placement.
+static FATFS bss_fs;
+static FIL bss_fil;
+
+static void _bench_start(bench_snap_t *snap)
+{
+	snap->stats = hostsim_stats;
+	snap->time = hostsim_time_us();
+}
+
+static void _bench_stop(bench_result_t *result, const bench_snap_t *snap)
+{
+	result->host_us = hostsim_time_us() - snap->time;
+	result->dev_us = hostsim_stats.busy_us - snap->stats.busy_us;
+	result->reads = hostsim_stats.reads - snap->stats.reads;
+	result->bounces = hostsim_stats.bounces - snap->stats.bounces;
+	result->sectors_bounced = hostsim_stats.sectors_bounced - snap->stats.sectors_bounced;
+	result->bounce_ns = hostsim_stats.bounce_ns - snap->stats.bounce_ns;
+
+	if (hostsim_cfg.realtime)
+		result->host_us -= MIN(result->dev_us, result->host_us);
+}
+
+static int _bench_remount(FATFS *fs)
+{
+	sd_unmount();
+	sd_fs = fs;
+
+	return sd_mount() ? FR_OK : FR_NOT_READY;
+}
+
+static void _bench_path(char *path, u32 idx)
+{
+	snprintf(path, 64, BENCH_DIR "/file_%05u.bin", idx);
+}
+
+static int _bench_stat(bench_result_t *result, FATFS *fs)
+{
+	FILINFO fno;
+	char path[64];
+	bench_snap_t snap;
+
+	int res = _bench_remount(fs);
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < files; i++)
+	{
+		_bench_path(path, i);
+		res = f_stat(path, &fno);
+	}
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+// Reads or rewrites every file in records, like config and save files are handled.
+static int _bench_rw(bench_result_t *result, FATFS *fs, FIL *fp, int is_write)
+{
+	UINT bytes;
+	char path[64];
+	bench_snap_t snap;
+
+	int res = _bench_remount(fs);
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < files; i++)
+	{
+		_bench_path(path, i);
+		res = f_open(fp, path, is_write ? (FA_OPEN_EXISTING | FA_WRITE) : FA_READ);
+		for (u32 pos = 0; !res && pos < file_size; pos += rec_size)
+		{
+			u32 size = MIN(file_size - pos, rec_size);
+			res = is_write ? f_write(fp, rec, size, &bytes) : f_read(fp, rec, size, &bytes);
+			if (!res && bytes != size)
+				res = FR_INT_ERR;
+		}
+		if (!res)
+			res = f_close(fp);
+	}
+
+	// Writes reach the card on unmount.
+	if (!res && is_write)
+		sd_unmount();
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_setup()
+{
+	FIL fp;
+	UINT bw;
+	char path[64];
+
+	int res = f_mkdir(BENCH_DIR);
+	for (u32 i = 0; !res && i < files; i++)
+	{
+		_bench_path(path, i);
+		res = f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE);
+		for (u32 pos = 0; !res && pos < file_size; pos += rec_size)
+		{
+			u32 size = MIN(file_size - pos, rec_size);
+			res = f_write(&fp, rec, size, &bw);
+		}
+		if (!res)
+			res = f_close(&fp);
+	}
+
+	return res;
+}
+
+static int _bench_cleanup(FATFS *fs)
+{
+	char path[64];
+
+	int res = _bench_remount(fs);
+	for (u32 i = 0; !res && i < files; i++)
+	{
+		_bench_path(path, i);
+		res = f_unlink(path);
+	}
+
+	return res ? res : f_unlink(BENCH_DIR);
+}
+
+static int _bench_format(const char *path, u32 size_mib)
+{
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)size_mib << 20))
+	{
+		if (fd >= 0)
+			close(fd);
+		return FR_DENIED;
+	}
+	close(fd);
+
+	if (!hostsim_attach(&sd_storage, 0, path, 1) || !sd_initialize(false))
+		return FR_NOT_READY;
+
+	void *work = malloc(BENCH_MKFS_BUF);
+	int res = f_mkfs("sd:", FM_EXFAT, 0, work, BENCH_MKFS_BUF);
+	free(work);
+
+	sdmmc_storage_end(&sd_storage);
+
+	return res;
+}
+
+static void _bench_print(const char *place, const bench_result_t *results)
+{
+	for (u32 i = 0; i < BENCH_MAX; i++)
+	{
+		const bench_result_t *r = &results[i];
+		if (r->res)
+		{
+			printf("  %-5s %-6s failed (FatFs error %d)\n", place, bench_names[i], r->res);
+			continue;
+		}
+
+		printf("  %-5s %-6s %10.1f %10.1f %8llu %8llu %10llu %10.1f\n", place, bench_names[i],
+			r->host_us / 1000.0, r->dev_us / 1000.0, (unsigned long long)r->reads,
+			(unsigned long long)r->bounces, (unsigned long long)r->sectors_bounced, r->bounce_ns / 1000.0);
+	}
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: dmabench [options] [image]\n"
+		"A given image must be formatted and is opened writable. The benchmark uses and then\n"
+		"removes " BENCH_DIR ". Without an image, a 1 GiB exFAT image is created and deleted.\n"
+		"  -N <files>  Files (default: %u)\n"
+		"  -s <bytes>  File size (default: %u)\n"
+		"  -R <bytes>  Record size of reads and writes, up to %u (default: %u)\n"
+		"  -d <dir>    Directory for the created image (default: .)\n"
+		"  -l <us>     Command latency\n"
+		"  -t <ns>     Transfer time per sector\n"
+		"  -r          Wait for latencies in real time\n",
+		files, file_size, BENCH_REC_MAX, rec_size);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	bench_result_t iram[BENCH_MAX] = {0}, pool[BENCH_MAX] = {0};
+	const char *dir = ".";
+	char img_path[256];
+	int opt;
+
+	while ((opt = getopt(argc, argv, "N:s:R:d:l:t:r")) != -1)
+	{
+		switch (opt)
+		{
+		case 'N': files = strtoul(optarg, NULL, 0); break;
+		case 's': file_size = strtoul(optarg, NULL, 0); break;
+		case 'R': rec_size = strtoul(optarg, NULL, 0); break;
+		case 'd': dir = optarg; break;
+		case 'l': hostsim_cfg.cmd_latency_us = strtoul(optarg, NULL, 0); break;
+		case 't': hostsim_cfg.sector_ns = strtoul(optarg, NULL, 0); break;
+		case 'r': hostsim_cfg.realtime = 1; break;
+		default: _usage();
+		}
+	}
+
+	if (optind < argc - 1 || !files || files > 99999 || !rec_size || rec_size > BENCH_REC_MAX)
+		_usage();
+
+	rec = malloc(BENCH_REC_MAX);
+	for (u32 i = 0; i < BENCH_REC_MAX; i++)
+		rec[i] = i * 7;
+
+	FATFS *pool_fs = (FATFS *)dma_pool_alloc();
+	FIL *pool_fil = (FIL *)dma_pool_alloc();
+
+	int res;
+	bool created = optind == argc;
+	if (created)
+	{
+		snprintf(img_path, sizeof(img_path), "%s/dmabench.img", dir);
+		res = _bench_format(img_path, SZ_1K);
+	}
+	else
+	{
+		snprintf(img_path, sizeof(img_path), "%s", argv[optind]);
+		res = hostsim_attach(&sd_storage, 0, img_path, 1) ? FR_OK : FR_NOT_READY;
+	}
+	if (!res)
+		res = _bench_remount(pool_fs);
+	if (!res)
+		res = _bench_setup();
+	if (res)
+	{
+		fprintf(stderr, "dmabench: %s: FatFs error %d%s\n", img_path, res,
+			res == FR_EXIST ? ", remove " BENCH_DIR " first" : "");
+		return 1;
+	}
+
+	iram[BENCH_STAT].res  = _bench_stat(&iram[BENCH_STAT], &bss_fs);
+	iram[BENCH_READ].res  = _bench_rw(&iram[BENCH_READ], &bss_fs, &bss_fil, 0);
+	iram[BENCH_WRITE].res = _bench_rw(&iram[BENCH_WRITE], &bss_fs, &bss_fil, 1);
+	pool[BENCH_STAT].res  = _bench_stat(&pool[BENCH_STAT], pool_fs);
+	pool[BENCH_READ].res  = _bench_rw(&pool[BENCH_READ], pool_fs, pool_fil, 0);
+	pool[BENCH_WRITE].res = _bench_rw(&pool[BENCH_WRITE], pool_fs, pool_fil, 1);
+
+	if (!created && _bench_cleanup(pool_fs))
+		fprintf(stderr, "dmabench: failed to clean up " BENCH_DIR " on %s\n", img_path);
+
+	sd_unmount();
+	hostsim_detach_all();
+	if (created)
+		unlink(img_path);
+	free(rec);
+
+	printf("%u files of %u bytes, %u byte records\n", files, file_size, rec_size);
+	printf("  %-5s %-6s %10s %10s %8s %8s %10s %10s\n", "place", "test", "host ms", "dev ms", "reads",
+		"bounces", "sectors", "copy us");
+	_bench_print("iram", iram);
+	_bench_print("pool", pool);
+
+	for (u32 i = 0; i < BENCH_MAX; i++)
+		res |= iram[i].res | pool[i].res;
+
+	return res ? 1 : 0;
+}
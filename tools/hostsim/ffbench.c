@@ -0,0 +1,810 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * FatFs benchmark.
+ * Runs the payload FatFs build through diskio and the host sdmmc backend on SD
+ * images, and measures file and directory operations. Images are either given
+ * formatted, or created sparse and formatted with f_mkfs().
+ *
+ * Every test reports host time, which is the FatFs and cache CPU cost, plus the
+ * simulated device time and the commands and sectors that reached the card.
+ * Read tests remount first, so they start with cold FatFs and sector caches.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libs/fatfs/diskio.h>
+#include <libs/fatfs/ff.h>
+#include <storage/nx_sd.h>
+#include "hostsim.h"
+
+#define BENCH_DIR        "sd:/ffbench"
+#define BENCH_MAX_IMAGES 16
+#define BENCH_MKFS_BUF   SZ_1M
+#define BENCH_FRAG_HOLE  64 // One free cluster per this many in fragmented areas.
+
+enum
+{
+	BENCH_SEQ_WRITE = 0,
+	BENCH_SEQ_READ,
+	BENCH_RAND_WRITE,
+	BENCH_RAND_READ,
+	BENCH_MKDIR,
+	BENCH_DIR_ENUM,
+	BENCH_STAT,
+	BENCH_OPEN,
+	BENCH_OPEN_DEEP,
+	BENCH_EXPAND,
+	BENCH_MAX
+};
+
+static const char *bench_names[BENCH_MAX] = {
+	"seq_write", "seq_read", "rand_write", "rand_read", "mkdir", "dir_enum", "stat", "open", "open_deep", "expand"
+};
+
+typedef struct _bench_cfg_t
+{
+	u32 seq_mb;
+	u32 seq_blk_kb;
+	u32 rand_ops;
+	u32 rand_blk_kb;
+	u32 entries;
+	u32 lookups;
+	u32 depth;
+	u32 opens;
+	u32 frag_pct;
+} bench_cfg_t;
+
+typedef struct _bench_result_t
+{
+	int res;
+	u64 ops;
+	u64 bytes;
+	u64 host_us;
+	u64 dev_us;
+	u64 cmds;
+	u64 sectors;
+} bench_result_t;
+
+typedef struct _bench_image_t
+{
+	char path[256];
+	u32 size_mib;
+	u32 mkfs_opt;  // FM_* format of -m images. 0 for given images.
+	u32 fs_type;
+	u32 cluster_kb;
+	int created;
+	int res;
+	bench_result_t results[BENCH_MAX];
+} bench_image_t;
+
+typedef struct _bench_snap_t
+{
+	hostsim_stats_t stats;
+	u64 time;
+} bench_snap_t;
+
+static bench_cfg_t cfg = {
+	.seq_mb      = 64,
+	.seq_blk_kb  = 64,
+	.rand_ops    = 4096,
+	.rand_blk_kb = 4,
+	.entries     = 5000,
+	.lookups     = 2000,
+	.depth       = 16,
+	.opens       = 1000,
+	.frag_pct    = 0
+};
+
+static bench_image_t images[BENCH_MAX_IMAGES];
+static u32 image_cnt;
+static u32 rng = 0x2545F491;
+static u8 *buf;
+
+static u32 _bench_rand()
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+
+	return rng;
+}
+
+static void _bench_start(bench_snap_t *snap)
+{
+	snap->stats = hostsim_stats;
+	snap->time = hostsim_time_us();
+}
+
+static void _bench_stop(bench_result_t *result, const bench_snap_t *snap)
+{
+	result->host_us = hostsim_time_us() - snap->time;
+	result->dev_us  = hostsim_stats.busy_us - snap->stats.busy_us;
+	result->cmds    = (hostsim_stats.reads + hostsim_stats.writes + hostsim_stats.trims) -
+					  (snap->stats.reads + snap->stats.writes + snap->stats.trims);
+	result->sectors = (hostsim_stats.sectors_read + hostsim_stats.sectors_written) -
+					  (snap->stats.sectors_read + snap->stats.sectors_written);
+
+	// In real time mode device time is already part of host time.
+	if (hostsim_cfg.realtime)
+		result->host_us -= MIN(result->dev_us, result->host_us);
+}
+
+static int _bench_remount()
+{
+	sd_unmount();
+
+	return sd_mount() ? FR_OK : FR_NOT_READY;
+}
+
+static int _bench_seq(bench_result_t *result, int is_write)
+{
+	FIL fp;
+	UINT bytes;
+	bench_snap_t snap;
+	u32 blk = cfg.seq_blk_kb * SZ_1K;
+	u64 total = (u64)cfg.seq_mb * SZ_1M;
+
+	int res = is_write ? FR_OK : _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	res = f_open(&fp, BENCH_DIR "/seq.bin", is_write ? (FA_CREATE_ALWAYS | FA_WRITE) : FA_READ);
+	for (u64 pos = 0; !res && pos < total; pos += blk)
+	{
+		res = is_write ? f_write(&fp, buf, blk, &bytes) : f_read(&fp, buf, blk, &bytes);
+		if (!res && bytes != blk)
+			res = is_write ? FR_DENIED : FR_INT_ERR;
+		result->ops++;
+		result->bytes += bytes;
+	}
+	if (!res)
+		res = f_close(&fp);
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_rand_io(bench_result_t *result, int is_write)
+{
+	FIL fp;
+	UINT bytes;
+	bench_snap_t snap;
+	u32 blk = cfg.rand_blk_kb * SZ_1K;
+	u32 blocks = ((u64)cfg.seq_mb * SZ_1M) / blk;
+
+	int res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	res = f_open(&fp, BENCH_DIR "/seq.bin", is_write ? (FA_OPEN_EXISTING | FA_WRITE) : FA_READ);
+	for (u32 i = 0; !res && i < cfg.rand_ops; i++)
+	{
+		res = f_lseek(&fp, (FSIZE_t)(_bench_rand() % blocks) * blk);
+		if (!res)
+			res = is_write ? f_write(&fp, buf, blk, &bytes) : f_read(&fp, buf, blk, &bytes);
+		if (!res && bytes != blk)
+			res = FR_INT_ERR;
+		result->ops++;
+		result->bytes += bytes;
+	}
+	if (!res)
+		res = f_close(&fp);
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_mkdir(bench_result_t *result)
+{
+	char path[128];
+	bench_snap_t snap;
+
+	int res = f_mkdir(BENCH_DIR "/dirs");
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < cfg.entries; i++)
+	{
+		snprintf(path, sizeof(path), BENCH_DIR "/dirs/directory_%05u", i);
+		res = f_mkdir(path);
+		result->ops++;
+	}
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_dir_enum(bench_result_t *result)
+{
+	DIR dir;
+	FILINFO fno;
+	bench_snap_t snap;
+
+	int res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	res = f_opendir(&dir, BENCH_DIR "/dirs");
+	while (!res && !(res = f_readdir(&dir, &fno)) && fno.fname[0])
+		result->ops++;
+	if (!res)
+		res = f_closedir(&dir);
+
+	_bench_stop(result, &snap);
+
+	if (!res && result->ops != cfg.entries)
+		res = FR_INT_ERR;
+
+	return res;
+}
+
+// Looks up random directories of the mkdir test. Every 8th name does not exist.
+static int _bench_stat(bench_result_t *result)
+{
+	char path[128];
+	FILINFO fno;
+	bench_snap_t snap;
+
+	int res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < cfg.lookups; i++)
+	{
+		u32 idx = _bench_rand() % cfg.entries;
+		int miss = (i % 8) == 7;
+
+		snprintf(path, sizeof(path), BENCH_DIR "/dirs/%s_%05u", miss ? "missing" : "directory", idx);
+		res = f_stat(path, &fno);
+		if (miss)
+			res = (res == FR_NO_FILE) ? FR_OK : FR_INT_ERR;
+		result->ops++;
+	}
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+// Opens random files of a directory with -N files.
+static int _bench_open(bench_result_t *result)
+{
+	FIL fp;
+	char path[128];
+	bench_snap_t snap;
+
+	// Create the files untimed.
+	int res = f_mkdir(BENCH_DIR "/files");
+	for (u32 i = 0; !res && i < cfg.entries; i++)
+	{
+		snprintf(path, sizeof(path), BENCH_DIR "/files/file_%05u.bin", i);
+		res = f_open(&fp, path, FA_CREATE_NEW | FA_WRITE);
+		if (!res)
+			res = f_close(&fp);
+	}
+	if (!res)
+		res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < cfg.lookups; i++)
+	{
+		snprintf(path, sizeof(path), BENCH_DIR "/files/file_%05u.bin", _bench_rand() % cfg.entries);
+		res = f_open(&fp, path, FA_READ);
+		if (!res)
+			res = f_close(&fp);
+		result->ops++;
+	}
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_open_deep(bench_result_t *result)
+{
+	FIL fp;
+	char path[1024];
+	bench_snap_t snap;
+
+	// Build the tree untimed.
+	strcpy(path, BENCH_DIR "/deep");
+	int res = f_mkdir(path);
+	for (u32 i = 0; !res && i < cfg.depth; i++)
+	{
+		snprintf(path + strlen(path), 32, "/level_%02u", i);
+		res = f_mkdir(path);
+	}
+	strcat(path, "/leaf.bin");
+	if (!res)
+		res = f_open(&fp, path, FA_CREATE_NEW | FA_WRITE);
+	if (!res)
+		res = f_close(&fp);
+	if (!res)
+		res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	for (u32 i = 0; !res && i < cfg.opens; i++)
+	{
+		res = f_open(&fp, path, FA_READ);
+		if (!res)
+			res = f_close(&fp);
+		result->ops++;
+	}
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_expand(bench_result_t *result)
+{
+	FIL fp;
+	bench_snap_t snap;
+
+	_bench_start(&snap);
+
+	int res = f_open(&fp, BENCH_DIR "/expand.bin", FA_CREATE_ALWAYS | FA_WRITE);
+	if (!res)
+	{
+		res = f_expand(&fp, (FSIZE_t)cfg.seq_mb * SZ_1M, 1);
+		f_close(&fp);
+	}
+	result->ops++;
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+/*
+ * Marks the first frag_pct percent of clusters in use on the exFAT bitmap, except one
+ * hole every BENCH_FRAG_HOLE clusters. Like a nearly full card, allocations have to
+ * skip long used runs and single cluster holes. Files do not own these clusters, so
+ * this is only done on created images.
+ */
+static int _bench_fragment()
+{
+	u8 sect[512];
+	FATFS *fs = sd_fs;
+
+	if (fs->fs_type != FS_EXFAT)
+	{
+		fprintf(stderr, "ffbench: fragmentation is only supported on exFAT\n");
+		return FR_OK;
+	}
+
+	u32 used = (u64)(fs->n_fatent - 2) * cfg.frag_pct / 100;
+	for (u32 bit = 0; bit < used; bit += sizeof(sect) * 8)
+	{
+		u32 sector = fs->bitbase + bit / (sizeof(sect) * 8);
+		if (disk_read(fs->pdrv, sect, sector, 1))
+			return FR_DISK_ERR;
+
+		for (u32 i = bit; i < used && i < bit + sizeof(sect) * 8; i++)
+			if (i % BENCH_FRAG_HOLE != BENCH_FRAG_HOLE - 1)
+				sect[(i / 8) % sizeof(sect)] |= BIT(i % 8);
+
+		if (disk_write(fs->pdrv, sect, sector, 1))
+			return FR_DISK_ERR;
+	}
+
+	return _bench_remount();
+}
+
+static int _bench_rm_tree(char *path, u32 len)
+{
+	DIR dir;
+	FILINFO fno;
+
+	int res = f_opendir(&dir, path);
+	while (!res && !(res = f_readdir(&dir, &fno)) && fno.fname[0])
+	{
+		if (len + 1 + strlen(fno.fname) >= 1024)
+		{
+			res = FR_INVALID_NAME;
+			break;
+		}
+
+		path[len] = '/';
+		strcpy(path + len + 1, fno.fname);
+
+		if (fno.fattrib & AM_DIR)
+			res = _bench_rm_tree(path, len + 1 + strlen(fno.fname));
+		else
+			res = f_unlink(path);
+
+		path[len] = 0;
+	}
+	f_closedir(&dir);
+
+	return res ? res : f_unlink(path);
+}
+
+static int _bench_format(bench_image_t *img)
+{
+	int fd = open(img->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)img->size_mib << 20))
+	{
+		if (fd >= 0)
+			close(fd);
+		return FR_DENIED;
+	}
+	close(fd);
+	img->created = 1;
+
+	if (!hostsim_attach(&sd_storage, 0, img->path, 1) || !sd_initialize(false))
+		return FR_NOT_READY;
+
+	void *work = malloc(BENCH_MKFS_BUF);
+	u32 au = img->cluster_kb * SZ_1K;
+	int res = f_mkfs("sd:", img->mkfs_opt, au, work, BENCH_MKFS_BUF);
+	free(work);
+
+	sdmmc_storage_end(&sd_storage);
+
+	return res;
+}
+
+static void _bench_image(bench_image_t *img)
+{
+	int res = FR_OK;
+
+	if (img->mkfs_opt)
+		res = _bench_format(img);
+	else if (!hostsim_attach(&sd_storage, 0, img->path, 1))
+		res = FR_NOT_READY;
+
+	if (!res && !sd_mount())
+		res = FR_NO_FILESYSTEM;
+
+	if (!res)
+	{
+		img->fs_type = sd_fs->fs_type;
+		img->cluster_kb = sd_fs->csize / 2;
+		img->size_mib = sd_storage.sec_cnt >> 11;
+
+		if (cfg.frag_pct && img->created)
+			res = _bench_fragment();
+		if (!res)
+			res = f_mkdir(BENCH_DIR);
+		if (res == FR_EXIST)
+			fprintf(stderr, "ffbench: %s already has " BENCH_DIR ", remove it first\n", img->path);
+	}
+
+	if (res)
+	{
+		img->res = res;
+		for (u32 i = 0; i < BENCH_MAX; i++)
+			img->results[i].res = res;
+		goto out;
+	}
+
+	bench_result_t *r = img->results;
+	r[BENCH_SEQ_WRITE].res  = _bench_seq(&r[BENCH_SEQ_WRITE], 1);
+	r[BENCH_SEQ_READ].res   = r[BENCH_SEQ_WRITE].res ? r[BENCH_SEQ_WRITE].res : _bench_seq(&r[BENCH_SEQ_READ], 0);
+	r[BENCH_RAND_WRITE].res = r[BENCH_SEQ_WRITE].res ? r[BENCH_SEQ_WRITE].res : _bench_rand_io(&r[BENCH_RAND_WRITE], 1);
+	r[BENCH_RAND_READ].res  = r[BENCH_SEQ_WRITE].res ? r[BENCH_SEQ_WRITE].res : _bench_rand_io(&r[BENCH_RAND_READ], 0);
+	r[BENCH_MKDIR].res      = _bench_mkdir(&r[BENCH_MKDIR]);
+	r[BENCH_DIR_ENUM].res   = r[BENCH_MKDIR].res ? r[BENCH_MKDIR].res : _bench_dir_enum(&r[BENCH_DIR_ENUM]);
+	r[BENCH_STAT].res       = r[BENCH_MKDIR].res ? r[BENCH_MKDIR].res : _bench_stat(&r[BENCH_STAT]);
+	r[BENCH_OPEN].res       = _bench_open(&r[BENCH_OPEN]);
+	r[BENCH_OPEN_DEEP].res  = _bench_open_deep(&r[BENCH_OPEN_DEEP]);
+	r[BENCH_EXPAND].res     = _bench_expand(&r[BENCH_EXPAND]);
+
+	// Created images are deleted anyway.
+	if (!img->created)
+	{
+		char path[1024] = BENCH_DIR;
+		if (_bench_rm_tree(path, strlen(path)))
+			fprintf(stderr, "ffbench: failed to clean up " BENCH_DIR " on %s\n", img->path);
+	}
+
+out:
+	sd_unmount();
+	hostsim_detach_all();
+}
+
+static const char *_bench_fs_name(u32 fs_type)
+{
+	switch (fs_type)
+	{
+	case FS_FAT12: return "FAT12";
+	case FS_FAT16: return "FAT16";
+	case FS_FAT32: return "FAT32";
+	case FS_EXFAT: return "exFAT";
+	default:       return "?";
+	}
+}
+
+// Total time of a test, FatFs and device.
+static u64 _bench_total_us(const bench_result_t *r)
+{
+	return MAX(r->host_us + r->dev_us, 1);
+}
+
+static void _bench_print_table(FILE *out)
+{
+	for (u32 i = 0; i < image_cnt; i++)
+	{
+		bench_image_t *img = &images[i];
+
+		fprintf(out, "%s: %s, %.1f GiB, %u KiB clusters\n", img->path, _bench_fs_name(img->fs_type),
+			img->size_mib / 1024.0, img->cluster_kb);
+		if (img->res)
+		{
+			fprintf(out, "  failed (FatFs error %d)\n\n", img->res);
+			continue;
+		}
+
+		fprintf(out, "  %-10s %8s %9s %10s %10s %10s %8s %10s\n",
+			"test", "ops", "MiB/s", "ops/s", "host ms", "dev ms", "cmds", "sectors");
+		for (u32 j = 0; j < BENCH_MAX; j++)
+		{
+			bench_result_t *r = &img->results[j];
+			u64 total = _bench_total_us(r);
+
+			if (r->res)
+			{
+				fprintf(out, "  %-10s failed (FatFs error %d)\n", bench_names[j], r->res);
+				continue;
+			}
+
+			char rate[16] = "-";
+			if (r->bytes)
+				snprintf(rate, sizeof(rate), "%.1f", (double)r->bytes / total * 1000000 / SZ_1M);
+
+			fprintf(out, "  %-10s %8llu %9s %10.0f %10.1f %10.1f %8llu %10llu\n", bench_names[j],
+				(unsigned long long)r->ops, rate, (double)r->ops * 1000000 / total,
+				r->host_us / 1000.0, r->dev_us / 1000.0,
+				(unsigned long long)r->cmds, (unsigned long long)r->sectors);
+		}
+		fprintf(out, "\n");
+	}
+}
+
+static void _bench_json_str(FILE *out, const char *str)
+{
+	fputc('"', out);
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			fputc('\\', out);
+		if ((u8)*str >= 0x20)
+			fputc(*str, out);
+	}
+	fputc('"', out);
+}
+
+static void _bench_print_json(FILE *out)
+{
+	fprintf(out, "{\n  \"config\": {\"seq_mb\": %u, \"seq_blk_kb\": %u, \"rand_ops\": %u, \"rand_blk_kb\": %u, "
+		"\"entries\": %u, \"lookups\": %u, \"depth\": %u, \"opens\": %u, \"frag_pct\": %u, \"cmd_latency_us\": %u, \"sector_ns\": %u, \"au_kb\": %u},\n",
+		cfg.seq_mb, cfg.seq_blk_kb, cfg.rand_ops, cfg.rand_blk_kb, cfg.entries, cfg.lookups, cfg.depth, cfg.opens, cfg.frag_pct,
+		hostsim_cfg.cmd_latency_us, hostsim_cfg.sector_ns, hostsim_cfg.au_kb);
+	fprintf(out, "  \"images\": [");
+
+	for (u32 i = 0; i < image_cnt; i++)
+	{
+		bench_image_t *img = &images[i];
+
+		fprintf(out, "%s\n    {\"path\": ", i ? "," : "");
+		_bench_json_str(out, img->path);
+		fprintf(out, ", \"fs\": \"%s\", \"size_mib\": %u, \"cluster_kb\": %u, \"error\": %d, \"results\": [",
+			_bench_fs_name(img->fs_type), img->size_mib, img->cluster_kb, img->res);
+
+		for (u32 j = 0; j < BENCH_MAX && !img->res; j++)
+		{
+			bench_result_t *r = &img->results[j];
+			fprintf(out, "%s\n      {\"test\": \"%s\", \"error\": %d, \"ops\": %llu, \"bytes\": %llu, \"host_us\": %llu, "
+				"\"dev_us\": %llu, \"cmds\": %llu, \"sectors\": %llu}", j ? "," : "", bench_names[j], r->res,
+				(unsigned long long)r->ops, (unsigned long long)r->bytes, (unsigned long long)r->host_us,
+				(unsigned long long)r->dev_us, (unsigned long long)r->cmds, (unsigned long long)r->sectors);
+		}
+		fprintf(out, "%s]}", img->res ? "" : "\n    ");
+	}
+
+	fprintf(out, "\n  ]\n}\n");
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: ffbench [options] [image...]\n"
+		"Given images must be formatted and are opened writable. The benchmark uses and\n"
+		"then removes " BENCH_DIR ".\n"
+		"Images:\n"
+		"  -m <fs>:<GiB>[:<KiB>]  Create a sparse image and format it. fs is fat32 or exfat,\n"
+		"                         KiB is the cluster size (default: f_mkfs choice)\n"
+		"  -d <dir>               Directory for created images (default: .)\n"
+		"  -k                     Keep created images\n"
+		"  -F <percent>           Fragment created exFAT images: mark the first percent of\n"
+		"                         clusters in use, with a free cluster every %u\n"
+		"  Without images, runs fat32 and exfat at 32, 128 and 512 GiB.\n"
+		"Tests:\n"
+		"  -S <MiB>               Sequential file size (default: %u)\n"
+		"  -B <KiB>               Sequential block size (default: %u)\n"
+		"  -n <ops>               Random operations (default: %u)\n"
+		"  -b <KiB>               Random block size (default: %u)\n"
+		"  -N <entries>           Directories created, enumerated and looked up, and files\n"
+		"                         opened in one directory (default: %u)\n"
+		"  -L <lookups>           f_stat() and f_open() calls in these directories (default: %u)\n"
+		"  -D <depth>             Deep path depth (default: %u)\n"
+		"  -o <opens>             Deep path opens (default: %u)\n"
+		"  Sequential file size is also the size of the contiguous f_expand() file.\n"
+		"Device model:\n"
+		"  -l <us>                Command latency\n"
+		"  -t <ns>                Transfer time per sector\n"
+		"  -a <kb>                SD allocation unit size\n"
+		"  -r                     Wait for latencies in real time\n"
+		"Output:\n"
+		"  -j <file>              Also write results as JSON (- for stdout)\n",
+		BENCH_FRAG_HOLE, cfg.seq_mb, cfg.seq_blk_kb, cfg.rand_ops, cfg.rand_blk_kb, cfg.entries, cfg.lookups, cfg.depth, cfg.opens);
+	exit(1);
+}
+
+static void _bench_add_image(const char *path, u32 mkfs_opt, u32 size_mib, u32 cluster_kb)
+{
+	if (image_cnt == BENCH_MAX_IMAGES)
+	{
+		fprintf(stderr, "ffbench: too many images\n");
+		exit(1);
+	}
+
+	bench_image_t *img = &images[image_cnt++];
+	snprintf(img->path, sizeof(img->path), "%s", path);
+	img->mkfs_opt = mkfs_opt;
+	img->size_mib = size_mib;
+	img->cluster_kb = cluster_kb;
+}
+
+static void _bench_add_new_image(const char *dir, const char *spec)
+{
+	char fs[16];
+	char path[256];
+	u32 size_gib = 0, cluster_kb = 0;
+
+	if (sscanf(spec, "%15[^:]:%u:%u", fs, &size_gib, &cluster_kb) < 2 || !size_gib || size_gib > 2047)
+		_usage();
+
+	u32 mkfs_opt;
+	if (!strcmp(fs, "fat32"))
+		mkfs_opt = FM_FAT32;
+	else if (!strcmp(fs, "exfat"))
+		mkfs_opt = FM_EXFAT;
+	else
+		_usage();
+
+	snprintf(path, sizeof(path), "%s/ffbench_%s_%ug.img", dir, fs, size_gib);
+	_bench_add_image(path, mkfs_opt, size_gib * SZ_1K, cluster_kb);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dir = ".", *json_path = NULL;
+	const char *specs[BENCH_MAX_IMAGES];
+	u32 spec_cnt = 0;
+	int keep = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:d:kF:S:B:n:b:N:L:D:o:l:t:a:rj:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'm':
+			if (spec_cnt == BENCH_MAX_IMAGES)
+				_usage();
+			specs[spec_cnt++] = optarg;
+			break;
+		case 'd': dir = optarg; break;
+		case 'k': keep = 1; break;
+		case 'F': cfg.frag_pct = strtoul(optarg, NULL, 0); break;
+		case 'S': cfg.seq_mb = strtoul(optarg, NULL, 0); break;
+		case 'B': cfg.seq_blk_kb = strtoul(optarg, NULL, 0); break;
+		case 'n': cfg.rand_ops = strtoul(optarg, NULL, 0); break;
+		case 'b': cfg.rand_blk_kb = strtoul(optarg, NULL, 0); break;
+		case 'N': cfg.entries = strtoul(optarg, NULL, 0); break;
+		case 'L': cfg.lookups = strtoul(optarg, NULL, 0); break;
+		case 'D': cfg.depth = strtoul(optarg, NULL, 0); break;
+		case 'o': cfg.opens = strtoul(optarg, NULL, 0); break;
+		case 'l': hostsim_cfg.cmd_latency_us = strtoul(optarg, NULL, 0); break;
+		case 't': hostsim_cfg.sector_ns = strtoul(optarg, NULL, 0); break;
+		case 'a': hostsim_cfg.au_kb = strtoul(optarg, NULL, 0); break;
+		case 'r': hostsim_cfg.realtime = 1; break;
+		case 'j': json_path = optarg; break;
+		default: _usage();
+		}
+	}
+
+	if (!cfg.seq_mb || !cfg.seq_blk_kb || !cfg.rand_blk_kb || !cfg.entries || cfg.entries > 99999 || cfg.seq_mb > 4095 ||
+		cfg.rand_blk_kb > cfg.seq_mb * SZ_1K || cfg.depth > 64 || cfg.frag_pct > 100)
+		_usage();
+
+	for (u32 i = 0; i < spec_cnt; i++)
+		_bench_add_new_image(dir, specs[i]);
+	for (int i = optind; i < argc; i++)
+		_bench_add_image(argv[i], 0, 0, 0);
+
+	if (!image_cnt)
+	{
+		static const char *defaults[] = {
+			"fat32:32", "exfat:32", "fat32:128", "exfat:128", "fat32:512", "exfat:512"
+		};
+		for (u32 i = 0; i < ARRAY_SIZE(defaults); i++)
+			_bench_add_new_image(dir, defaults[i]);
+	}
+
+	buf = malloc(MAX(cfg.seq_blk_kb, cfg.rand_blk_kb) * SZ_1K);
+	for (u32 i = 0; i < MAX(cfg.seq_blk_kb, cfg.rand_blk_kb) * SZ_1K; i++)
+		buf[i] = i * 7;
+
+	for (u32 i = 0; i < image_cnt; i++)
+	{
+		fprintf(stderr, "ffbench: %s\n", images[i].path);
+		_bench_image(&images[i]);
+
+		if (images[i].created && !keep)
+			unlink(images[i].path);
+	}
+
+	free(buf);
+
+	_bench_print_table(stdout);
+
+	if (json_path)
+	{
+		FILE *out = strcmp(json_path, "-") ? fopen(json_path, "w") : stdout;
+		if (!out)
+		{
+			perror(json_path);
+			return 1;
+		}
+
+		_bench_print_json(out);
+		if (out != stdout)
+			fclose(out);
+	}
+
+	int res = 0;
+	for (u32 i = 0; i < image_cnt; i++)
+		for (u32 j = 0; j < BENCH_MAX; j++)
+			res |= images[i].results[j].res;
+
+	return res ? 1 : 0;
+}
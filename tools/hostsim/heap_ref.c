@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2018 naehrwert
+ * Copyright (c) 2018-2020 CTCaer
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * First-fit heap that bdk/mem/heap.c replaced, kept as the baseline of heapbench.
+ * Allocation scans all nodes from the first one and free walks all of them to merge.
+ * Nodes are padded like the current ones, so both pay the same per node overhead.
+ */
+
+#include <string.h>
+
+#include "heapbench.h"
+
+typedef struct _ref_hnode
+{
+	int used;
+	u32 size;
+	struct _ref_hnode *prev;
+	struct _ref_hnode *next;
+} __attribute__((aligned(0x20))) ref_hnode_t;
+
+typedef struct _ref_heap
+{
+	u32 start;
+	ref_hnode_t *first;
+} ref_heap_t;
+
+static ref_heap_t _ref_heap;
+
+// Node info is before node address.
+static u32 _heap_alloc(ref_heap_t *heap, u32 size)
+{
+	ref_hnode_t *node, *new_node;
+
+	// Align to cache line size.
+	size = ALIGN(size, sizeof(ref_hnode_t));
+
+	if (!heap->first)
+	{
+		node = (ref_hnode_t *)(uptr)heap->start;
+		node->used = 1;
+		node->size = size;
+		node->prev = NULL;
+		node->next = NULL;
+		heap->first = node;
+
+		return (uptr)node + sizeof(ref_hnode_t);
+	}
+
+	node = heap->first;
+	while (true)
+	{
+		// Check if there's available unused node.
+		if (!node->used && (size <= node->size))
+		{
+			// Size and offset of the new unused node.
+			u32 new_size = node->size - size;
+			new_node = (ref_hnode_t *)((uptr)node + sizeof(ref_hnode_t) + size);
+
+			// If there's aligned unused space from the old node,
+			// create a new one and set the leftover size.
+			if (new_size >= (sizeof(ref_hnode_t) << 2))
+			{
+				new_node->size = new_size - sizeof(ref_hnode_t);
+				new_node->used = 0;
+				new_node->next = node->next;
+
+				// Check that we are not on first node.
+				if (new_node->next)
+					new_node->next->prev = new_node;
+
+				new_node->prev = node;
+				node->next = new_node;
+			}
+			else // Unused node size is just enough.
+				size += new_size;
+
+			node->size = size;
+			node->used = 1;
+
+			return (uptr)node + sizeof(ref_hnode_t);
+		}
+
+		// No unused node found, try the next one.
+		if (node->next)
+			node = node->next;
+		else
+			break;
+	}
+
+	// No unused node found, create a new one.
+	new_node = (ref_hnode_t *)((uptr)node + sizeof(ref_hnode_t) + node->size);
+	new_node->used = 1;
+	new_node->size = size;
+	new_node->prev = node;
+	new_node->next = NULL;
+	node->next = new_node;
+
+	return (uptr)new_node + sizeof(ref_hnode_t);
+}
+
+static void _heap_free(ref_heap_t *heap, u32 addr)
+{
+	ref_hnode_t *node = (ref_hnode_t *)((uptr)addr - sizeof(ref_hnode_t));
+	node->used = 0;
+	node = heap->first;
+	while (node)
+	{
+		if (!node->used)
+		{
+			if (node->prev && !node->prev->used)
+			{
+				node->prev->size += node->size + sizeof(ref_hnode_t);
+				node->prev->next = node->next;
+
+				if (node->next)
+					node->next->prev = node->prev;
+			}
+		}
+		node = node->next;
+	}
+}
+
+void ref_heap_init(u32 base)
+{
+	memset(&_ref_heap, 0, sizeof(ref_heap_t));
+	_ref_heap.start = base;
+}
+
+void *ref_malloc(u32 size)
+{
+	return (void *)(uptr)_heap_alloc(&_ref_heap, size);
+}
+
+void ref_free(void *buf)
+{
+	if ((uptr)buf >= _ref_heap.start)
+		_heap_free(&_ref_heap, (uptr)buf);
+}
+
+void ref_heap_stats(heap_bench_stats_t *stats)
+{
+	memset(stats, 0, sizeof(heap_bench_stats_t));
+
+	for (ref_hnode_t *node = _ref_heap.first; node; node = node->next)
+	{
+		stats->nodes++;
+		stats->total += node->size + sizeof(ref_hnode_t);
+		if (node->used)
+			stats->used += node->size + sizeof(ref_hnode_t);
+		else if (node->size > stats->free_largest)
+			stats->free_largest = node->size;
+	}
+}
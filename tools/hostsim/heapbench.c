@@ -0,0 +1,541 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Heap benchmark.
+ * Replays one sequence of allocations and frees on the payload heap and on the
+ * first-fit heap it replaced, and compares time, peak footprint and fragmentation.
+ *
+ * bdk/mem/heap.c is built as is, with its functions renamed to bdk_*, and runs in
+ * a region mapped below 4 GiB, so its u32 pointer casts hold. Pointers are 64 bit
+ * here, so nodes are 64 bytes instead of 32 on both heaps.
+ *
+ * The sequence is either a heap_trace.bin of a payload built with HEAP_TRACE, or
+ * synthetic. The synthetic one allocates or frees a random slot of a fixed slot table.
+ * One allocation in 8 is large, up to 100 KiB, the rest are up to 300 bytes.
+ *
+ * A trace is summarized before the replay, with the call sites that allocate the
+ * most. Alignment of memalign() calls is not recorded, so they are replayed as
+ * malloc(). Frees of blocks allocated before the kept part of a wrapped trace are
+ * skipped.
+ *
+ * The arena test parses a GPT the way nx_emmc_gpt_parse() does, on the payload heap
+ * left by the sequence. Partition entries come from the heap one by one,
+ * or from one bdk/mem/arena.c arena.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "heapbench.h"
+
+// Payload heap, built with its functions renamed.
+#define malloc   bdk_malloc
+#define calloc   bdk_calloc
+#define memalign bdk_memalign
+#define free     bdk_free
+#define HEAP_TRACE // Trace file layout.
+#include "../../bdk/mem/heap.h"
+#include "../../bdk/mem/arena.h"
+#undef malloc
+#undef calloc
+#undef memalign
+#undef free
+
+#define BENCH_REGION_SZ SZ_256M
+#define BENCH_GPT_SZ    (33 * 512) // NX_GPT_NUM_BLOCKS blocks.
+#define BENCH_PART_SZ   64         // sizeof(emmc_part_t) on the BPMP.
+#define BENCH_PARTS_MAX 128
+#define BENCH_CALLERS   10 // Call sites listed in a trace summary.
+
+typedef struct _bench_op_t
+{
+	u32 slot;
+	u32 size;
+	u32 free;
+} bench_op_t;
+
+typedef struct _bench_caller_t
+{
+	u32 addr;
+	u32 count;
+	u64 bytes;
+} bench_caller_t;
+
+typedef struct _bench_heap_t
+{
+	const char *name;
+	void  (*init)(u32 base);
+	void *(*alloc)(u32 size);
+	void  (*free)(void *buf);
+	void  (*stats)(heap_bench_stats_t *stats);
+} bench_heap_t;
+
+typedef struct _bench_cfg_t
+{
+	u32 ops;
+	u32 slots;
+	u32 seed;
+	u32 parses;
+	u32 parts;
+} bench_cfg_t;
+
+static bench_cfg_t cfg = {
+	.ops = 1000000,
+	.slots = 4000,
+	.seed = 1234567,
+	.parses = 100000,
+	.parts = 11
+};
+
+extern heap_t _heap;
+
+static u8 *region;
+static u32 rnd_state;
+
+// Console output of heap_monitor().
+void gfx_printf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static void _bdk_heap_init(u32 base)
+{
+	heap_init(base);
+}
+
+static void _bdk_heap_stats(heap_bench_stats_t *stats)
+{
+	memset(stats, 0, sizeof(heap_bench_stats_t));
+
+	for (hnode_t *node = _heap.first; node; node = node->next)
+	{
+		stats->nodes++;
+		stats->total += node->size + sizeof(hnode_t);
+		if (node->used)
+			stats->used += node->size + sizeof(hnode_t);
+		else if (node->size > stats->free_largest)
+			stats->free_largest = node->size;
+	}
+}
+
+static const bench_heap_t heaps[] = {
+	{ "first-fit", ref_heap_init, ref_malloc, ref_free, ref_heap_stats },
+	{ "bdk",       _bdk_heap_init, bdk_malloc, bdk_free, _bdk_heap_stats }
+};
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+static u64 _time_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static bench_op_t *_bench_synth(u32 *count)
+{
+	bench_op_t *ops = malloc(cfg.ops * sizeof(bench_op_t));
+	u8 *live = calloc(cfg.slots, 1);
+
+	rnd_state = cfg.seed ? cfg.seed : 1;
+	for (u32 i = 0; i < cfg.ops; i++)
+	{
+		u32 slot = _rnd() % cfg.slots;
+
+		ops[i].slot = slot;
+		ops[i].free = live[slot];
+		ops[i].size = 0;
+		if (!live[slot])
+			ops[i].size = (_rnd() % 8) ? _rnd() % 300 : _rnd() % 100000;
+		live[slot] = !live[slot];
+	}
+
+	free(live);
+	*count = cfg.ops;
+
+	return ops;
+}
+
+static int _bench_caller_cmp(const void *a, const void *b)
+{
+	const bench_caller_t *ca = a, *cb = b;
+
+	if (ca->addr != cb->addr)
+		return ca->addr < cb->addr ? -1 : 1;
+
+	return 0;
+}
+
+static int _bench_caller_count_cmp(const void *a, const void *b)
+{
+	const bench_caller_t *ca = a, *cb = b;
+
+	if (ca->count != cb->count)
+		return ca->count > cb->count ? -1 : 1;
+
+	return _bench_caller_cmp(a, b);
+}
+
+static void _bench_trace_callers(bench_caller_t *callers, u32 count)
+{
+	u32 unique = 0;
+
+	// Merge the allocations of each call site, then list the busiest ones.
+	qsort(callers, count, sizeof(bench_caller_t), _bench_caller_cmp);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (unique && callers[unique - 1].addr == callers[i].addr)
+		{
+			callers[unique - 1].count++;
+			callers[unique - 1].bytes += callers[i].bytes;
+		}
+		else
+			callers[unique++] = callers[i];
+	}
+	qsort(callers, unique, sizeof(bench_caller_t), _bench_caller_count_cmp);
+
+	printf("%-10s %10s %12s\n", "caller", "allocs", "KiB");
+	for (u32 i = 0; i < MIN(unique, BENCH_CALLERS); i++)
+		printf("0x%08X %10u %12llu\n", callers[i].addr, callers[i].count, (unsigned long long)callers[i].bytes / SZ_1K);
+	printf("\n");
+}
+
+// Turns a heap trace into slot operations. Slots of freed blocks are reused.
+static bench_op_t *_bench_trace(const char *path, u32 *count, u32 *slots)
+{
+	heap_trace_hdr_t hdr;
+
+	FILE *fp = fopen(path, "rb");
+	if (!fp)
+	{
+		perror("heapbench: open trace");
+		exit(1);
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != HEAP_TRACE_MAGIC || hdr.version != HEAP_TRACE_VERSION ||
+		hdr.entry_size != sizeof(heap_trace_entry_t))
+	{
+		fprintf(stderr, "heapbench: %s is not a heap trace\n", path);
+		exit(1);
+	}
+
+	heap_trace_entry_t *entries = malloc((u64)hdr.entries * sizeof(heap_trace_entry_t) + 1);
+	if (fread(entries, sizeof(heap_trace_entry_t), hdr.entries, fp) != hdr.entries)
+	{
+		fprintf(stderr, "heapbench: %s is truncated\n", path);
+		exit(1);
+	}
+	fclose(fp);
+
+	// Chained hash of live block addresses to their slot.
+	u32 hash_size = 1;
+	while (hash_size < hdr.entries)
+		hash_size <<= 1;
+	int *hash = malloc(hash_size * sizeof(int));
+	int *hnext = malloc((hdr.entries + 1) * sizeof(int));
+	u32 *haddr = malloc((hdr.entries + 1) * sizeof(u32));
+	u32 *free_slots = malloc((hdr.entries + 1) * sizeof(u32));
+	bench_op_t *ops = malloc((hdr.entries + 1) * sizeof(bench_op_t));
+	bench_caller_t *callers = malloc((hdr.entries + 1) * sizeof(bench_caller_t));
+	memset(hash, 0xFF, hash_size * sizeof(int));
+
+	u32 nops = 0, nslots = 0, nfree_slots = 0, ncallers = 0;
+	u32 allocs = 0, frees = 0, unknown = 0, live = 0;
+	u64 requested = 0, live_bytes = 0, live_peak = 0;
+	u32 *slot_size = calloc(hdr.entries + 1, sizeof(u32));
+
+	for (u32 i = 0; i < hdr.entries; i++)
+	{
+		const heap_trace_entry_t *entry = &entries[i];
+		u32 bucket = (entry->addr >> 5) & (hash_size - 1);
+
+		if (entry->op == HEAP_TRACE_FREE)
+		{
+			int *link = &hash[bucket];
+			while (*link >= 0 && haddr[*link] != entry->addr)
+				link = &hnext[*link];
+			if (*link < 0)
+			{
+				unknown++;
+				continue;
+			}
+
+			u32 slot = *link;
+			*link = hnext[slot];
+			free_slots[nfree_slots++] = slot;
+
+			ops[nops].slot = slot;
+			ops[nops].size = 0;
+			ops[nops++].free = 1;
+			frees++;
+			live--;
+			live_bytes -= slot_size[slot];
+			continue;
+		}
+
+		u32 slot = nfree_slots ? free_slots[--nfree_slots] : nslots++;
+		haddr[slot] = entry->addr;
+		hnext[slot] = hash[bucket];
+		hash[bucket] = slot;
+		slot_size[slot] = entry->size;
+
+		ops[nops].slot = slot;
+		ops[nops].size = entry->size;
+		ops[nops++].free = 0;
+
+		callers[ncallers].addr = entry->caller;
+		callers[ncallers].count = 1;
+		callers[ncallers++].bytes = entry->size;
+
+		allocs++;
+		live++;
+		requested += entry->size;
+		live_bytes += entry->size;
+		if (live_bytes > live_peak)
+			live_peak = live_bytes;
+	}
+
+	printf("%s: %u operations, %u kept, heap at 0x%08X, used max %u KiB\n", path, hdr.count, hdr.entries,
+		hdr.heap_start, hdr.used_max / SZ_1K);
+	printf("%u allocations of %llu KiB, %u frees, %u frees of blocks from before the trace\n", allocs,
+		(unsigned long long)requested / SZ_1K, frees, unknown);
+	printf("Requested bytes live: %llu KiB at peak, %llu KiB in %u blocks at the end\n\n",
+		(unsigned long long)live_peak / SZ_1K, (unsigned long long)live_bytes / SZ_1K, live);
+	_bench_trace_callers(callers, ncallers);
+
+	free(slot_size);
+	free(callers);
+	free(free_slots);
+	free(haddr);
+	free(hnext);
+	free(hash);
+	free(entries);
+
+	*count = nops;
+	*slots = MAX(nslots, 1);
+
+	return ops;
+}
+
+static void _bench_run(const bench_heap_t *heap, const bench_op_t *ops, u32 count, u32 slots)
+{
+	heap_bench_stats_t stats;
+	void **live = calloc(slots, sizeof(void *));
+	u32 peak = 0;
+
+	heap->init((u32)(uptr)region);
+
+	u64 start = _time_ns();
+	for (u32 i = 0; i < count; i++)
+	{
+		const bench_op_t *op = &ops[i];
+
+		if (op->free)
+		{
+			heap->free(live[op->slot]);
+			live[op->slot] = NULL;
+			continue;
+		}
+
+		u8 *buf = heap->alloc(op->size);
+		live[op->slot] = buf;
+
+		u32 end = buf + op->size - region;
+		if (end > peak)
+			peak = end;
+		if (peak > BENCH_REGION_SZ)
+		{
+			fprintf(stderr, "heapbench: %s heap outgrew the %u MiB region\n", heap->name, BENCH_REGION_SZ / SZ_1M);
+			exit(1);
+		}
+	}
+	u64 elapsed = _time_ns() - start;
+
+	heap->stats(&stats);
+	u32 unused = stats.total - stats.used;
+	u32 frag = unused ? 100 - (u64)stats.free_largest * 100 / unused : 0;
+
+	printf("%-10s %10.1f %8.1f %10u %8u %6u%%\n", heap->name, elapsed / 1000000.0, (double)elapsed / count,
+		peak / SZ_1K, stats.nodes, frag);
+
+	for (u32 i = 0; i < slots; i++)
+		if (live[i])
+			heap->free(live[i]);
+	free(live);
+}
+
+// Entries are allocated and the GPT buffer freed, as in a parse. Returns the arena, if used.
+static arena_t *_bench_gpt_parse(void **parts, bool use_arena)
+{
+	arena_t *arena = NULL;
+	u8 *gpt = bdk_malloc(BENCH_GPT_SZ);
+
+	if (use_arena)
+		arena = arena_create(ALIGN(BENCH_PART_SZ, ARENA_ALIGN) * cfg.parts);
+
+	for (u32 i = 0; i < cfg.parts; i++)
+		parts[i] = use_arena ? arena_calloc(arena, BENCH_PART_SZ, 1) : bdk_calloc(BENCH_PART_SZ, 1);
+
+	bdk_free(gpt);
+
+	return arena;
+}
+
+static void _bench_gpt_free(void **parts, arena_t *arena)
+{
+	if (arena)
+	{
+		arena_destroy(arena);
+		return;
+	}
+
+	for (u32 i = 0; i < cfg.parts; i++)
+		bdk_free(parts[i]);
+}
+
+static void _bench_arena(const bench_op_t *ops, u32 count, u32 slots)
+{
+	heap_bench_stats_t stats, base;
+	void **live = calloc(slots, sizeof(void *));
+	void *parts[BENCH_PARTS_MAX];
+
+	// Fragmented heap from the sequence.
+	heap_init((u32)(uptr)region);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (ops[i].free)
+			bdk_free(live[ops[i].slot]);
+		else
+			live[ops[i].slot] = bdk_malloc(ops[i].size);
+	}
+	_bdk_heap_stats(&base);
+
+	printf("GPT parse, %u entries, on a heap of %u nodes\n", cfg.parts, base.nodes);
+	printf("%-10s %8s %8s %10s %10s\n", "entries", "allocs", "held", "bytes", "ns/parse");
+	for (u32 use_arena = 0; use_arena < 2; use_arena++)
+	{
+		// Heap memory the entries hold while the list lives, with node info.
+		arena_t *arena = _bench_gpt_parse(parts, use_arena);
+		_bdk_heap_stats(&stats);
+		_bench_gpt_free(parts, arena);
+
+		u64 start = _time_ns();
+		for (u32 i = 0; i < cfg.parses; i++)
+			_bench_gpt_free(parts, _bench_gpt_parse(parts, use_arena));
+		u64 elapsed = _time_ns() - start;
+
+		u32 held = use_arena ? 1 : cfg.parts;
+		printf("%-10s %8u %8u %10u %10.1f\n", use_arena ? "arena" : "malloc", held + 1, held,
+			stats.used - base.used, (double)elapsed / cfg.parses);
+	}
+
+	free(live);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: heapbench [options] [heap_trace.bin]\n"
+		"Replays the given heap trace, or a synthetic sequence:\n"
+		"  -n <ops>    Synthetic operations (default: %u)\n"
+		"  -S <slots>  Slots of live allocations (default: %u)\n"
+		"  -s <seed>   Random seed (default: %u)\n"
+		"  -A          Run the arena test instead, after the sequence\n"
+		"  -i <count>  GPT parses of the arena test (default: %u)\n"
+		"  -p <count>  Partition entries per GPT (default: %u)\n"
+		"Peak is the highest end of an allocation above the heap start. Nodes and frag\n"
+		"are taken at the end of the sequence, before the remaining blocks are freed.\n",
+		cfg.ops, cfg.slots, cfg.seed, cfg.parses, cfg.parts);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	u32 count, slots;
+	int arena = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:S:s:Ai:p:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': cfg.ops = strtoul(optarg, NULL, 0); break;
+		case 'S': cfg.slots = strtoul(optarg, NULL, 0); break;
+		case 's': cfg.seed = strtoul(optarg, NULL, 0); break;
+		case 'A': arena = 1; break;
+		case 'i': cfg.parses = strtoul(optarg, NULL, 0); break;
+		case 'p': cfg.parts = strtoul(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	if (!cfg.ops || !cfg.slots || !cfg.parses || !cfg.parts || cfg.parts > BENCH_PARTS_MAX || argc - optind > 1)
+		_usage();
+
+	region = mmap(NULL, BENCH_REGION_SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE, -1, 0);
+	if (region == MAP_FAILED)
+	{
+		perror("heapbench: mmap");
+		return 1;
+	}
+
+	bench_op_t *ops;
+	if (optind < argc)
+		ops = _bench_trace(argv[optind], &count, &slots);
+	else
+	{
+		ops = _bench_synth(&count);
+		slots = cfg.slots;
+	}
+
+	if (arena)
+	{
+		_bench_arena(ops, count, slots);
+		free(ops);
+		munmap(region, BENCH_REGION_SZ);
+
+		return 0;
+	}
+
+	printf("%u operations, %u slots\n", count, slots);
+	printf("%-10s %10s %8s %10s %8s %7s\n", "heap", "time ms", "ns/op", "peak KiB", "nodes", "frag");
+	for (u32 i = 0; i < ARRAY_SIZE(heaps); i++)
+		_bench_run(&heaps[i], ops, count, slots);
+
+	free(ops);
+	munmap(region, BENCH_REGION_SZ);
+
+	return 0;
+}
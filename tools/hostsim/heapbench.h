@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HEAPBENCH_H_
+#define _HEAPBENCH_H_
+
+#include <utils/types.h>
+
+typedef struct _heap_bench_stats_t
+{
+	u32 nodes;
+	u32 total;        // Heap extent, used and unused nodes with their info.
+	u32 used;
+	u32 free_largest; // Largest unused node.
+} heap_bench_stats_t;
+
+// First-fit heap of heap_ref.c.
+void  ref_heap_init(u32 base);
+void *ref_malloc(u32 size);
+void  ref_free(void *buf);
+void  ref_heap_stats(heap_bench_stats_t *stats);
+
+#endif
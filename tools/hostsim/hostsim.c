@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs the payload storage stack (nx_sd, sdmmc storage API, diskio, FatFs) on a host
+ * against image files:
+ *  SD card:      raw SD image.
+ *  eMMC:         BOOT0, BOOT1 and user area dumps.
+ *  BIS:          decrypted partition dump. BIS crypto is not emulated.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libs/fatfs/diskio.h>
+#include <libs/fatfs/ff.h>
+#include <storage/nx_sd.h>
+#include "../../source/storage/nx_emmc.h"
+#include "hostsim.h"
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: hostsim [options] <command> [args]\n"
+		"Images:\n"
+		"  -s <file>   SD card image (sd:)\n"
+		"  -u <file>   eMMC user area, -0 <file> BOOT0, -1 <file> BOOT1\n"
+		"  -b <file>   Decrypted BIS partition (bis:)\n"
+		"  -w          Open images writable\n"
+		"Device model:\n"
+		"  -l <us>     Command latency\n"
+		"  -t <ns>     Transfer time per sector\n"
+		"  -e <ppm>    Command failure rate per million attempts\n"
+		"  -a <kb>     SD allocation unit size\n"
+		"  -r          Wait for latencies in real time\n"
+		"  -f <file>   Run commands from a script, one per line. A command prefixed\n"
+		"              with ! must fail\n"
+		"Commands:\n"
+		"  ls <path>               List directory\n"
+		"  get <path> <host file>  Copy file out of the image\n"
+		"  put <host file> <path>  Copy file into the image\n"
+		"  save <host file> <path> Copy file into the image with sd_save_to_file\n"
+		"  mkdir <path>            Create directory\n"
+		"  rm <path>               Delete file or empty directory\n"
+		"  stage                   Keep sd_save_to_file output in RAM\n"
+		"  flush                   Write staged files to the image\n"
+		"  stat [path]             Look up a file, or print device statistics only\n");
+	exit(1);
+}
+
+static int _cmd_ls(const char *path)
+{
+	DIR dir;
+	FILINFO fno;
+
+	int res = f_opendir(&dir, path);
+	if (res)
+		return res;
+
+	while (!(res = f_readdir(&dir, &fno)) && fno.fname[0])
+		printf("%c %10llu  %s\n", (fno.fattrib & AM_DIR) ? 'd' : '-', (unsigned long long)fno.fsize, fno.fname);
+
+	f_closedir(&dir);
+
+	return res;
+}
+
+static int _cmd_get(const char *path, const char *host_path)
+{
+	FIL fp;
+	u8 buf[SZ_64K];
+	UINT br;
+
+	FILE *out = fopen(host_path, "wb");
+	if (!out)
+		return FR_DENIED;
+
+	int res = f_open(&fp, path, FA_READ);
+	while (!res)
+	{
+		res = f_read(&fp, buf, sizeof(buf), &br);
+		if (res || !br)
+			break;
+		fwrite(buf, 1, br, out);
+	}
+
+	if (!res)
+		f_close(&fp);
+	fclose(out);
+
+	return res;
+}
+
+static int _cmd_put(const char *host_path, const char *path)
+{
+	FIL fp;
+	u8 buf[SZ_64K];
+	UINT bw;
+	size_t len;
+
+	FILE *in = fopen(host_path, "rb");
+	if (!in)
+		return FR_NO_FILE;
+
+	int res = f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE);
+	while (!res && (len = fread(buf, 1, sizeof(buf), in)) > 0)
+		res = f_write(&fp, buf, len, &bw);
+
+	if (!res)
+		res = f_close(&fp);
+	fclose(in);
+
+	return res;
+}
+
+static int _cmd_save(const char *host_path, const char *path)
+{
+	FILE *in = fopen(host_path, "rb");
+	if (!in)
+		return FR_NO_FILE;
+
+	fseek(in, 0, SEEK_END);
+	u32 size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	u8 *buf = malloc(size ? size : 1);
+	int res = fread(buf, 1, size, in) == size ? sd_save_to_file(buf, size, path) : FR_INT_ERR;
+
+	free(buf);
+	fclose(in);
+
+	return res;
+}
+
+static int _run_cmd(int argc, char **argv)
+{
+	int res = 0;
+	FILINFO fno;
+	const char *cmd = argv[0];
+
+	if (!strcmp(cmd, "ls") && argc == 2)
+		res = _cmd_ls(argv[1]);
+	else if (!strcmp(cmd, "get") && argc == 3)
+		res = _cmd_get(argv[1], argv[2]);
+	else if (!strcmp(cmd, "put") && argc == 3)
+		res = _cmd_put(argv[1], argv[2]);
+	else if (!strcmp(cmd, "save") && argc == 3)
+		res = _cmd_save(argv[1], argv[2]);
+	else if (!strcmp(cmd, "mkdir") && argc == 2)
+	{
+		res = f_mkdir(argv[1]);
+		if (res == FR_EXIST)
+			res = FR_OK;
+	}
+	else if (!strcmp(cmd, "stage") && argc == 1)
+		sd_stage_begin();
+	else if (!strcmp(cmd, "flush") && argc == 1)
+		res = sd_stage_flush();
+	else if (!strcmp(cmd, "rm") && argc == 2)
+		res = f_unlink(argv[1]);
+	else if (!strcmp(cmd, "stat") && argc == 2)
+		res = f_stat(argv[1], &fno);
+	else if (strcmp(cmd, "stat") || argc != 1)
+		_usage();
+
+	if (res)
+		fprintf(stderr, "hostsim: %s failed (FatFs error %d)\n", cmd, res);
+
+	return res;
+}
+
+static int _run_script(const char *path)
+{
+	char line[512];
+	char *args[4];
+	int res = 0;
+
+	FILE *script = fopen(path, "r");
+	if (!script)
+	{
+		perror(path);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), script))
+	{
+		int argc = 0;
+		for (char *tok = strtok(line, " \t\r\n"); tok && argc < 4; tok = strtok(NULL, " \t\r\n"))
+			args[argc++] = tok;
+
+		if (!argc || args[0][0] == '#')
+			continue;
+
+		int expect_fail = args[0][0] == '!';
+		if (expect_fail)
+			args[0]++;
+
+		int failed = _run_cmd(argc, args) != FR_OK;
+		if (failed != expect_fail)
+		{
+			if (expect_fail)
+				fprintf(stderr, "hostsim: %s %s succeeded, expected to fail\n", args[0], argc > 1 ? args[1] : "");
+			res = 1;
+		}
+	}
+
+	fclose(script);
+
+	return res;
+}
+
+int main(int argc, char **argv)
+{
+	const char *sd_path = NULL, *bis_path = NULL, *script_path = NULL;
+	const char *emmc_path[3] = { NULL };
+	int writable = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:u:0:1:b:wl:t:e:a:rf:")) != -1)
+	{
+		switch (opt)
+		{
+		case 's': sd_path = optarg; break;
+		case 'u': emmc_path[EMMC_GPP] = optarg; break;
+		case '0': emmc_path[EMMC_BOOT0] = optarg; break;
+		case '1': emmc_path[EMMC_BOOT1] = optarg; break;
+		case 'b': bis_path = optarg; break;
+		case 'w': writable = 1; break;
+		case 'l': hostsim_cfg.cmd_latency_us = strtoul(optarg, NULL, 0); break;
+		case 't': hostsim_cfg.sector_ns = strtoul(optarg, NULL, 0); break;
+		case 'e': hostsim_cfg.error_ppm = strtoul(optarg, NULL, 0); break;
+		case 'a': hostsim_cfg.au_kb = strtoul(optarg, NULL, 0); break;
+		case 'r': hostsim_cfg.realtime = 1; break;
+		case 'f': script_path = optarg; break;
+		default: _usage();
+		}
+	}
+
+	if (optind >= argc && !script_path)
+		_usage();
+
+	FATFS bis_fs_host;
+	if (sd_path && (!hostsim_attach(&sd_storage, 0, sd_path, writable) || !sd_mount()))
+		return 1;
+
+	for (u32 part = EMMC_GPP; part <= EMMC_BOOT1; part++)
+		if (emmc_path[part] && !hostsim_attach(&emmc_storage, part, emmc_path[part], writable))
+			return 1;
+	if (emmc_path[EMMC_GPP])
+		sdmmc_storage_init_mmc(&emmc_storage, &emmc_sdmmc, 0, 0);
+
+	if (bis_path)
+	{
+		if (!hostsim_attach(&bis_storage, 0, bis_path, writable) || !sdmmc_storage_init_mmc(&bis_storage, &emmc_sdmmc, 0, 0))
+			return 1;
+		if (f_mount(&bis_fs_host, "bis:", 1))
+			fprintf(stderr, "hostsim: failed to mount bis:\n");
+	}
+
+	int res;
+	if (script_path)
+		res = _run_script(script_path);
+	else
+		res = _run_cmd(argc - optind, &argv[optind]);
+
+	sd_unmount();
+	f_mount(NULL, "bis:", 0);
+
+	disk_cache_stats_t cache;
+	disk_sd_cache_stats(&cache);
+	hostsim_print_stats(stderr);
+	fprintf(stderr, "SD cache: %u hits, %u misses, %u writebacks\n", cache.hits, cache.misses, cache.writebacks);
+	hostsim_detach_all();
+
+	return res ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HOSTSIM_H_
+#define _HOSTSIM_H_
+
+#include <stdio.h>
+
+#include <storage/sdmmc.h>
+
+typedef struct _hostsim_cfg_t
+{
+	u32 cmd_latency_us; // Fixed cost of every read/write command.
+	u32 sector_ns;      // Transfer cost of every sector.
+	u32 error_ppm;      // Failure chance of a command attempt, per million.
+	u32 au_kb;          // SD allocation unit size reported to FatFs.
+	int realtime;       // Wait for the simulated latency instead of only accounting it.
+	int drain_all;      // Blocking calls wait for the queued requests of all devices, not only their own.
+	u32 seed;
+} hostsim_cfg_t;
+
+typedef struct _hostsim_stats_t
+{
+	u64 reads;
+	u64 writes;
+	u64 sectors_read;
+	u64 sectors_written;
+	u64 trims;
+	u64 sectors_trimmed;
+	u64 retries;
+	u64 failures;
+	u64 busy_us; // Simulated device busy time.
+	u64 bounces; // Blocking transfers copied through the upper buffer, like sdmmc does for IRAM buffers.
+	u64 sectors_bounced;
+	u64 bounce_ns; // Host time of the bounce copies.
+} hostsim_stats_t;
+
+extern hostsim_cfg_t hostsim_cfg;
+extern hostsim_stats_t hostsim_stats;
+extern sdmmc_storage_t bis_storage;
+
+int  hostsim_attach(sdmmc_storage_t *storage, u32 partition, const char *path, int writable);
+int  hostsim_set_timing(sdmmc_storage_t *storage, u32 cmd_latency_us, u32 sector_ns);
+void hostsim_detach_all();
+u64  hostsim_time_us();
+void hostsim_print_stats(FILE *out);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Payload FatFs configuration plus f_mkfs(), so ffbench can format its images.
+ * Nothing else differs, so measured paths are the ones the payload runs.
+ */
+
+#include "../../../source/libs/fatfs/ffconf.h"
+
+#undef FF_USE_MKFS
+#define FF_USE_MKFS   1
+#define FF_MKFS_LABEL "FFBENCH    "
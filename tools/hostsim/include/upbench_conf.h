@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Payload FatFs configuration with the FF_UPCASE_TBL setting of each upbench build.
+ */
+
+#include "../../../source/libs/fatfs/ffconf.h"
+
+#ifdef UPBENCH_TBL
+#undef FF_UPCASE_TBL
+#define FF_UPCASE_TBL UPBENCH_TBL
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host replacement of bdk/utils/types.h.
+ * Keeps the 32-bit sizes of the BPMP types on 64-bit hosts.
+ */
+
+#ifndef _TYPES_H_
+#define _TYPES_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Types */
+typedef int8_t  s8;
+typedef int16_t s16;
+typedef int16_t SHORT;
+typedef int32_t s32;
+typedef int32_t INT;
+typedef int bool;
+typedef int32_t LONG;
+typedef int64_t s64;
+
+typedef uint8_t  u8;
+typedef uint8_t  BYTE;
+typedef uint16_t u16;
+typedef uint16_t WORD;
+typedef uint16_t WCHAR;
+typedef uint32_t u32;
+typedef uint32_t UINT;
+typedef uint32_t DWORD;
+typedef uint64_t QWORD;
+typedef uint64_t u64;
+
+typedef volatile uint8_t  vu8;
+typedef volatile uint16_t vu16;
+typedef volatile uint32_t vu32;
+
+typedef uintptr_t uptr;
+
+/* Important */
+#define false 0
+#define true  1
+
+/* Sizes */
+#define SZ_1K   0x400
+#define SZ_2K   0x800
+#define SZ_4K   0x1000
+#define SZ_8K   0x2000
+#define SZ_16K  0x4000
+#define SZ_32K  0x8000
+#define SZ_64K  0x10000
+#define SZ_128K 0x20000
+#define SZ_256K 0x40000
+#define SZ_512K 0x80000
+#define SZ_1M   0x100000
+#define SZ_2M   0x200000
+#define SZ_4M   0x400000
+#define SZ_8M   0x800000
+#define SZ_16M  0x1000000
+#define SZ_32M  0x2000000
+#define SZ_64M  0x4000000
+#define SZ_128M 0x8000000
+#define SZ_256M 0x10000000
+#define SZ_512M 0x20000000
+#define SZ_1G   0x40000000
+#define SZ_2G   0x80000000
+#define SZ_PAGE SZ_4K
+
+/* Macros */
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define ALIGN(x, a) (((x) + (a) - 1) & ~((a) - 1))
+#define ALIGN_DOWN(x, a) ((x) & ~((a) - 1))
+#define BIT(n) (1U << (n))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define DIV_ROUND_UP(a, b) ((a + b - 1) / b)
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+#define LOG2(n) (32 - __builtin_clz(n) - 1)
+#define CLZ(n) __builtin_clz(n)
+#define CLO(n) __builtin_clz(~n)
+
+#define OFFSET_OF(t, m) ((uptr)&((t *)NULL)->m)
+#define CONTAINER_OF(mp, t, mn) ((t *)((uptr)mp - OFFSET_OF(t, mn)))
+
+#endif
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Replays a sector I/O trace (payload built with IO_TRACE) against sector cache
+ * models, to size a cache before implementing it on the payload side.
+ *
+ * Cache model: LRU, write-back, write-allocate. A miss run of contiguous blocks
+ * costs one read command. Writes that fully cover a block skip the fill.
+ * Dirty blocks cost one write command when evicted. The final flush merges
+ * contiguous dirty blocks. Transfers of at least the bypass size go directly to
+ * the device, after writing back any dirty block they overlap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../source/storage/io_trace.h"
+
+#define REPLAY_DEV_ALL 0xFFFFFFFF
+
+typedef struct _replay_cfg_t
+{
+	u32 cmd_latency_us;
+	u32 sector_ns;
+	u32 dev;
+	u32 cache_kb;
+	u32 bypass;
+} replay_cfg_t;
+
+typedef struct _cache_blk_t
+{
+	u32 dev;
+	u32 blk;
+	u32 dirty;
+	u32 valid;
+	int prev;
+	int next;
+	int hnext;
+} cache_blk_t;
+
+typedef struct _cache_t
+{
+	u32 blk_sectors;
+	u32 nblks;
+	cache_blk_t *blks;
+	int *hash;
+	u32 hash_mask;
+	int lru_head; // Most recently used.
+	int lru_tail;
+
+	u64 hits;
+	u64 misses;
+	u64 cmds;
+	u64 sectors;
+	u64 writebacks;
+} cache_t;
+
+static replay_cfg_t cfg = {
+	.cmd_latency_us = 200,
+	.sector_ns = 20000,
+	.dev = REPLAY_DEV_ALL,
+	.cache_kb = 1024,
+	.bypass = 32
+};
+
+static u64 _cost_us(u64 cmds, u64 sectors)
+{
+	return cmds * cfg.cmd_latency_us + sectors * cfg.sector_ns / 1000;
+}
+
+static u32 _hash(u32 dev, u32 blk)
+{
+	return (blk * 2654435761u) ^ (dev * 40503u);
+}
+
+static void _lru_unlink(cache_t *c, int idx)
+{
+	cache_blk_t *b = &c->blks[idx];
+
+	if (b->prev >= 0)
+		c->blks[b->prev].next = b->next;
+	else
+		c->lru_head = b->next;
+	if (b->next >= 0)
+		c->blks[b->next].prev = b->prev;
+	else
+		c->lru_tail = b->prev;
+}
+
+static void _lru_push(cache_t *c, int idx)
+{
+	cache_blk_t *b = &c->blks[idx];
+
+	b->prev = -1;
+	b->next = c->lru_head;
+	if (c->lru_head >= 0)
+		c->blks[c->lru_head].prev = idx;
+	c->lru_head = idx;
+	if (c->lru_tail < 0)
+		c->lru_tail = idx;
+}
+
+static void _hash_remove(cache_t *c, int idx)
+{
+	cache_blk_t *b = &c->blks[idx];
+	int *link = &c->hash[_hash(b->dev, b->blk) & c->hash_mask];
+
+	while (*link != idx)
+		link = &c->blks[*link].hnext;
+	*link = b->hnext;
+}
+
+static int _cache_find(cache_t *c, u32 dev, u32 blk)
+{
+	int idx = c->hash[_hash(dev, blk) & c->hash_mask];
+
+	while (idx >= 0 && (c->blks[idx].dev != dev || c->blks[idx].blk != blk))
+		idx = c->blks[idx].hnext;
+
+	return idx;
+}
+
+static int _cache_init(cache_t *c, u32 blk_sectors, u32 cache_kb)
+{
+	memset(c, 0, sizeof(cache_t));
+	c->blk_sectors = blk_sectors;
+	c->nblks = (cache_kb * 2) / blk_sectors;
+	if (!c->nblks)
+		return 0;
+
+	u32 hsize = 1;
+	while (hsize < c->nblks * 2)
+		hsize <<= 1;
+	c->hash_mask = hsize - 1;
+
+	c->blks = calloc(c->nblks, sizeof(cache_blk_t));
+	c->hash = malloc(hsize * sizeof(int));
+	if (!c->blks || !c->hash)
+		return 0;
+
+	memset(c->hash, 0xFF, hsize * sizeof(int));
+	c->lru_head = -1;
+	c->lru_tail = -1;
+
+	// Every block starts invalid, at the LRU tail side.
+	for (u32 i = 0; i < c->nblks; i++)
+		_lru_push(c, i);
+
+	return 1;
+}
+
+static void _cache_free(cache_t *c)
+{
+	free(c->blks);
+	free(c->hash);
+}
+
+// Returns a block to reuse for dev/blk, writing back its old contents if dirty.
+static int _cache_evict(cache_t *c)
+{
+	int idx = c->lru_tail;
+	cache_blk_t *b = &c->blks[idx];
+
+	if (b->valid)
+	{
+		if (b->dirty)
+		{
+			c->writebacks++;
+			c->cmds++;
+			c->sectors += c->blk_sectors;
+		}
+		_hash_remove(c, idx);
+	}
+
+	b->valid = 0;
+	b->dirty = 0;
+
+	return idx;
+}
+
+static void _cache_bypass(cache_t *c, const io_trace_entry_t *e, u32 first, u32 last)
+{
+	for (u32 blk = first; blk <= last; blk++)
+	{
+		int idx = _cache_find(c, e->dev, blk);
+		if (idx < 0)
+			continue;
+
+		// Cached copies of written blocks get updated in place.
+		if (e->op == IO_TRACE_WRITE)
+			c->blks[idx].dirty = 0;
+		else if (c->blks[idx].dirty)
+		{
+			c->writebacks++;
+			c->cmds++;
+			c->sectors += c->blk_sectors;
+			c->blks[idx].dirty = 0;
+		}
+	}
+
+	c->cmds++;
+	c->sectors += e->count;
+}
+
+static void _cache_access(cache_t *c, const io_trace_entry_t *e)
+{
+	u32 first = e->sector / c->blk_sectors;
+	u32 last = (e->sector + e->count - 1) / c->blk_sectors;
+	u32 run = 0;
+
+	if (cfg.bypass && e->count >= cfg.bypass)
+	{
+		_cache_bypass(c, e, first, last);
+		return;
+	}
+
+	for (u32 blk = first; blk <= last; blk++)
+	{
+		int idx = _cache_find(c, e->dev, blk);
+		if (idx >= 0)
+		{
+			c->hits++;
+			if (run)
+			{
+				c->cmds++;
+				c->sectors += run * c->blk_sectors;
+				run = 0;
+			}
+		}
+		else
+		{
+			c->misses++;
+
+			// Fully overwritten blocks need no fill.
+			u32 blk_start = blk * c->blk_sectors;
+			bool covered = e->op == IO_TRACE_WRITE && blk_start >= e->sector &&
+				blk_start + c->blk_sectors <= e->sector + e->count;
+			if (!covered)
+				run++;
+			else if (run)
+			{
+				c->cmds++;
+				c->sectors += run * c->blk_sectors;
+				run = 0;
+			}
+
+			idx = _cache_evict(c);
+			cache_blk_t *b = &c->blks[idx];
+			b->dev = e->dev;
+			b->blk = blk;
+			b->valid = 1;
+			u32 h = _hash(e->dev, blk) & c->hash_mask;
+			b->hnext = c->hash[h];
+			c->hash[h] = idx;
+		}
+
+		if (e->op == IO_TRACE_WRITE)
+			c->blks[idx].dirty = 1;
+
+		_lru_unlink(c, idx);
+		_lru_push(c, idx);
+	}
+
+	if (run)
+	{
+		c->cmds++;
+		c->sectors += run * c->blk_sectors;
+	}
+}
+
+static int _blk_cmp(const void *a, const void *b)
+{
+	const cache_blk_t *x = a, *y = b;
+
+	if (x->dev != y->dev)
+		return x->dev < y->dev ? -1 : 1;
+	if (x->blk != y->blk)
+		return x->blk < y->blk ? -1 : 1;
+
+	return 0;
+}
+
+static void _cache_flush(cache_t *c)
+{
+	u32 ndirty = 0;
+
+	// The block table is not needed after the flush, so sort it in place.
+	for (u32 i = 0; i < c->nblks; i++)
+		if (c->blks[i].valid && c->blks[i].dirty)
+			c->blks[ndirty++] = c->blks[i];
+	qsort(c->blks, ndirty, sizeof(cache_blk_t), _blk_cmp);
+
+	for (u32 i = 0; i < ndirty; i++)
+	{
+		c->writebacks++;
+		c->sectors += c->blk_sectors;
+		if (!i || c->blks[i].dev != c->blks[i - 1].dev || c->blks[i].blk != c->blks[i - 1].blk + 1)
+			c->cmds++;
+	}
+}
+
+static int _replay_match(const io_trace_entry_t *e)
+{
+	return !e->error && e->count && (cfg.dev == REPLAY_DEV_ALL || e->dev == cfg.dev);
+}
+
+static void _print_summary(const io_trace_hdr_t *hdr, const io_trace_entry_t *entries)
+{
+	u64 ops[2] = { 0 }, sectors[2] = { 0 }, seq = 0, errors = 0, traced_us = 0;
+	u32 next_sector = 0, prev_dev = 0xFFFFFFFF;
+
+	for (u32 i = 0; i < hdr->entries; i++)
+	{
+		const io_trace_entry_t *e = &entries[i];
+		if (e->error)
+			errors++;
+		if (!_replay_match(e))
+			continue;
+
+		ops[e->op & 1]++;
+		sectors[e->op & 1] += e->count;
+		traced_us += e->duration;
+		if (e->dev == prev_dev && e->sector == next_sector)
+			seq++;
+		prev_dev = e->dev;
+		next_sector = e->sector + e->count;
+	}
+
+	u64 total = ops[0] + ops[1];
+	printf("Trace: %u entries (%u recorded, %u dropped), %llu failed\n",
+		hdr->entries, hdr->count, hdr->count - hdr->entries, (unsigned long long)errors);
+	printf("Reads:  %10llu ops %12llu sectors\n", (unsigned long long)ops[0], (unsigned long long)sectors[0]);
+	printf("Writes: %10llu ops %12llu sectors\n", (unsigned long long)ops[1], (unsigned long long)sectors[1]);
+	if (total)
+		printf("Avg size %llu sectors, %llu%% sequential, %llu us traced\n\n",
+			(unsigned long long)((sectors[0] + sectors[1]) / total),
+			(unsigned long long)(seq * 100 / total), (unsigned long long)traced_us);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: ioreplay [options] <io_trace.bin>\n"
+		"  -d <dev>    Only replay this device (FatFs drive or 0x10 + emuMMC partition)\n"
+		"  -m <kb>     Cache size (default 1024)\n"
+		"  -b <n>      Bypass the cache for transfers of n sectors or more, 0 to disable (default 32)\n"
+		"  -l <us>     Command latency (default 200)\n"
+		"  -t <ns>     Transfer time per sector (default 20000)\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	static const u32 blk_sizes[] = { 1, 8, 32, 64, 128 };
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:m:b:l:t:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'd': cfg.dev = strtoul(optarg, NULL, 0); break;
+		case 'm': cfg.cache_kb = strtoul(optarg, NULL, 0); break;
+		case 'b': cfg.bypass = strtoul(optarg, NULL, 0); break;
+		case 'l': cfg.cmd_latency_us = strtoul(optarg, NULL, 0); break;
+		case 't': cfg.sector_ns = strtoul(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	if (optind != argc - 1)
+		_usage();
+
+	FILE *in = fopen(argv[optind], "rb");
+	if (!in)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+
+	io_trace_hdr_t hdr;
+	if (fread(&hdr, sizeof(hdr), 1, in) != 1 || hdr.magic != IO_TRACE_MAGIC ||
+		hdr.version != IO_TRACE_VERSION || hdr.entry_size != sizeof(io_trace_entry_t))
+	{
+		fprintf(stderr, "ioreplay: %s is not a supported I/O trace\n", argv[optind]);
+		fclose(in);
+		return 1;
+	}
+
+	io_trace_entry_t *entries = malloc((size_t)hdr.entries * sizeof(io_trace_entry_t));
+	if (!entries || fread(entries, sizeof(io_trace_entry_t), hdr.entries, in) != hdr.entries)
+	{
+		fprintf(stderr, "ioreplay: truncated trace\n");
+		fclose(in);
+		return 1;
+	}
+	fclose(in);
+
+	_print_summary(&hdr, entries);
+
+	// Uncached baseline: every traced operation is one command.
+	u64 base_cmds = 0, base_sectors = 0;
+	for (u32 i = 0; i < hdr.entries; i++)
+	{
+		if (!_replay_match(&entries[i]))
+			continue;
+		base_cmds++;
+		base_sectors += entries[i].count;
+	}
+	u64 base_us = _cost_us(base_cmds, base_sectors);
+
+	printf("Cache %u KB, bypass %u sectors, %u us/cmd, %u ns/sector\n",
+		cfg.cache_kb, cfg.bypass, cfg.cmd_latency_us, cfg.sector_ns);
+	printf("Model   Block  Hit%%       Cmds    Sectors  Writebacks      Sim us  Speedup\n");
+	printf("none        -     -  %9llu  %9llu           -  %10llu    1.00x\n",
+		(unsigned long long)base_cmds, (unsigned long long)base_sectors, (unsigned long long)base_us);
+
+	for (u32 i = 0; i < ARRAY_SIZE(blk_sizes); i++)
+	{
+		cache_t c;
+		if (!_cache_init(&c, blk_sizes[i], cfg.cache_kb))
+		{
+			_cache_free(&c);
+			continue;
+		}
+
+		for (u32 j = 0; j < hdr.entries; j++)
+			if (_replay_match(&entries[j]))
+				_cache_access(&c, &entries[j]);
+		_cache_flush(&c);
+
+		u64 accesses = c.hits + c.misses;
+		u64 sim_us = _cost_us(c.cmds, c.sectors);
+		printf("LRU    %5u  %3llu%%  %9llu  %9llu  %10llu  %10llu  %6.2fx\n",
+			blk_sizes[i] * 512,
+			(unsigned long long)(accesses ? c.hits * 100 / accesses : 0),
+			(unsigned long long)c.cmds, (unsigned long long)c.sectors, (unsigned long long)c.writebacks,
+			(unsigned long long)sim_us, sim_us ? (double)base_us / sim_us : 0.0);
+
+		_cache_free(&c);
+	}
+
+	free(entries);
+
+	return 0;
+}
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LZ4 frame benchmark.
+ * Writes data to a file through lz4f and plainly with f_write(), reads it back and compares
+ * it, on an SD image through the payload FatFs build and the host sdmmc backend. Like
+ * ffbench, host time is the CPU cost and device time is the simulated card time. Reads
+ * remount first, so they start with cold FatFs and sector caches.
+ *
+ * The data is a file given with -i, or generated to look like a storage dump: erased
+ * areas, repetitive code and tables, and encrypted data that does not compress.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libs/compr/lz4f.h>
+#include <libs/fatfs/ff.h>
+#include <storage/nx_sd.h>
+#include "hostsim.h"
+
+#define BENCH_DIR      "sd:/lz4fbench"
+#define BENCH_FILE     BENCH_DIR "/data.bin"
+#define BENCH_MKFS_BUF SZ_1M
+
+typedef struct _bench_result_t
+{
+	const char *name;
+	u32 blk_id;
+	int res;
+	u64 file_size;
+	u64 host_us;
+	u64 dev_us;
+	u64 sectors;
+} bench_result_t;
+
+typedef struct _bench_snap_t
+{
+	hostsim_stats_t stats;
+	u64 time;
+} bench_snap_t;
+
+static u8 *data;
+static u8 *chunk;
+static u64 data_size;
+static u32 chunk_size = 64 * SZ_1K;
+static bool checksum = true;
+static u32 rng = 0x2545F491;
+
+static u32 _bench_rand()
+{
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+
+	return rng;
+}
+
+// 4 KiB pages: 40% erased, 35% repetitive with few symbols and 25% random.
+static void _bench_gen(u8 *buf, u64 size)
+{
+	u8 pattern[256];
+	for (u32 i = 0; i < sizeof(pattern); i++)
+		pattern[i] = _bench_rand();
+
+	for (u64 pos = 0; pos < size; pos += SZ_4K)
+	{
+		u32 len = MIN(size - pos, SZ_4K);
+		u32 kind = _bench_rand() % 100;
+
+		if (kind < 40)
+			memset(buf + pos, 0, len);
+		else if (kind < 75)
+		{
+			for (u32 i = 0; i < len; i++)
+				buf[pos + i] = (_bench_rand() & 7) ? pattern[(pos + i) & 0xFF] : (u8)_bench_rand() & 0xF;
+		}
+		else
+		{
+			for (u32 i = 0; i < len; i++)
+				buf[pos + i] = _bench_rand();
+		}
+	}
+}
+
+static void _bench_start(bench_snap_t *snap)
+{
+	snap->stats = hostsim_stats;
+	snap->time = hostsim_time_us();
+}
+
+static void _bench_stop(bench_result_t *result, const bench_snap_t *snap)
+{
+	result->host_us = hostsim_time_us() - snap->time;
+	result->dev_us  = hostsim_stats.busy_us - snap->stats.busy_us;
+	result->sectors = (hostsim_stats.sectors_read + hostsim_stats.sectors_written) -
+					  (snap->stats.sectors_read + snap->stats.sectors_written);
+
+	if (hostsim_cfg.realtime)
+		result->host_us -= MIN(result->dev_us, result->host_us);
+}
+
+static int _bench_remount()
+{
+	sd_unmount();
+
+	return sd_mount() ? FR_OK : FR_NOT_READY;
+}
+
+static int _bench_write(bench_result_t *result, u32 blk_id)
+{
+	FIL fp;
+	lz4f_t lz;
+	UINT bw;
+	bench_snap_t snap;
+
+	_bench_start(&snap);
+
+	int res = f_open(&fp, BENCH_FILE, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res)
+		return res;
+
+	if (blk_id)
+		res = lz4f_write_open(&lz, &fp, blk_id, checksum);
+	for (u64 pos = 0; !res && pos < data_size; pos += chunk_size)
+	{
+		u32 size = MIN(data_size - pos, chunk_size);
+		if (blk_id)
+			res = lz4f_write(&lz, data + pos, size);
+		else
+		{
+			res = f_write(&fp, data + pos, size, &bw);
+			if (!res && bw != size)
+				res = FR_DENIED;
+		}
+	}
+	if (blk_id && lz.buf)
+	{
+		int close_res = lz4f_write_close(&lz);
+		res = res ? res : close_res;
+	}
+
+	result->file_size = f_size(&fp);
+	int close_res = f_close(&fp);
+	res = res ? res : close_res;
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+static int _bench_read(bench_result_t *result, u32 blk_id)
+{
+	FIL fp;
+	lz4f_t lz;
+	UINT br;
+	bench_snap_t snap;
+
+	int res = _bench_remount();
+	if (res)
+		return res;
+
+	_bench_start(&snap);
+
+	res = f_open(&fp, BENCH_FILE, FA_READ);
+	if (res)
+		return res;
+
+	result->file_size = f_size(&fp);
+	if (blk_id)
+		res = lz4f_read_open(&lz, &fp);
+	for (u64 pos = 0; !res && pos <= data_size; pos += chunk_size)
+	{
+		// Reads one more chunk at the end, which must be empty.
+		u32 size = MIN(data_size - pos, chunk_size);
+		u32 want = size ? size : chunk_size;
+		if (blk_id)
+			res = lz4f_read(&lz, chunk, want, &br);
+		else
+			res = f_read(&fp, chunk, want, &br);
+
+		if (!res && (br != size || memcmp(chunk, data + pos, size)))
+		{
+			fprintf(stderr, "lz4fbench: data mismatch at %llu\n", (unsigned long long)pos);
+			res = FR_INT_ERR;
+		}
+	}
+	if (blk_id)
+		lz4f_read_close(&lz);
+	f_close(&fp);
+
+	_bench_stop(result, &snap);
+
+	return res;
+}
+
+// Copies the file out of the image, to check it with the lz4 tool.
+static int _bench_export(const char *path)
+{
+	FIL fp;
+	UINT br;
+
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return FR_DENIED;
+
+	int res = f_open(&fp, BENCH_FILE, FA_READ);
+	while (!res && !(res = f_read(&fp, chunk, chunk_size, &br)) && br)
+		if (write(fd, chunk, br) != (ssize_t)br)
+			res = FR_DENIED;
+	f_close(&fp);
+	close(fd);
+
+	return res;
+}
+
+static int _bench_format(const char *path, u32 size_mib)
+{
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)size_mib << 20))
+	{
+		if (fd >= 0)
+			close(fd);
+		return FR_DENIED;
+	}
+	close(fd);
+
+	if (!hostsim_attach(&sd_storage, 0, path, 1) || !sd_initialize(false))
+		return FR_NOT_READY;
+
+	void *work = malloc(BENCH_MKFS_BUF);
+	int res = f_mkfs("sd:", FM_EXFAT, 0, work, BENCH_MKFS_BUF);
+	free(work);
+
+	sdmmc_storage_end(&sd_storage);
+
+	return res;
+}
+
+static void _bench_print(const bench_result_t *results, u32 count)
+{
+	printf("%llu bytes, %u KiB chunks, content checksum %s\n", (unsigned long long)data_size,
+		chunk_size / SZ_1K, checksum ? "on" : "off");
+	printf("  %-6s %6s %12s %7s %10s %10s %9s %10s\n", "test", "block", "file", "ratio", "host ms", "dev ms", "MiB/s", "sectors");
+
+	for (u32 i = 0; i < count; i++)
+	{
+		const bench_result_t *r = &results[i];
+		char blk[16] = "-";
+		if (r->blk_id)
+			snprintf(blk, sizeof(blk), "%uK", (1 << (8 + 2 * r->blk_id)) / SZ_1K);
+
+		if (r->res)
+		{
+			printf("  %-6s %6s failed (FatFs error %d)\n", r->name, blk, r->res);
+			continue;
+		}
+
+		u64 total = MAX(r->host_us + r->dev_us, 1);
+		printf("  %-6s %6s %12llu %7.3f %10.1f %10.1f %9.1f %10llu\n", r->name, blk,
+			(unsigned long long)r->file_size, (double)r->file_size / data_size,
+			r->host_us / 1000.0, r->dev_us / 1000.0, (double)data_size / total * 1000000 / SZ_1M,
+			(unsigned long long)r->sectors);
+	}
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: lz4fbench [options] [image]\n"
+		"A given image must be formatted and is opened writable. The benchmark uses and then\n"
+		"removes " BENCH_DIR ". Without an image, a 1 GiB exFAT image is created and deleted.\n"
+		"  -i <file>   Data to write (default: generated dump-like data)\n"
+		"  -S <MiB>    Size of generated data (default: 32)\n"
+		"  -B <KiB>    Chunk size of writes and reads (default: %u)\n"
+		"  -x          No content checksum\n"
+		"  -w <file>   Export the 64 KiB block frame, to check it with lz4 -t\n"
+		"  -d <dir>    Directory for the created image (default: .)\n"
+		"  -l <us>     Command latency\n"
+		"  -t <ns>     Transfer time per sector\n"
+		"  -r          Wait for latencies in real time\n",
+		chunk_size / SZ_1K);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	static const u32 blk_ids[] = { 0, LZ4F_BLOCK_64K, LZ4F_BLOCK_256K, LZ4F_BLOCK_1M, LZ4F_BLOCK_4M };
+	bench_result_t results[ARRAY_SIZE(blk_ids) * 2];
+	const char *in_path = NULL, *export_path = NULL, *dir = ".";
+	char img_path[256];
+	u32 gen_mb = 32;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "i:S:B:xw:d:l:t:r")) != -1)
+	{
+		switch (opt)
+		{
+		case 'i': in_path = optarg; break;
+		case 'S': gen_mb = strtoul(optarg, NULL, 0); break;
+		case 'B': chunk_size = strtoul(optarg, NULL, 0) * SZ_1K; break;
+		case 'x': checksum = false; break;
+		case 'w': export_path = optarg; break;
+		case 'd': dir = optarg; break;
+		case 'l': hostsim_cfg.cmd_latency_us = strtoul(optarg, NULL, 0); break;
+		case 't': hostsim_cfg.sector_ns = strtoul(optarg, NULL, 0); break;
+		case 'r': hostsim_cfg.realtime = 1; break;
+		default: _usage();
+		}
+	}
+
+	if (optind < argc - 1 || !chunk_size || !gen_mb || gen_mb > 768)
+		_usage();
+
+	if (in_path)
+	{
+		FILE *f = fopen(in_path, "rb");
+		if (!f)
+		{
+			perror(in_path);
+			return 1;
+		}
+		fseek(f, 0, SEEK_END);
+		data_size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		data = malloc(data_size + 1);
+		if (!data || fread(data, 1, data_size, f) != data_size || data_size > 768 * SZ_1M)
+		{
+			fprintf(stderr, "lz4fbench: failed to read %s\n", in_path);
+			return 1;
+		}
+		fclose(f);
+	}
+	else
+	{
+		data_size = (u64)gen_mb * SZ_1M;
+		data = malloc(data_size);
+		_bench_gen(data, data_size);
+	}
+	chunk = malloc(chunk_size);
+
+	int res;
+	bool created = optind == argc;
+	if (created)
+	{
+		snprintf(img_path, sizeof(img_path), "%s/lz4fbench.img", dir);
+		res = _bench_format(img_path, SZ_1K);
+	}
+	else
+	{
+		snprintf(img_path, sizeof(img_path), "%s", argv[optind]);
+		res = hostsim_attach(&sd_storage, 0, img_path, 1) ? FR_OK : FR_NOT_READY;
+	}
+	if (!res && !sd_mount())
+		res = FR_NO_FILESYSTEM;
+	if (!res)
+		res = f_mkdir(BENCH_DIR);
+	if (res)
+	{
+		fprintf(stderr, "lz4fbench: %s: FatFs error %d%s\n", img_path, res,
+			res == FR_EXIST ? ", remove " BENCH_DIR " first" : "");
+		return 1;
+	}
+
+	u32 count = 0;
+	for (u32 i = 0; i < ARRAY_SIZE(blk_ids); i++)
+	{
+		bench_result_t *w = &results[count++];
+		bench_result_t *r = &results[count++];
+
+		w->name = "write";
+		r->name = "read";
+		w->blk_id = r->blk_id = blk_ids[i];
+		w->res = _bench_write(w, blk_ids[i]);
+		r->res = w->res ? w->res : _bench_read(r, blk_ids[i]);
+
+		if (!w->res && export_path && blk_ids[i] == LZ4F_BLOCK_64K && _bench_export(export_path))
+			fprintf(stderr, "lz4fbench: failed to export to %s\n", export_path);
+	}
+
+	f_unlink(BENCH_FILE);
+	f_unlink(BENCH_DIR);
+	sd_unmount();
+	hostsim_detach_all();
+	if (created)
+		unlink(img_path);
+
+	_bench_print(results, count);
+
+	free(data);
+	free(chunk);
+
+	res = 0;
+	for (u32 i = 0; i < count; i++)
+		res |= results[i].res;
+
+	return res ? 1 : 0;
+}
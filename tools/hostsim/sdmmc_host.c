@@ -0,0 +1,559 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host backend of the sdmmc storage API.
+ * Every storage partition maps to an image file. Commands are charged with a
+ * simple latency model and can fail randomly, like a flaky card would.
+ * Blocking transfers with buffers in data, BSS or on the stack, which are IRAM on the
+ * BPMP, or not 8 byte aligned are copied through an upper buffer, like sdmmc does.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <storage/nx_sd.h>
+#include "hostsim.h"
+
+#define HOSTSIM_MAX_DEVS  4
+#define HOSTSIM_MAX_PARTS 3 // GPP, BOOT0, BOOT1.
+#define HOSTSIM_RETRIES   5 // Same as the BPMP driver.
+
+typedef struct _hostsim_dev_t
+{
+	sdmmc_storage_t *storage;
+	int fd[HOSTSIM_MAX_PARTS];
+	u64 size[HOSTSIM_MAX_PARTS];
+	int writable[HOSTSIM_MAX_PARTS];
+	u64 free_us; // Time when the device finishes its charged commands.
+	int timed;   // Uses its own latencies instead of hostsim_cfg.
+	u32 cmd_latency_us;
+	u32 sector_ns;
+} hostsim_dev_t;
+
+typedef struct _hostsim_req_t
+{
+	sdmmc_async_t *async;
+	u64 due;
+	int ok;
+} hostsim_req_t;
+
+hostsim_cfg_t hostsim_cfg = {
+	.cmd_latency_us = 0,
+	.sector_ns = 0,
+	.error_ppm = 0,
+	.au_kb = 4096,
+	.realtime = 0,
+	.drain_all = 0,
+	.seed = 0x12345678
+};
+
+hostsim_stats_t hostsim_stats;
+u32 sdmmc_bounce_count;
+
+// Linker and libc symbols that bound the data and BSS sections and the main stack.
+extern char __data_start[], _end[];
+extern void *__libc_stack_end;
+
+static hostsim_dev_t devs[HOSTSIM_MAX_DEVS];
+static hostsim_req_t queue[SDMMC_ASYNC_QUEUE_SZ];
+static u32 queue_head;
+static u32 queue_cnt;
+static u64 sim_time_us; // End of the last charged command of any device.
+static u32 rng;
+static u8 *upper_buf;
+static u32 upper_buf_sectors;
+
+u64 hostsim_time_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static u64 _hostsim_now()
+{
+	// Without realtime, time only moves by charged commands.
+	return hostsim_cfg.realtime ? hostsim_time_us() : sim_time_us;
+}
+
+static void _hostsim_wait_until(u64 due)
+{
+	if (!hostsim_cfg.realtime)
+		return;
+
+	u64 now = hostsim_time_us();
+	while (now < due)
+	{
+		// Sleep the bulk of it and spin the rest for accuracy.
+		if (due - now > 200)
+			usleep(due - now - 100);
+		now = hostsim_time_us();
+	}
+}
+
+static u32 _hostsim_rand()
+{
+	if (!rng)
+		rng = hostsim_cfg.seed ? hostsim_cfg.seed : 1;
+
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+
+	return rng;
+}
+
+static hostsim_dev_t *_hostsim_get_dev(sdmmc_storage_t *storage, int create)
+{
+	for (u32 i = 0; i < HOSTSIM_MAX_DEVS; i++)
+		if (devs[i].storage == storage)
+			return &devs[i];
+
+	if (!create)
+		return NULL;
+
+	for (u32 i = 0; i < HOSTSIM_MAX_DEVS; i++)
+	{
+		if (!devs[i].storage)
+		{
+			devs[i].storage = storage;
+			for (u32 part = 0; part < HOSTSIM_MAX_PARTS; part++)
+				devs[i].fd[part] = -1;
+
+			return &devs[i];
+		}
+	}
+
+	return NULL;
+}
+
+int hostsim_attach(sdmmc_storage_t *storage, u32 partition, const char *path, int writable)
+{
+	if (partition >= HOSTSIM_MAX_PARTS)
+		return 0;
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 1);
+	if (!dev)
+		return 0;
+
+	int fd = open(path, writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "hostsim: can't open %s: %s\n", path, strerror(errno));
+		return 0;
+	}
+
+	struct stat st;
+	fstat(fd, &st);
+
+	if (dev->fd[partition] >= 0)
+		close(dev->fd[partition]);
+
+	dev->fd[partition] = fd;
+	dev->size[partition] = st.st_size;
+	dev->writable[partition] = writable;
+
+	return 1;
+}
+
+int hostsim_set_timing(sdmmc_storage_t *storage, u32 cmd_latency_us, u32 sector_ns)
+{
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev)
+		return 0;
+
+	dev->timed = 1;
+	dev->cmd_latency_us = cmd_latency_us;
+	dev->sector_ns = sector_ns;
+
+	return 1;
+}
+
+void hostsim_detach_all()
+{
+	for (u32 i = 0; i < HOSTSIM_MAX_DEVS; i++)
+	{
+		for (u32 part = 0; part < HOSTSIM_MAX_PARTS; part++)
+			if (devs[i].storage && devs[i].fd[part] >= 0)
+				close(devs[i].fd[part]);
+
+		memset(&devs[i], 0, sizeof(hostsim_dev_t));
+	}
+}
+
+void hostsim_print_stats(FILE *out)
+{
+	fprintf(out, "reads:    %llu (%llu sectors)\n", (unsigned long long)hostsim_stats.reads,
+		(unsigned long long)hostsim_stats.sectors_read);
+	fprintf(out, "writes:   %llu (%llu sectors)\n", (unsigned long long)hostsim_stats.writes,
+		(unsigned long long)hostsim_stats.sectors_written);
+	fprintf(out, "trims:    %llu (%llu sectors)\n", (unsigned long long)hostsim_stats.trims,
+		(unsigned long long)hostsim_stats.sectors_trimmed);
+	fprintf(out, "retries:  %llu, failures: %llu\n", (unsigned long long)hostsim_stats.retries,
+		(unsigned long long)hostsim_stats.failures);
+	fprintf(out, "busy:     %llu us\n", (unsigned long long)hostsim_stats.busy_us);
+	fprintf(out, "bounces:  %llu (%llu sectors, %llu us)\n", (unsigned long long)hostsim_stats.bounces,
+		(unsigned long long)hostsim_stats.sectors_bounced, (unsigned long long)(hostsim_stats.bounce_ns / 1000));
+}
+
+// Charges the device with a command and its retries. Returns 0 if all attempts failed.
+// Devices are busy independently, like the SDMMC controllers.
+static int _hostsim_charge(hostsim_dev_t *dev, u32 num_sectors, u64 *due)
+{
+	u64 time = MAX(_hostsim_now(), dev->free_us);
+	u32 latency = dev->timed ? dev->cmd_latency_us : hostsim_cfg.cmd_latency_us;
+	u32 sector_ns = dev->timed ? dev->sector_ns : hostsim_cfg.sector_ns;
+	u64 cost = latency + ((u64)num_sectors * sector_ns) / 1000;
+	int res = 0;
+
+	for (u32 i = 0; i < HOSTSIM_RETRIES; i++)
+	{
+		time += cost;
+		hostsim_stats.busy_us += cost;
+
+		if (!hostsim_cfg.error_ppm || (_hostsim_rand() % 1000000) >= hostsim_cfg.error_ppm)
+		{
+			res = 1;
+			break;
+		}
+
+		hostsim_stats.retries++;
+	}
+
+	if (!res)
+		hostsim_stats.failures++;
+
+	dev->free_us = time;
+	sim_time_us = MAX(sim_time_us, time);
+	*due = time;
+
+	return res;
+}
+
+static int _hostsim_xfer(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev || !storage->initialized || storage->partition >= HOSTSIM_MAX_PARTS)
+		return 0;
+
+	u32 part = storage->partition;
+	u64 offset = (u64)sector << 9;
+	u64 size = (u64)num_sectors << 9;
+
+	if (dev->fd[part] < 0 || offset + size > dev->size[part] || (is_write && !dev->writable[part]))
+		return 0;
+
+	u8 *bbuf = (u8 *)buf;
+	while (size)
+	{
+		ssize_t res = is_write ? pwrite(dev->fd[part], bbuf, size, offset) :
+								 pread(dev->fd[part], bbuf, size, offset);
+		if (res <= 0)
+			return 0;
+
+		bbuf += res;
+		offset += res;
+		size -= res;
+	}
+
+	if (is_write)
+	{
+		hostsim_stats.writes++;
+		hostsim_stats.sectors_written += num_sectors;
+	}
+	else
+	{
+		hostsim_stats.reads++;
+		hostsim_stats.sectors_read += num_sectors;
+	}
+
+	return 1;
+}
+
+/*
+* Async request queue. Requests are charged at submit time and transfer their data on completion.
+*/
+
+static void _hostsim_async_process(u64 now)
+{
+	while (queue_cnt && (!hostsim_cfg.realtime || queue[queue_head].due <= now))
+	{
+		hostsim_req_t *req = &queue[queue_head];
+		sdmmc_async_t *async = req->async;
+
+		int res = req->ok && _hostsim_xfer(async->storage, async->sector, async->num_sectors, async->buf, async->is_write);
+		async->status = res ? SDMMC_ASYNC_DONE : SDMMC_ASYNC_FAILED;
+
+		queue_head = (queue_head + 1) % SDMMC_ASYNC_QUEUE_SZ;
+		queue_cnt--;
+	}
+}
+
+// Finishes the queued requests of the device of storage and the ones ahead of them.
+static void _hostsim_async_drain(sdmmc_storage_t *storage)
+{
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	sdmmc_async_t *last = NULL;
+
+	for (u32 i = 0; i < queue_cnt; i++)
+	{
+		sdmmc_async_t *async = queue[(queue_head + i) % SDMMC_ASYNC_QUEUE_SZ].async;
+		if (hostsim_cfg.drain_all || _hostsim_get_dev(async->storage, 0) == dev)
+			last = async;
+	}
+
+	while (last && last->status == SDMMC_ASYNC_BUSY)
+	{
+		_hostsim_wait_until(queue[queue_head].due);
+		_hostsim_async_process(_hostsim_now());
+	}
+}
+
+static int _hostsim_readwrite_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	async->storage = storage;
+	async->sector = sector;
+	async->num_sectors = num_sectors;
+	async->buf = buf;
+	async->is_write = is_write;
+	async->started = 1;
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev)
+	{
+		async->status = SDMMC_ASYNC_FAILED;
+		return async->status;
+	}
+
+	// Make room if queue is full.
+	if (queue_cnt == SDMMC_ASYNC_QUEUE_SZ)
+	{
+		_hostsim_wait_until(queue[queue_head].due);
+		_hostsim_async_process(_hostsim_now());
+	}
+
+	hostsim_req_t *req = &queue[(queue_head + queue_cnt) % SDMMC_ASYNC_QUEUE_SZ];
+	req->async = async;
+	req->ok = _hostsim_charge(dev, num_sectors, &req->due);
+	queue_cnt++;
+
+	async->status = SDMMC_ASYNC_BUSY;
+
+	return async->status;
+}
+
+int sdmmc_storage_read_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf)
+{
+	return _hostsim_readwrite_async(storage, async, sector, num_sectors, buf, 0);
+}
+
+int sdmmc_storage_write_async(sdmmc_storage_t *storage, sdmmc_async_t *async, u32 sector, u32 num_sectors, void *buf)
+{
+	return _hostsim_readwrite_async(storage, async, sector, num_sectors, buf, 1);
+}
+
+int sdmmc_storage_poll(sdmmc_async_t *async)
+{
+	_hostsim_async_process(_hostsim_now());
+
+	return async->status;
+}
+
+int sdmmc_storage_wait(sdmmc_async_t *async)
+{
+	while (async->status == SDMMC_ASYNC_BUSY)
+	{
+		_hostsim_wait_until(queue[queue_head].due);
+		_hostsim_async_process(_hostsim_now());
+	}
+
+	return async->status;
+}
+
+/*
+* Blocking API.
+*/
+
+// Buffers the BPMP would have in IRAM: data, BSS and the stack of the caller.
+static bool _hostsim_is_iram(void *buf)
+{
+	uptr addr = (uptr)buf;
+
+	if (addr >= (uptr)__data_start && addr < (uptr)_end)
+		return true;
+
+	return addr >= (uptr)__builtin_frame_address(0) && addr < (uptr)__libc_stack_end;
+}
+
+static u64 _hostsim_time_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int _hostsim_readwrite(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	u64 due;
+	u8 *xfer_buf = (u8 *)buf;
+	bool bounce = _hostsim_is_iram(buf) || ((uptr)buf % 8);
+
+	_hostsim_async_drain(storage);
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev)
+		return 0;
+
+	if (bounce)
+	{
+		if (num_sectors > upper_buf_sectors)
+		{
+			free(upper_buf);
+			upper_buf = (u8 *)malloc((size_t)num_sectors << 9);
+			upper_buf_sectors = upper_buf ? num_sectors : 0;
+			if (!upper_buf)
+				return 0;
+		}
+
+		xfer_buf = upper_buf;
+		sdmmc_bounce_count++;
+		hostsim_stats.bounces++;
+		hostsim_stats.sectors_bounced += num_sectors;
+
+		if (is_write)
+		{
+			u64 start = _hostsim_time_ns();
+			memcpy(xfer_buf, buf, (size_t)num_sectors << 9);
+			hostsim_stats.bounce_ns += _hostsim_time_ns() - start;
+		}
+	}
+
+	if (!_hostsim_charge(dev, num_sectors, &due))
+		return 0;
+
+	_hostsim_wait_until(due);
+
+	if (!_hostsim_xfer(storage, sector, num_sectors, xfer_buf, is_write))
+		return 0;
+
+	if (bounce && !is_write)
+	{
+		u64 start = _hostsim_time_ns();
+		memcpy(buf, xfer_buf, (size_t)num_sectors << 9);
+		hostsim_stats.bounce_ns += _hostsim_time_ns() - start;
+	}
+
+	return 1;
+}
+
+int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _hostsim_readwrite(storage, sector, num_sectors, buf, 0);
+}
+
+int sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _hostsim_readwrite(storage, sector, num_sectors, buf, 1);
+}
+
+// Discard is only accounted. Image contents stay, like on a card that ignores it.
+int sdmmc_storage_erase(sdmmc_storage_t *storage, u32 sector, u32 num_sectors)
+{
+	u64 due;
+
+	_hostsim_async_drain(storage);
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!storage->initialized || !dev)
+		return 0;
+
+	if (!_hostsim_charge(dev, 0, &due))
+		return 0;
+
+	_hostsim_wait_until(due);
+
+	hostsim_stats.trims++;
+	hostsim_stats.sectors_trimmed += num_sectors;
+
+	return 1;
+}
+
+static int _hostsim_storage_init(sdmmc_storage_t *storage, sdmmc_t *sdmmc)
+{
+	_hostsim_async_drain(storage);
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev || dev->fd[0] < 0)
+		return 0;
+
+	storage->sdmmc = sdmmc;
+	storage->has_sector_access = 1;
+	storage->partition = 0;
+	storage->sec_cnt = dev->size[0] >> 9;
+	storage->initialized = 1;
+
+	return 1;
+}
+
+int sdmmc_storage_init_mmc(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 bus_width, u32 type)
+{
+	return _hostsim_storage_init(storage, sdmmc);
+}
+
+int sdmmc_storage_init_sd(sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 bus_width, u32 type)
+{
+	return _hostsim_storage_init(storage, sdmmc);
+}
+
+int sdmmc_storage_set_mmc_partition(sdmmc_storage_t *storage, u32 partition)
+{
+	_hostsim_async_drain(storage);
+
+	hostsim_dev_t *dev = _hostsim_get_dev(storage, 0);
+	if (!dev || partition >= HOSTSIM_MAX_PARTS || dev->fd[partition] < 0)
+		return 0;
+
+	storage->partition = partition;
+
+	return 1;
+}
+
+int sdmmc_storage_end(sdmmc_storage_t *storage)
+{
+	_hostsim_async_drain(storage);
+
+	storage->initialized = 0;
+
+	return 1;
+}
+
+bool sdmmc_get_sd_inserted()
+{
+	return _hostsim_get_dev(&sd_storage, 0) != NULL;
+}
+
+u32 sd_storage_get_ssr_au(sdmmc_storage_t *storage)
+{
+	return hostsim_cfg.au_kb;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ff_wtoupper() benchmark.
+ * ffunicode.c is built once per FF_UPCASE_TBL setting. Every build is checked
+ * against the compressed tables over the whole BMP, then timed on up-case
+ * folding of file names like the ones found on a Switch SD card.
+ *
+ * With -g, prints the FF_UPCASE_TBL 2 page tables, generated from the compressed
+ * tables.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libs/fatfs/ff.h>
+
+#define UPBENCH_TBLS 3
+#define UPBENCH_BLK  16  // Code points per block.
+#define UPBENCH_ROW  16  // Blocks per row.
+
+DWORD ff_wtoupper_0(DWORD uni);
+DWORD ff_wtoupper_1(DWORD uni);
+DWORD ff_wtoupper_2(DWORD uni);
+
+static DWORD (*const upbench_fn[UPBENCH_TBLS])(DWORD) = { ff_wtoupper_0, ff_wtoupper_1, ff_wtoupper_2 };
+
+static const char *upbench_desc[UPBENCH_TBLS] = {
+	"compressed tables", "ASCII fast path", "page tables"
+};
+
+// UTF-8 file names: payload and hekate files, title and NCA names, and some user files.
+static const char *upbench_names[] = {
+	"bootloader", "hekate_ipl.ini", "payloads", "warmboot_mariko", "wb_17.bin", "wb_18.bin",
+	"Nintendo", "Contents", "registered", "placehld", "private", "save", "Album", "atmosphere",
+	"0100000000001000", "010000000000100D", "01007EF00011E000", "exefs", "romfs.bin",
+	"0a4b9c1d7e2f3a5b6c8d9e0f1a2b3c4d.nca", "ffe0d1c2b3a4958677685a4b3c2d1e0f.cnmt.nca",
+	"2023091512345600-57B4628D2267231D57E0FC1078C0596D.jpg", "screenshot_2024-01-01.png",
+	"Mario Kart 8 Deluxe [0100152000022000][v0].nsp", "The Legend of Zelda - Tears of the Kingdom.xci",
+	"Pokémon Écarlate", "Café Überraschung.txt", "Ärger mit Öl.sav", "façade naïve.bak",
+	"Покемон Скарлет", "Сохранение_01.dat", "Ελληνικά αρχεία.txt", "ゼルダの伝説.sav", "スーパーマリオ.bin",
+	"ｆｕｌｌｗｉｄｔｈ.txt", "emummc.ini", "sxos", "switch", "tinfoil", "DBI.nro", "hbmenu.nro",
+};
+
+static WCHAR *upbench_text;
+static u32 upbench_len;
+
+static u32 _upbench_utf8_next(const char **s)
+{
+	const u8 *p = (const u8 *)*s;
+	u32 c = *p++;
+
+	if (c >= 0xE0)
+	{
+		c = ((c & 0x0F) << 12) | ((p[0] & 0x3F) << 6) | (p[1] & 0x3F);
+		p += 2;
+	}
+	else if (c >= 0xC0)
+		c = ((c & 0x1F) << 6) | (*p++ & 0x3F);
+
+	*s = (const char *)p;
+
+	return c;
+}
+
+static void _upbench_load_names()
+{
+	u32 total = 0;
+
+	for (u32 i = 0; i < ARRAY_SIZE(upbench_names); i++)
+		total += strlen(upbench_names[i]);
+
+	upbench_text = malloc(total * sizeof(WCHAR));
+	for (u32 i = 0; i < ARRAY_SIZE(upbench_names); i++)
+		for (const char *s = upbench_names[i]; *s; )
+			upbench_text[upbench_len++] = _upbench_utf8_next(&s);
+}
+
+static int _upbench_verify()
+{
+	int res = 0;
+
+	for (u32 t = 1; t < UPBENCH_TBLS; t++)
+	{
+		for (DWORD c = 0; c < 0x10100; c++)
+		{
+			if (upbench_fn[t](c) != upbench_fn[0](c))
+			{
+				fprintf(stderr, "upbench: FF_UPCASE_TBL %u: U+%04X -> U+%04X, expected U+%04X\n",
+					t, c, upbench_fn[t](c), upbench_fn[0](c));
+				res = 1;
+				break;
+			}
+		}
+	}
+
+	return res;
+}
+
+static double _upbench_time(DWORD (*fn)(DWORD), u32 rounds)
+{
+	struct timespec start, end;
+	volatile DWORD sink = 0;
+	DWORD sum = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (u32 r = 0; r < rounds; r++)
+		for (u32 i = 0; i < upbench_len; i++)
+			sum += fn(upbench_text[i]);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sink = sum;
+	(void)sink;
+
+	double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+
+	return ns / ((double)rounds * upbench_len);
+}
+
+// Prints values as hex, per_line on each line. Rows are wrapped in braces.
+static void _upbench_print(const u8 *data, const WORD *words, u32 len, u32 per_line, int row)
+{
+	for (u32 i = 0; i < len; i++)
+	{
+		if (!(i % per_line))
+			printf("\t\t%s", row ? "{" : "");
+
+		if (words)
+			printf("0x%04X", words[i]);
+		else
+			printf("0x%02X", data[i]);
+
+		if (i == len - 1)
+			printf(row ? "}" : "\n");
+		else if (i % per_line == per_line - 1)
+			printf(",\n");
+		else
+			printf(",");
+	}
+}
+
+// Splits the BMP into rows of blocks, and stores each distinct row, block and delta once.
+static void _upbench_generate()
+{
+	static u8 rows[0x10000 / (UPBENCH_BLK * UPBENCH_ROW)];
+	static u8 row_tbl[256][UPBENCH_ROW];
+	static u8 blk_tbl[256][UPBENCH_BLK];
+	static WORD deltas[256];
+	u32 row_cnt = 0, blk_cnt = 0, delta_cnt = 0;
+	u32 j;
+
+	for (u32 r = 0; r < ARRAY_SIZE(rows); r++)
+	{
+		u8 row[UPBENCH_ROW];
+
+		for (u32 b = 0; b < UPBENCH_ROW; b++)
+		{
+			u8 blk[UPBENCH_BLK];
+
+			for (u32 i = 0; i < UPBENCH_BLK; i++)
+			{
+				DWORD c = (r * UPBENCH_ROW + b) * UPBENCH_BLK + i;
+				WORD d = ff_wtoupper_0(c) - c;
+
+				for (j = 0; j < delta_cnt && deltas[j] != d; j++)
+					;
+				if (j == delta_cnt)
+					deltas[delta_cnt++] = d;
+				blk[i] = j;
+			}
+
+			for (j = 0; j < blk_cnt && memcmp(blk_tbl[j], blk, UPBENCH_BLK); j++)
+				;
+			if (j == blk_cnt)
+				memcpy(blk_tbl[blk_cnt++], blk, UPBENCH_BLK);
+			row[b] = j;
+		}
+
+		for (j = 0; j < row_cnt && memcmp(row_tbl[j], row, UPBENCH_ROW); j++)
+			;
+		if (j == row_cnt)
+			memcpy(row_tbl[row_cnt++], row, UPBENCH_ROW);
+		rows[r] = j;
+	}
+
+	printf("\tstatic const BYTE uct1[] = {	/* Row of each 256 code points */\n");
+	_upbench_print(rows, NULL, ARRAY_SIZE(rows), 16, 0);
+	printf("\t};\n\tstatic const BYTE uct2[][16] = {	/* Block of each 16 code points in a row */\n");
+	for (u32 i = 0; i < row_cnt; i++)
+	{
+		_upbench_print(row_tbl[i], NULL, UPBENCH_ROW, UPBENCH_ROW, 1);
+		printf(i == row_cnt - 1 ? "\n" : ",\n");
+	}
+	printf("\t};\n\tstatic const BYTE uct3[][16] = {	/* Delta index of each code point in a block */\n");
+	for (u32 i = 0; i < blk_cnt; i++)
+	{
+		_upbench_print(blk_tbl[i], NULL, UPBENCH_BLK, UPBENCH_BLK, 1);
+		printf(i == blk_cnt - 1 ? "\n" : ",\n");
+	}
+	printf("\t};\n\tstatic const WORD uctd[] = {	/* Up conversion deltas */\n");
+	_upbench_print(NULL, deltas, delta_cnt, 8, 0);
+	printf("\t};\n");
+
+	fprintf(stderr, "upbench: %u rows, %u blocks, %u deltas, %u bytes\n", row_cnt, blk_cnt, delta_cnt,
+		(u32)ARRAY_SIZE(rows) + (row_cnt * UPBENCH_ROW) + (blk_cnt * UPBENCH_BLK) + delta_cnt * 2);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: upbench [options]\n"
+		"  -n <rounds>  Passes over the file names (default: 20000)\n"
+		"  -g           Print the FF_UPCASE_TBL 2 tables and exit\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	u32 rounds = 20000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:g")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': rounds = strtoul(optarg, NULL, 0); break;
+		case 'g':
+			_upbench_generate();
+			return 0;
+		default: _usage();
+		}
+	}
+
+	if (!rounds)
+		_usage();
+
+	if (_upbench_verify())
+		return 1;
+
+	_upbench_load_names();
+	printf("%u names, %u characters, %u passes\n", (u32)ARRAY_SIZE(upbench_names), upbench_len, rounds);
+
+	double base = 0;
+	for (u32 t = 0; t < UPBENCH_TBLS; t++)
+	{
+		double ns = _upbench_time(upbench_fn[t], rounds);
+		if (!t)
+			base = ns;
+		printf("  FF_UPCASE_TBL %u  %-18s %6.2f ns/char  %5.1fx\n", t, upbench_desc[t], ns, base / ns);
+	}
+
+	return 0;
+}
@@ -92,6 +92,11 @@
    you. */
 #define LZ_MAX_OFFSET 100000
 
+/* Maximum match length of LZ_CompressOptimal(). Every length up to it is
+   priced at each position, so it bounds the time spent on long runs. A
+   longer match costs a few bytes per LZ_OPT_MAX_LENGTH bytes. */
+#define LZ_OPT_MAX_LENGTH 2048
+
 
 
 /*************************************************************************
@@ -114,6 +119,21 @@ static unsigned int _LZ_StringCompare( unsigned char * str1,
 }
 
 
+/*************************************************************************
+* _LZ_Hash4() - Return 16-bit hash of four symbols.
+*************************************************************************/
+
+static unsigned int _LZ_Hash4( unsigned char * str )
+{
+    unsigned int x;
+
+    x = ((unsigned int)str[0]) | (((unsigned int)str[1]) << 8) |
+        (((unsigned int)str[2]) << 16) | (((unsigned int)str[3]) << 24);
+
+    return (x * 2654435761u) >> 16;
+}
+
+
 /*************************************************************************
 * _LZ_WriteVarSize() - Write unsigned integer with variable number of
 * bytes depending on value.
@@ -149,6 +169,20 @@ static int _LZ_WriteVarSize( unsigned int x, unsigned char * buf )
 }
 
 
+/*************************************************************************
+* _LZ_VarSize() - Return number of bytes _LZ_WriteVarSize() uses for x.
+*************************************************************************/
+
+static unsigned int _LZ_VarSize( unsigned int x )
+{
+    unsigned int num_bytes;
+
+    for( num_bytes = 1; (num_bytes < 5) && (x >> (num_bytes*7)); ++ num_bytes );
+
+    return num_bytes;
+}
+
+
 /*************************************************************************
 * _LZ_ReadVarSize() - Read unsigned integer with variable number of
 * bytes depending on value.
@@ -482,6 +516,345 @@ int LZ_CompressFast( unsigned char *in, unsigned char *out,
 }
 
 
+/*************************************************************************
+* LZ_CompressChain() - Compress a block of data using an LZ77 coder.
+*  in       - Input (uncompressed) buffer.
+*  out      - Output (compressed) buffer. This buffer must be 0.4% larger
+*             than the input buffer, plus one byte.
+*  insize   - Number of input bytes.
+*  work     - Pointer to a temporary buffer (internal working buffer), which
+*             must be able to hold (insize+65536) unsigned integers.
+*  maxchain - Maximum number of candidates to check per position, or 0 to
+*             check all of them.
+* The function returns the size of the compressed data. With maxchain 0
+* the output is identical to the output of LZ_CompressFast().
+*************************************************************************/
+
+int LZ_CompressChain( unsigned char *in, unsigned char *out,
+    unsigned int insize, unsigned int *work, unsigned int maxchain )
+{
+    unsigned char marker, symbol;
+    unsigned int  inpos, outpos, bytesleft, i, index, hash, chain;
+    unsigned int  offset, bestoffset;
+    unsigned int  maxlength, length, bestlength;
+    unsigned int  histogram[ 256 ], *head, *prev;
+    unsigned char *ptr1, *ptr2;
+
+    /* Do we have anything to compress? */
+    if( insize < 1 )
+    {
+        return 0;
+    }
+
+    /* Assign arrays to the working area */
+    head = work;
+    prev = &work[ 65536 ];
+
+    /* Build hash chains. Like the jump table of LZ_CompressFast(), prev[i]
+       points to the nearest previous position with the same hash, but the
+       hash covers four symbols instead of two. Only matches of four or
+       more symbols are ever coded, so every position that can give such a
+       match is still on the chain, in the same order, while the chains get
+       a lot shorter. Hash collisions are filtered out by the compare. */
+    for( i = 0; i < 65536; ++ i )
+    {
+        head[ i ] = 0xffffffff;
+    }
+    for( i = 0; i + 3 < insize; ++ i )
+    {
+        hash = _LZ_Hash4( &in[ i ] );
+        prev[ i ] = head[ hash ];
+        head[ hash ] = i;
+    }
+    for( ; i < insize; ++ i )
+    {
+        prev[ i ] = 0xffffffff;
+    }
+
+    /* Create histogram */
+    for( i = 0; i < 256; ++ i )
+    {
+        histogram[ i ] = 0;
+    }
+    for( i = 0; i < insize; ++ i )
+    {
+        ++ histogram[ in[ i ] ];
+    }
+
+    /* Find the least common byte, and use it as the marker symbol */
+    marker = 0;
+    for( i = 1; i < 256; ++ i )
+    {
+        if( histogram[ i ] < histogram[ marker ] )
+        {
+            marker = i;
+        }
+    }
+
+    /* Remember the marker symbol for the decoder */
+    out[ 0 ] = marker;
+
+    /* Start of compression */
+    inpos = 0;
+    outpos = 1;
+
+    /* Main compression loop */
+    bytesleft = insize;
+    do
+    {
+        /* Get pointer to current position */
+        ptr1 = &in[ inpos ];
+
+        /* Search history window for maximum length string match */
+        bestlength = 3;
+        bestoffset = 0;
+        chain = maxchain;
+        index = prev[ inpos ];
+        while( (index != 0xffffffff) && ((inpos - index) < LZ_MAX_OFFSET) )
+        {
+            /* Get pointer to candidate string */
+            ptr2 = &in[ index ];
+
+            /* Matches can not be longer than the offset, so near
+               candidates may not be able to beat the best one */
+            offset = inpos - index;
+            if( (offset > bestlength) && (ptr2[ bestlength ] == ptr1[ bestlength ]) )
+            {
+                /* Determine maximum length for this offset */
+                maxlength = (bytesleft < offset ? bytesleft : offset);
+
+                /* Count maximum length match at this offset */
+                length = _LZ_StringCompare( ptr1, ptr2, 0, maxlength );
+
+                /* Better match than any previous match? */
+                if( length > bestlength )
+                {
+                    bestlength = length;
+                    bestoffset = offset;
+
+                    /* Nothing can beat a match of all remaining bytes */
+                    if( bestlength == bytesleft ) break;
+                }
+            }
+
+            if( chain && !-- chain ) break;
+
+            /* Get next possible index from hash chain */
+            index = prev[ index ];
+        }
+
+        /* Was there a good enough match? */
+        if( (bestlength >= 8) ||
+            ((bestlength == 4) && (bestoffset <= 0x0000007f)) ||
+            ((bestlength == 5) && (bestoffset <= 0x00003fff)) ||
+            ((bestlength == 6) && (bestoffset <= 0x001fffff)) ||
+            ((bestlength == 7) && (bestoffset <= 0x0fffffff)) )
+        {
+            out[ outpos ++ ] = (unsigned char) marker;
+            outpos += _LZ_WriteVarSize( bestlength, &out[ outpos ] );
+            outpos += _LZ_WriteVarSize( bestoffset, &out[ outpos ] );
+            inpos += bestlength;
+            bytesleft -= bestlength;
+        }
+        else
+        {
+            /* Output single byte (or two bytes if marker byte) */
+            symbol = in[ inpos ++ ];
+            out[ outpos ++ ] = symbol;
+            if( symbol == marker )
+            {
+                out[ outpos ++ ] = 0;
+            }
+            -- bytesleft;
+        }
+    }
+    while( bytesleft > 3 );
+
+    /* Dump remaining bytes, if any */
+    while( inpos < insize )
+    {
+        if( in[ inpos ] == marker )
+        {
+            out[ outpos ++ ] = marker;
+            out[ outpos ++ ] = 0;
+        }
+        else
+        {
+            out[ outpos ++ ] = in[ inpos ];
+        }
+        ++ inpos;
+    }
+
+    return outpos;
+}
+
+
+/*************************************************************************
+* LZ_CompressOptimal() - Compress a block of data using an LZ77 coder
+* with optimal parsing.
+*  in       - Input (uncompressed) buffer.
+*  out      - Output (compressed) buffer. This buffer must be 0.4% larger
+*             than the input buffer, plus one byte.
+*  insize   - Number of input bytes.
+*  work     - Pointer to a temporary buffer (internal working buffer), which
+*             must be able to hold (4*insize+65537) unsigned integers.
+*  maxchain - Maximum number of candidates to check per position, or 0 to
+*             check all of them.
+* The function returns the size of the compressed data.
+*
+* Instead of taking the longest match at each position, every position
+* gets the cheapest coding of the rest of the input, from the end to the
+* start. The choices are: a literal, or a match of any length that one of
+* the candidates on the hash chain can give. So a shorter match, or a few
+* literals, are used when they let the next match start at a better
+* place. Matches may overlap the bytes they produce, which LZ_Uncompress()
+* copies byte by byte. The stream format is unchanged.
+*************************************************************************/
+
+int LZ_CompressOptimal( unsigned char *in, unsigned char *out,
+    unsigned int insize, unsigned int *work, unsigned int maxchain )
+{
+    unsigned char marker, symbol;
+    unsigned int  inpos, outpos, i, index, hash, chain;
+    unsigned int  offset, offsetcost, maxlength, length, covered;
+    unsigned int  histogram[ 256 ], *head, *prev, *cost, *mlen, *moff;
+    unsigned int  c;
+    unsigned char *ptr1;
+
+    /* Do we have anything to compress? */
+    if( insize < 1 )
+    {
+        return 0;
+    }
+
+    /* Assign arrays to the working area */
+    head = work;
+    prev = &work[ 65536 ];
+    cost = &prev[ insize ];
+    mlen = &cost[ insize + 1 ];
+    moff = &mlen[ insize ];
+
+    /* Build hash chains, see LZ_CompressChain() */
+    for( i = 0; i < 65536; ++ i )
+    {
+        head[ i ] = 0xffffffff;
+    }
+    for( i = 0; i + 3 < insize; ++ i )
+    {
+        hash = _LZ_Hash4( &in[ i ] );
+        prev[ i ] = head[ hash ];
+        head[ hash ] = i;
+    }
+    for( ; i < insize; ++ i )
+    {
+        prev[ i ] = 0xffffffff;
+    }
+
+    /* Create histogram */
+    for( i = 0; i < 256; ++ i )
+    {
+        histogram[ i ] = 0;
+    }
+    for( i = 0; i < insize; ++ i )
+    {
+        ++ histogram[ in[ i ] ];
+    }
+
+    /* Find the least common byte, and use it as the marker symbol */
+    marker = 0;
+    for( i = 1; i < 256; ++ i )
+    {
+        if( histogram[ i ] < histogram[ marker ] )
+        {
+            marker = i;
+        }
+    }
+
+    /* Find the cheapest coding of in[inpos..insize-1] for every position,
+       starting from the end. mlen is 0 for a literal. */
+    cost[ insize ] = 0;
+    inpos = insize;
+    while( inpos -- > 0 )
+    {
+        ptr1 = &in[ inpos ];
+
+        /* Literal (or two bytes if marker byte) */
+        cost[ inpos ] = cost[ inpos + 1 ] + (ptr1[ 0 ] == marker ? 2 : 1);
+        mlen[ inpos ] = 0;
+        moff[ inpos ] = 0;
+
+        /* Candidates come nearest first. A length is cheapest with the
+           nearest offset that gives it, so each candidate only adds the
+           lengths beyond the ones covered by nearer candidates. */
+        maxlength = insize - inpos;
+        if( maxlength > LZ_OPT_MAX_LENGTH ) maxlength = LZ_OPT_MAX_LENGTH;
+        covered = 3;
+        chain = maxchain;
+        index = prev[ inpos ];
+        while( (index != 0xffffffff) && ((inpos - index) < LZ_MAX_OFFSET) )
+        {
+            if( in[ index + covered ] == ptr1[ covered ] )
+            {
+                offset = inpos - index;
+                length = _LZ_StringCompare( ptr1, &in[ index ], 0, maxlength );
+                if( length > covered )
+                {
+                    offsetcost = 1 + _LZ_VarSize( offset );
+                    for( ++ covered; covered <= length; ++ covered )
+                    {
+                        c = offsetcost + _LZ_VarSize( covered ) + cost[ inpos + covered ];
+                        if( c < cost[ inpos ] )
+                        {
+                            cost[ inpos ] = c;
+                            mlen[ inpos ] = covered;
+                            moff[ inpos ] = offset;
+                        }
+                    }
+                    covered = length;
+
+                    /* No candidate can give a longer match */
+                    if( covered == maxlength ) break;
+                }
+            }
+
+            if( chain && !-- chain ) break;
+
+            /* Get next possible index from hash chain */
+            index = prev[ index ];
+        }
+    }
+
+    /* Remember the marker symbol for the decoder */
+    out[ 0 ] = marker;
+
+    /* Write the chosen coding */
+    inpos = 0;
+    outpos = 1;
+    while( inpos < insize )
+    {
+        if( mlen[ inpos ] )
+        {
+            out[ outpos ++ ] = (unsigned char) marker;
+            outpos += _LZ_WriteVarSize( mlen[ inpos ], &out[ outpos ] );
+            outpos += _LZ_WriteVarSize( moff[ inpos ], &out[ outpos ] );
+            inpos += mlen[ inpos ];
+        }
+        else
+        {
+            /* Output single byte (or two bytes if marker byte) */
+            symbol = in[ inpos ++ ];
+            out[ outpos ++ ] = symbol;
+            if( symbol == marker )
+            {
+                out[ outpos ++ ] = 0;
+            }
+        }
+    }
+
+    return outpos;
+}
+
+
 /*************************************************************************
 * LZ_Uncompress() - Uncompress a block of data using an LZ77 decoder.
 *  in      - Input (compressed) buffer.
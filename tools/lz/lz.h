@@ -50,6 +50,12 @@ int LZ_Compress( unsigned char *in, unsigned char *out,
                  unsigned int insize );
 int LZ_CompressFast( unsigned char *in, unsigned char *out,
                      unsigned int insize, unsigned int *work );
+int LZ_CompressChain( unsigned char *in, unsigned char *out,
+                      unsigned int insize, unsigned int *work,
+                      unsigned int maxchain );
+int LZ_CompressOptimal( unsigned char *in, unsigned char *out,
+                        unsigned int insize, unsigned int *work,
+                        unsigned int maxchain );
 int LZ_Uncompress( unsigned char *in, unsigned char *out,
                     unsigned int insize );
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * LZ4 block encoder with optimal parsing, for output that LZ4_decompress_safe
+ * decodes. Like LZ_CompressOptimal, it finds the cheapest coding of the rest of
+ * the input for every position, from the end to the start. Literals cost a byte
+ * and a match costs its token, offset and length bytes. The extra length bytes
+ * of literal runs of 15 and more are not priced.
+ */
+
+#include "lz4opt.h"
+
+#define LZ4_MIN_MATCH     4
+#define LZ4_LAST_LITERALS 5     // Last bytes of a block are always literals.
+#define LZ4_MF_LIMIT      12    // Last match must start this far from the end.
+#define LZ4_MAX_OFFSET    65535
+#define LZ4_OPT_MAX_LEN   4096  // Longer matches are split. Bounds the pricing work.
+
+static unsigned int _lz4_hash4(const unsigned char *p)
+{
+	unsigned int x = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+
+	return (x * 2654435761u) >> 16;
+}
+
+// Extra bytes of a length that does not fit in its token nibble.
+static unsigned int _lz4_len_extra(unsigned int len)
+{
+	return len < 15 ? 0 : 1 + (len - 15) / 255;
+}
+
+static unsigned char *_lz4_write_len(unsigned char *op, unsigned int len)
+{
+	if (len < 15)
+		return op;
+
+	for (len -= 15; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+static unsigned char *_lz4_write_seq(unsigned char *op, const unsigned char *lit, unsigned int lit_len,
+	unsigned int offset, unsigned int match_len)
+{
+	unsigned int ml = match_len ? match_len - LZ4_MIN_MATCH : 0;
+
+	*op++ = ((lit_len < 15 ? lit_len : 15) << 4) | (ml < 15 ? ml : 15);
+	op = _lz4_write_len(op, lit_len);
+	for (unsigned int i = 0; i < lit_len; i++)
+		*op++ = lit[i];
+
+	if (match_len)
+	{
+		*op++ = offset & 0xFF;
+		*op++ = offset >> 8;
+		op = _lz4_write_len(op, ml);
+	}
+
+	return op;
+}
+
+/*
+ * in     - Input buffer.
+ * out    - Output buffer of LZ4_OPT_BOUND(insize) bytes.
+ * insize - Number of input bytes.
+ * work   - Buffer of LZ4_OPT_WORK_SIZE(insize) unsigned ints.
+ * Returns the size of the LZ4 block.
+ */
+int LZ4_CompressOptimal(const unsigned char *in, unsigned char *out, unsigned int insize, unsigned int *work)
+{
+	unsigned int *head = work;
+	unsigned int *prev = &work[65536];
+	unsigned int *cost = &prev[insize];
+	unsigned int *mlen = &cost[insize + 1];
+	unsigned int *moff = &mlen[insize];
+	unsigned int i;
+
+	// Chain positions by a hash of their first four bytes, nearest first.
+	for (i = 0; i < 65536; i++)
+		head[i] = 0xFFFFFFFF;
+	for (i = 0; i + 3 < insize; i++)
+	{
+		unsigned int hash = _lz4_hash4(&in[i]);
+		prev[i] = head[hash];
+		head[hash] = i;
+	}
+	for (; i < insize; i++)
+		prev[i] = 0xFFFFFFFF;
+
+	// Cheapest coding of in[pos..insize-1] for every position.
+	cost[insize] = 0;
+	for (unsigned int pos = insize; pos-- > 0; )
+	{
+		cost[pos] = cost[pos + 1] + 1;
+		mlen[pos] = 0;
+		moff[pos] = 0;
+
+		if (pos + LZ4_MF_LIMIT > insize)
+			continue;
+
+		unsigned int max_len = insize - LZ4_LAST_LITERALS - pos;
+		if (max_len > LZ4_OPT_MAX_LEN)
+			max_len = LZ4_OPT_MAX_LEN;
+
+		// All offsets cost the same, so each candidate only adds lengths beyond the nearer ones.
+		unsigned int covered = LZ4_MIN_MATCH - 1;
+		for (unsigned int idx = prev[pos]; idx != 0xFFFFFFFF && pos - idx <= LZ4_MAX_OFFSET; idx = prev[idx])
+		{
+			if (in[idx + covered] != in[pos + covered])
+				continue;
+
+			unsigned int len = 0;
+			while (len < max_len && in[idx + len] == in[pos + len])
+				len++;
+			if (len <= covered)
+				continue;
+
+			for (unsigned int l = covered + 1; l <= len; l++)
+			{
+				unsigned int c = 3 + _lz4_len_extra(l - LZ4_MIN_MATCH) + cost[pos + l];
+				if (c < cost[pos])
+				{
+					cost[pos] = c;
+					mlen[pos] = l;
+					moff[pos] = pos - idx;
+				}
+			}
+			covered = len;
+
+			if (covered >= max_len)
+				break;
+		}
+	}
+
+	// Write the sequences. The last one has literals only.
+	unsigned char *op = out;
+	unsigned int anchor = 0;
+	for (unsigned int pos = 0; pos < insize; )
+	{
+		if (!mlen[pos])
+		{
+			pos++;
+			continue;
+		}
+
+		op = _lz4_write_seq(op, &in[anchor], pos - anchor, moff[pos], mlen[pos]);
+		pos += mlen[pos];
+		anchor = pos;
+	}
+	op = _lz4_write_seq(op, &in[anchor], insize - anchor, 0, 0);
+
+	return op - out;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LZ4OPT_H_
+#define _LZ4OPT_H_
+
+// Work buffer size of LZ4_CompressOptimal in unsigned ints.
+#define LZ4_OPT_WORK_SIZE(insize) (4 * (insize) + 65537)
+// Worst case output size.
+#define LZ4_OPT_BOUND(insize) ((insize) + (insize) / 255 + 16)
+
+int LZ4_CompressOptimal(const unsigned char *in, unsigned char *out, unsigned int insize, unsigned int *work);
+
+#endif
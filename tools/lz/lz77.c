@@ -14,80 +14,426 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include "lz.h"
+#include "lz4opt.h"
+#include "../../bdk/libs/compr/lzrev.h"
+
+#define LZ_PARTS 2
+
+typedef struct _lz_part_t
+{
+	uint8_t *in;
+	uint32_t in_size;
+	uint8_t *out;
+	uint32_t out_size;
+	int nbytes;
+	int greedy_nbytes;
+	uint32_t gap;
+	double secs;
+} lz_part_t;
 
 char filename[1024];
+unsigned int maxchain;
+int optimal;
+int lz4;
+int inplace;
+
+static double _time_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _reverse(uint8_t *buf, uint32_t size)
+{
+	for (uint32_t i = 0; i < size / 2; i++)
+	{
+		uint8_t tmp = buf[i];
+		buf[i] = buf[size - 1 - i];
+		buf[size - 1 - i] = tmp;
+	}
+}
+
+static uint32_t _read_varsize(const uint8_t *buf, uint32_t *pos)
+{
+	uint32_t val = 0, b;
+
+	do
+	{
+		b = buf[(*pos)++];
+		val = (val << 7) | (b & 0x7F);
+	} while (b & 0x80);
+
+	return val;
+}
+
+static uint32_t _read_lz4_len(const uint8_t *buf, uint32_t *pos, uint32_t len)
+{
+	if (len == 15)
+	{
+		uint32_t b;
+		do
+		{
+			b = buf[(*pos)++];
+			len += b;
+		} while (b == 255);
+	}
+
+	return len;
+}
+
+/*
+ * Walks a compressed part in decode order and returns how far the output written gets
+ * ahead of the input read. Decoding back to front, every write stays above the input not
+ * read yet if the end of the input is at least that many bytes below the end of the output.
+ */
+static uint32_t _inplace_gap(const uint8_t *buf, uint32_t size)
+{
+	uint32_t pos = 0, len;
+	uint64_t out = 0;
+	int64_t gap = 0;
+
+	if (lz4)
+	{
+		while (pos < size)
+		{
+			uint8_t token = buf[pos++];
+
+			// Each literal is read right before it is written, so the run adds nothing.
+			len = _read_lz4_len(buf, &pos, token >> 4);
+			pos += len;
+			out += len;
+			if ((int64_t)(out - pos) > gap)
+				gap = out - pos;
+			if (pos >= size)
+				break;
+
+			pos += 2;
+			out += _read_lz4_len(buf, &pos, token & 0xF) + 4;
+			if ((int64_t)(out - pos) > gap)
+				gap = out - pos;
+		}
+	}
+	else if (size)
+	{
+		uint8_t marker = buf[pos++];
+		while (pos < size)
+		{
+			if (buf[pos++] != marker)
+				out++;
+			else if (!buf[pos])
+			{
+				pos++;
+				out++;
+			}
+			else
+			{
+				out += _read_varsize(buf, &pos);
+				_read_varsize(buf, &pos);
+			}
+			if ((int64_t)(out - pos) > gap)
+				gap = out - pos;
+		}
+	}
+
+	return gap;
+}
+
+// Decodes a reversed part with the loader decoder, laid out as tight as its gap allows.
+static int _inplace_check(const lz_part_t *part)
+{
+	uint32_t size = part->in_size;
+	if (size < part->gap + part->nbytes)
+		size = part->gap + part->nbytes;
+
+	uint8_t *mem = (uint8_t *)malloc(size);
+	if (!mem)
+		return 1;
+
+	uint8_t *out_end = mem + size;
+	memcpy(out_end - part->gap - part->nbytes, part->out, part->nbytes);
+	uint32_t res = lz4 ? lz4_uncompress_rev(out_end - part->gap - part->nbytes, part->nbytes, out_end) :
+						 lz_uncompress_rev(out_end - part->gap - part->nbytes, part->nbytes, out_end);
+	res = res != part->in_size || memcmp(out_end - part->in_size, part->in, part->in_size);
+
+	free(mem);
+
+	return res;
+}
+
+static int _write_layout(const lz_part_t *parts, const char *path)
+{
+	FILE *out_file = fopen(filename, "w");
+	if (!out_file)
+		return 1;
+
+	fprintf(out_file, "/* Generated by lz77 -i from %s. In-place layout of the packed parts. */\n", path);
+	for (int i = 0; i < LZ_PARTS; i++)
+	{
+		fprintf(out_file, "__payload_%02d_size = 0x%X;\n", i, parts[i].in_size);
+		fprintf(out_file, "__payload_%02d_gap = 0x%X;\n", i, parts[i].gap);
+	}
+
+	return fclose(out_file);
+}
+
+static void *_compress_part(void *arg)
+{
+	lz_part_t *part = (lz_part_t *)arg;
+	double start = _time_now();
+	uint8_t *in = part->in;
+
+	part->nbytes = -1;
+
+	// Packed back to front, for the loader decoders in lzrev.c.
+	if (inplace)
+	{
+		in = (uint8_t *)malloc(part->in_size);
+		if (!in)
+			return NULL;
+		memcpy(in, part->in, part->in_size);
+		_reverse(in, part->in_size);
+	}
+
+	part->out_size = part->in_size + part->in_size / 256 + 257;
+	if (lz4)
+		part->out_size = LZ4_OPT_BOUND(part->in_size);
+	part->out = (uint8_t *)malloc(part->out_size);
+
+	uint32_t work_size = (optimal || lz4) ? LZ4_OPT_WORK_SIZE(part->in_size) : (part->in_size + 65536);
+	uint32_t *work = (uint32_t *)malloc(sizeof(uint32_t) * work_size);
+	if (part->out && work)
+	{
+		if (lz4)
+			part->nbytes = LZ4_CompressOptimal(in, part->out, part->in_size, work);
+		else if (optimal)
+			part->nbytes = LZ_CompressOptimal(in, part->out, part->in_size, work, maxchain);
+		else
+			part->nbytes = LZ_CompressChain(in, part->out, part->in_size, work, maxchain);
+	}
+
+	if (inplace && part->nbytes >= 0)
+	{
+		part->gap = _inplace_gap(part->out, part->nbytes);
+		_reverse(part->out, part->nbytes);
+	}
+
+	part->secs = _time_now() - start;
+
+	// Greedy size for the size report. The output buffer is only used for its length.
+	part->greedy_nbytes = part->nbytes;
+	if (optimal && !lz4 && part->out && work)
+	{
+		uint8_t *greedy = (uint8_t *)malloc(part->out_size);
+		if (greedy)
+			part->greedy_nbytes = LZ_CompressChain(in, greedy, part->in_size, work, 0);
+		free(greedy);
+	}
+	free(work);
+	if (inplace)
+		free(in);
+
+	return NULL;
+}
+
+// Compresses each part again with LZ_CompressFast and checks the output and the round trip.
+static int _benchmark(lz_part_t *parts, double wall)
+{
+	int res = 0;
+	uint64_t total_in = 0, total_out = 0, total_ref = 0;
+	double total_secs = 0, total_ref_secs = 0;
+
+	printf("part     in size  %10s  ratio  %5s MB/s   fast out  fast MB/s\n", optimal ? "opt out" : "chain out",
+		optimal ? "opt" : "chain");
+	for (int i = 0; i < LZ_PARTS; i++)
+	{
+		lz_part_t *part = &parts[i];
+		uint8_t *ref = (uint8_t *)malloc(part->out_size);
+		uint8_t *unc = (uint8_t *)malloc(part->in_size + 1);
+		uint32_t *work = (uint32_t *)malloc(sizeof(uint32_t) * (part->in_size + 65536));
+		if (!ref || !unc || !work)
+			return 1;
+
+		double start = _time_now();
+		int ref_bytes = LZ_CompressFast(part->in, ref, part->in_size, work);
+		double ref_secs = _time_now() - start;
+
+		if (LZ_Uncompress(part->out, unc, part->nbytes) != part->in_size || memcmp(unc, part->in, part->in_size))
+		{
+			fprintf(stderr, "Part %d does not decompress to its input!\n", i);
+			res = 1;
+		}
+		if (!optimal && !maxchain && (ref_bytes != part->nbytes || memcmp(ref, part->out, ref_bytes)))
+		{
+			fprintf(stderr, "Part %d differs from LZ_CompressFast output!\n", i);
+			res = 1;
+		}
+
+		printf("%4d  %10u  %10d  %5.3f  %10.2f  %9d  %9.2f\n", i, part->in_size, part->nbytes,
+			(double)part->nbytes / part->in_size, part->in_size / part->secs / 1e6,
+			ref_bytes, part->in_size / ref_secs / 1e6);
+
+		total_in += part->in_size;
+		total_out += part->nbytes;
+		total_ref += ref_bytes;
+		total_secs += part->secs;
+		total_ref_secs += ref_secs;
+
+		free(ref);
+		free(unc);
+		free(work);
+	}
+
+	printf("all   %10llu  %10llu  %5.3f  %10.2f  %9llu  %9.2f\n", (unsigned long long)total_in,
+		(unsigned long long)total_out, (double)total_out / total_in, total_in / total_secs / 1e6,
+		(unsigned long long)total_ref, total_in / total_ref_secs / 1e6);
+	printf("Threaded: %.3f s (%.2f MB/s), LZ_CompressFast: %.3f s\n", wall, total_in / wall / 1e6, total_ref_secs);
+
+	return res;
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: lz77 [-o | -4] [-i] [-c <candidates>] [-b] <file>\n"
+		"Compresses both halves of the file in parallel to <file>.00.lz and <file>.01.lz.\n"
+		"  -o               Optimal parsing. Smaller output in the same format, and prints\n"
+		"                   the size against the greedy parsing\n"
+		"  -4               LZ4 blocks with optimal parsing, for LZ4_decompress_safe\n"
+		"  -i               Pack back to front for in-place decoding by the loader. Checks\n"
+		"                   the decode at the tightest layout and writes it to <file>.lz.ld\n"
+		"  -c <candidates>  Match candidates to check per position. 0 checks all of them\n"
+		"                   and without -o gives the same output as LZ_CompressFast\n"
+		"                   (default: 0)\n"
+		"  -b               Benchmark against LZ_CompressFast and verify the output\n");
+	exit(1);
+}
 
 int main(int argc, char *argv[])
 {
-	int nbytes;
 	int filename_len;
+	int bench = 0;
+	int opt;
 	struct stat statbuf;
 	FILE *in_file, *out_file;
+	lz_part_t parts[LZ_PARTS];
+	pthread_t threads[LZ_PARTS];
 
-	if(stat(argv[1], &statbuf))
+	while ((opt = getopt(argc, argv, "o4ic:b")) != -1)
+	{
+		switch (opt)
+		{
+		case 'o': optimal = 1; break;
+		case '4': lz4 = 1; break;
+		case 'i': inplace = 1; break;
+		case 'c': maxchain = strtoul(optarg, NULL, 0); break;
+		case 'b': bench = 1; break;
+		default: _usage();
+		}
+	}
+
+	// LZ4 output is checked by lzbench and -i output by its own decode.
+	if (optind != argc - 1 || (lz4 && (optimal || bench)) || (inplace && bench))
+		_usage();
+
+	const char *path = argv[optind];
+	if (stat(path, &statbuf))
 		goto error;
 
-	if((in_file=fopen(argv[1], "rb")) == NULL)
+	if ((in_file = fopen(path, "rb")) == NULL)
 		goto error;
 
-	strcpy(filename, argv[1]);
+	snprintf(filename, sizeof(filename) - 8, "%s", path);
 	filename_len = strlen(filename);
 
 	uint32_t in_size = statbuf.st_size;
 	uint8_t *in_buf  = (uint8_t *)malloc(in_size);
 
-	uint32_t out_size = statbuf.st_size + 257;
-	uint8_t *out_buf = (uint8_t *)malloc(out_size);
-
-	if(!(in_buf && out_buf))
+	if (!in_buf)
 		goto error;
 
-	if(fread(in_buf, 1, in_size, in_file) != in_size)
+	if (fread(in_buf, 1, in_size, in_file) != in_size)
 		goto error;
 
 	fclose(in_file);
 
-	uint32_t *work = (uint32_t*)malloc(sizeof(uint32_t) * (in_size + 65536));
-	for (int i = 0; i < 2; i++)
+	// The halves are independent, so compress them on separate threads.
+	double start = _time_now();
+	for (int i = 0; i < LZ_PARTS; i++)
 	{
-		uint32_t in_size_tmp;
-		if (!i)
-		{
-			in_size_tmp = in_size / 2;
-			strcpy(filename + filename_len, ".00.lz");
-		}
-		else
-		{
-			in_size_tmp = in_size - (in_size / 2);
-			strcpy(filename + filename_len, ".01.lz");
-		}
-
-		if (work)
-			nbytes = LZ_CompressFast(in_buf + (in_size / 2) * i, out_buf, in_size_tmp, work);
-		else
+		parts[i].in = in_buf + (in_size / 2) * i;
+		parts[i].in_size = !i ? in_size / 2 : in_size - (in_size / 2);
+		if (pthread_create(&threads[i], NULL, _compress_part, &parts[i]))
 			goto error;
+	}
+	for (int i = 0; i < LZ_PARTS; i++)
+		pthread_join(threads[i], NULL);
+	double wall = _time_now() - start;
 
-		if (nbytes > out_size)
+	for (int i = 0; i < LZ_PARTS; i++)
+	{
+		if (parts[i].nbytes < 0 || parts[i].nbytes > parts[i].out_size)
 			goto error;
 
-		if((out_file = fopen(filename,"wb")) == NULL)
+		sprintf(filename + filename_len, ".%02d.lz", i);
+		if ((out_file = fopen(filename, "wb")) == NULL)
 			goto error;
 
-		if (fwrite(out_buf, 1, nbytes, out_file) != nbytes)
+		if (fwrite(parts[i].out, 1, parts[i].nbytes, out_file) != parts[i].nbytes)
 			goto error;
 
 		fclose(out_file);
+
+		if (inplace && _inplace_check(&parts[i]))
+		{
+			fprintf(stderr, "Part %d does not decode in place!\n", i);
+			goto error;
+		}
+	}
+
+	if (inplace)
+	{
+		sprintf(filename + filename_len, ".lz.ld");
+		if (_write_layout(parts, path))
+			goto error;
+		printf("In-place layout: part 0 gap %u bytes, part 1 gap %u bytes\n", parts[0].gap, parts[1].gap);
+	}
+
+	if (lz4)
+	{
+		int total = 0;
+		for (int i = 0; i < LZ_PARTS; i++)
+			total += parts[i].nbytes;
+		printf("LZ4 optimal parse: %d bytes\n", total);
+	}
+	else if (optimal)
+	{
+		int total = 0, greedy = 0;
+		for (int i = 0; i < LZ_PARTS; i++)
+		{
+			total += parts[i].nbytes;
+			greedy += parts[i].greedy_nbytes;
+		}
+		printf("LZ optimal parse: %d bytes, greedy: %d bytes (%+d)\n", total, greedy, total - greedy);
 	}
 
+	if (bench && _benchmark(parts, wall))
+		goto error;
+
 	return 0;
 
 error:
-	fprintf(stderr, "Failed to compress: %s\n", argv[1]);
+	fprintf(stderr, "Failed to compress: %s\n", path);
 	exit(1);
 }
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Loader payload packing benchmark.
+ * Packs the two halves of an uncompressed payload (output/<target>_unc.bin) back to
+ * front like lz77 -i does, in every format the loader can decode, and times the loader
+ * decoders from bdk/libs/compr/lzrev.c on them. Every decode is checked against the input.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lz.h"
+#include "lz4opt.h"
+#include "../../bdk/libs/compr/lz4.h"
+#include "../../bdk/libs/compr/lzrev.h"
+
+#define LZB_PARTS 2
+
+enum
+{
+	LZB_LZ_GREEDY = 0,
+	LZB_LZ_OPTIMAL,
+	LZB_LZ4_FAST,
+	LZB_LZ4_OPTIMAL,
+	LZB_FORMATS
+};
+
+static const char *lzb_names[LZB_FORMATS] = {
+	"lz greedy", "lz optimal (-o)", "lz4 fast", "lz4 optimal (-4)"
+};
+
+static double _time_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _reverse(uint8_t *buf, uint32_t size)
+{
+	for (uint32_t i = 0; i < size / 2; i++)
+	{
+		uint8_t tmp = buf[i];
+		buf[i] = buf[size - 1 - i];
+		buf[size - 1 - i] = tmp;
+	}
+}
+
+// Reverses in while packing it, and restores it after.
+static int _compress(int format, uint8_t *in, uint32_t size, uint8_t *out, uint32_t *work)
+{
+	int res;
+
+	_reverse(in, size);
+	switch (format)
+	{
+	case LZB_LZ_GREEDY:
+		res = LZ_CompressChain(in, out, size, work, 0);
+		break;
+	case LZB_LZ_OPTIMAL:
+		res = LZ_CompressOptimal(in, out, size, work, 0);
+		break;
+	case LZB_LZ4_FAST:
+		res = LZ4_compress_default((const char *)in, (char *)out, size, LZ4_OPT_BOUND(size));
+		break;
+	default:
+		res = LZ4_CompressOptimal(in, out, size, work);
+		break;
+	}
+	_reverse(in, size);
+
+	if (res > 0)
+		_reverse(out, res);
+
+	return res;
+}
+
+static uint32_t _uncompress(int format, const uint8_t *in, uint32_t size, uint8_t *out_end)
+{
+	if (format == LZB_LZ_GREEDY || format == LZB_LZ_OPTIMAL)
+		return lz_uncompress_rev(in, size, out_end);
+
+	return lz4_uncompress_rev(in, size, out_end);
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: lzbench [-n <runs>] <payload>\n"
+		"  -n <runs>  Decode runs to average (default: 200)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t runs = 200;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': runs = strtoul(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	if (optind != argc - 1 || !runs)
+		_usage();
+
+	FILE *in_file = fopen(argv[optind], "rb");
+	if (!in_file)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	fseek(in_file, 0, SEEK_END);
+	uint32_t in_size = ftell(in_file);
+	fseek(in_file, 0, SEEK_SET);
+
+	uint8_t *in_buf = malloc(in_size + 1);
+	uint8_t *unc_buf = malloc(in_size + 1);
+	uint32_t *work = malloc(sizeof(uint32_t) * LZ4_OPT_WORK_SIZE(in_size));
+	uint8_t *packed[LZB_PARTS];
+	for (int i = 0; i < LZB_PARTS; i++)
+		packed[i] = malloc(LZ4_OPT_BOUND(in_size) + in_size / 256 + 257);
+
+	if (!in_buf || !unc_buf || !work || fread(in_buf, 1, in_size, in_file) != in_size)
+	{
+		fprintf(stderr, "Failed to read: %s\n", argv[optind]);
+		return 1;
+	}
+	fclose(in_file);
+
+	uint8_t *part_in[LZB_PARTS] = { in_buf, in_buf + in_size / 2 };
+	uint32_t part_size[LZB_PARTS] = { in_size / 2, in_size - in_size / 2 };
+	int base_size = 0;
+	int res = 0;
+
+	// Sizes are compared to the default payload packing.
+	for (int i = 0; i < LZB_PARTS; i++)
+		base_size += _compress(LZB_LZ_OPTIMAL, part_in[i], part_size[i], packed[i], work);
+
+	printf("%u bytes, %u decode runs. Decode times are host times of the bdk decoders.\n", in_size, runs);
+	printf("%-18s %8s %8s %8s %8s %7s %11s %9s\n",
+		"format", "part 0", "part 1", "total", "vs -o", "ratio", "decode us", "MB/s");
+
+	for (int f = 0; f < LZB_FORMATS; f++)
+	{
+		int packed_size[LZB_PARTS];
+		int total = 0;
+
+		for (int i = 0; i < LZB_PARTS; i++)
+		{
+			packed_size[i] = _compress(f, part_in[i], part_size[i], packed[i], work);
+			total += packed_size[i];
+		}
+		double start = _time_now();
+		for (uint32_t r = 0; r < runs; r++)
+		{
+			// Second part first, like the loader.
+			uint32_t pos = in_size;
+			for (int i = LZB_PARTS - 1; i >= 0; i--)
+				pos -= _uncompress(f, packed[i], packed_size[i], unc_buf + pos);
+			if (pos)
+				break;
+		}
+		double secs = (_time_now() - start) / runs;
+
+		if (memcmp(unc_buf, in_buf, in_size))
+		{
+			fprintf(stderr, "%s does not decode to the input!\n", lzb_names[f]);
+			res = 1;
+		}
+
+		char delta[16] = "-";
+		if (f != LZB_LZ_OPTIMAL)
+			snprintf(delta, sizeof(delta), "%+d", total - base_size);
+
+		printf("%-18s %8d %8d %8d %8s %7.3f %11.1f %9.1f\n", lzb_names[f], packed_size[0], packed_size[1],
+			total, delta, (double)total / in_size, secs * 1e6, in_size / secs / 1e6);
+	}
+
+	return res;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SDRAM parameter table packer.
+ * Builds the full parameters of every DRAM id from sdram_config.inl and sdram_config_t210b01.inl
+ * the way sdram.c used to, and writes them as the packed streams of mem/sdram_pack.h.
+ * Every id is decoded again with bdk/mem/sdram_pack.c and compared before anything is written.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/types.h>
+#include <mem/sdram.h>
+#include <mem/sdram_pack.h>
+#include <mem/sdram_param_t210.h>
+#include <mem/sdram_param_t210b01.h>
+
+typedef struct _sdram_vendor_patch_t
+{
+	u32 val;
+	u32 offset:16;
+	u32 dramcf:16;
+} sdram_vendor_patch_t;
+
+#include <mem/sdram_config.inl>
+#include <mem/sdram_config_t210b01.inl>
+
+#define SDRAM_T210_IDS  7    // fuse_read_dramid() maps the rest to 0.
+#define SDRAM_MAX_IDS   32
+#define SDRAM_PACK_BUF  SZ_16K
+
+typedef struct _sdram_table_t
+{
+	const char *name;
+	const u32 *base;
+	u32 words;
+	const sdram_vendor_patch_t *patches;
+	u32 patch_count;
+	bool id_mask; // T210 patches carry a mask of DRAM ids, T210B01 ones a DRAM code.
+} sdram_table_t;
+
+typedef struct _sdram_packed_t
+{
+	u8 base[SDRAM_PACK_BUF];
+	u32 base_size;
+	u8 patches[SDRAM_PACK_BUF];
+	u32 patches_size;
+	u16 index[SDRAM_MAX_IDS];
+	u32 ids;
+} sdram_packed_t;
+
+static bool verbose;
+
+static u32 _pack_class(u32 val)
+{
+	return val <= 0xFF ? SDRAM_PACK_BYTE : SDRAM_PACK_WORD;
+}
+
+// Packs the edits that turn prior into target, greedily. Returns the size with the end byte.
+static u32 _pack(u8 *out, const u32 *prior, const u32 *target, u32 words)
+{
+	u32 size = 0;
+	u32 pos = 0;
+
+	// Trailing words that stay as they are need no op.
+	while (words && target[words - 1] == prior[words - 1])
+		words--;
+
+	while (pos < words)
+	{
+		u32 n = 0;
+		u32 type;
+
+		if (target[pos] == prior[pos])
+		{
+			type = SDRAM_PACK_SKIP;
+			while (pos + n < words && n < SDRAM_PACK_MAX_RUN && target[pos + n] == prior[pos + n])
+				n++;
+		}
+		else if (pos && target[pos] == target[pos - 1])
+		{
+			type = SDRAM_PACK_REPEAT;
+			while (pos + n < words && n < SDRAM_PACK_MAX_RUN && target[pos + n] == target[pos - 1])
+				n++;
+		}
+		else
+		{
+			// Literal run, up to an unchanged word, a repeat or a change of size.
+			type = _pack_class(target[pos]);
+			n = 1;
+			while (pos + n < words && n < SDRAM_PACK_MAX_RUN && target[pos + n] != prior[pos + n] &&
+				   target[pos + n] != target[pos + n - 1] && _pack_class(target[pos + n]) == type)
+				n++;
+		}
+
+		out[size++] = type | n;
+		for (u32 i = 0; i < n && type != SDRAM_PACK_SKIP && type != SDRAM_PACK_REPEAT; i++)
+		{
+			u32 val = target[pos + i];
+			out[size++] = val;
+			if (type == SDRAM_PACK_WORD)
+			{
+				out[size++] = val >> 8;
+				out[size++] = val >> 16;
+				out[size++] = val >> 24;
+			}
+		}
+		pos += n;
+	}
+	out[size++] = 0;
+
+	return size;
+}
+
+// Parameters of an id, as the patch loops in sdram.c applied them.
+static void _sdram_params(const sdram_table_t *table, u32 id, u32 *params)
+{
+	memcpy(params, table->base, table->words * 4);
+
+	for (u32 i = 0; i < table->patch_count; i++)
+	{
+		const sdram_vendor_patch_t *patch = &table->patches[i];
+		if (table->id_mask ? (patch->dramcf & BIT(id)) : (patch->dramcf == id))
+			params[patch->offset] = patch->val;
+	}
+}
+
+static int _sdram_pack_table(const sdram_table_t *table, sdram_packed_t *packed)
+{
+	static u32 params[SDRAM_MAX_IDS][SZ_4K / 4];
+	static u32 zero[SZ_4K / 4];
+	static u8 tmp[SDRAM_PACK_BUF];
+	bool has_patch[SDRAM_MAX_IDS] = { 0 };
+
+	if (table->words > ARRAY_SIZE(zero))
+		return 1;
+
+	memset(packed, 0, sizeof(sdram_packed_t));
+	packed->base_size = _pack(packed->base, zero, table->base, table->words);
+
+	if (table->id_mask)
+		packed->ids = SDRAM_T210_IDS;
+	else
+	{
+		for (u32 i = 0; i < table->patch_count; i++)
+			packed->ids = MAX(packed->ids, table->patches[i].dramcf + 1u);
+	}
+	if (packed->ids > SDRAM_MAX_IDS)
+		return 1;
+
+	// Offset 0 is the empty patch, for ids that use the base as is.
+	packed->patches[packed->patches_size++] = 0;
+	packed->patches[packed->patches_size++] = 0;
+
+	// Each id is packed against the base or an earlier id, whichever is smaller.
+	// Id 0 can not be a parent, since 0 stands for the base.
+	for (u32 id = 0; id < packed->ids; id++)
+	{
+		_sdram_params(table, id, params[id]);
+		if (!memcmp(params[id], table->base, table->words * 4))
+			continue;
+
+		u32 same = 0;
+		for (u32 prev = 1; prev < id && !same; prev++)
+			if (has_patch[prev] && !memcmp(params[id], params[prev], table->words * 4))
+				same = prev;
+		if (same)
+		{
+			packed->index[id] = packed->index[same];
+			has_patch[id] = true;
+			continue;
+		}
+
+		u32 parent = 0;
+		u32 best = _pack(tmp, table->base, params[id], table->words);
+		for (u32 prev = 1; prev < id; prev++)
+		{
+			if (!has_patch[prev])
+				continue;
+
+			u32 size = _pack(tmp, params[prev], params[id], table->words);
+			if (size < best)
+			{
+				best = size;
+				parent = prev;
+			}
+		}
+
+		if (packed->patches_size + 1 + best > SDRAM_PACK_BUF || packed->patches_size > 0xFFFF)
+			return 1;
+
+		packed->index[id] = packed->patches_size;
+		packed->patches[packed->patches_size++] = parent;
+		packed->patches_size += _pack(packed->patches + packed->patches_size,
+									  parent ? params[parent] : table->base, params[id], table->words);
+		has_patch[id] = true;
+
+		if (verbose)
+			fprintf(stderr, "%s: id %2d: %3d bytes on %s %d\n", table->name, id, best + 1,
+					parent ? "id" : "base", parent);
+	}
+
+	// Decode every id the way sdram.c does and compare.
+	for (u32 id = 0; id < packed->ids; id++)
+	{
+		u32 out[SZ_4K / 4];
+		memset(out, 0xA5, sizeof(out));
+		memset(out, 0, table->words * 4);
+		sdram_unpack(out, packed->base);
+		sdram_unpack_patch(out, packed->patches, packed->index, id);
+
+		if (memcmp(out, params[id], table->words * 4) || out[table->words] != 0xA5A5A5A5)
+		{
+			fprintf(stderr, "sdramgen: %s id %d does not decode back!\n", table->name, id);
+			return 1;
+		}
+	}
+
+	if (verbose)
+	{
+		u32 orig = table->words * 4 + table->patch_count * sizeof(sdram_vendor_patch_t);
+		u32 size = packed->base_size + packed->patches_size + packed->ids * sizeof(u16);
+		fprintf(stderr, "%s: base %d -> %d, patches %d -> %d, total %d -> %d bytes\n", table->name,
+				table->words * 4, packed->base_size, (u32)(table->patch_count * sizeof(sdram_vendor_patch_t)),
+				packed->patches_size + packed->ids * (u32)sizeof(u16), orig, size);
+	}
+
+	return 0;
+}
+
+static void _print_bytes(const char *type, const char *name, const u8 *data, u32 size)
+{
+	printf("static const %s %s[] = {", type, name);
+	for (u32 i = 0; i < size; i++)
+		printf("%s0x%02X,", (i % 16) ? " " : "\n\t", data[i]);
+	printf("\n};\n\n");
+}
+
+static void _print_table(const sdram_table_t *table, const sdram_packed_t *packed)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "_dram_cfg_%s_packed", table->name);
+	_print_bytes("u8", name, packed->base, packed->base_size);
+	snprintf(name, sizeof(name), "_dram_cfg_%s_patches", table->name);
+	_print_bytes("u8", name, packed->patches, packed->patches_size);
+
+	printf("static const u16 _dram_cfg_%s_patch_idx[%d] = {\n\t", table->name, packed->ids);
+	for (u32 id = 0; id < packed->ids; id++)
+		printf("%d,%s", packed->index[id], (id + 1 < packed->ids) ? " " : "");
+	printf("\n};\n\n");
+}
+
+int main(int argc, char **argv)
+{
+	static sdram_packed_t packed[2];
+
+	const sdram_table_t tables[2] = {
+		{ "t210",    (const u32 *)&_dram_cfg_0_samsung_4gb, sizeof(sdram_params_t210_t) / 4,
+		  sdram_cfg_vendor_patches_t210, ARRAY_SIZE(sdram_cfg_vendor_patches_t210), true },
+		{ "t210b01", (const u32 *)&_dram_cfg_08_10_12_14_samsung_hynix_4gb, sizeof(sdram_params_t210b01_t) / 4,
+		  sdram_cfg_vendor_patches_t210b01, ARRAY_SIZE(sdram_cfg_vendor_patches_t210b01), false },
+	};
+
+	if (argc > 1 && !strcmp(argv[1], "-v"))
+		verbose = true;
+	else if (argc > 1)
+	{
+		fprintf(stderr, "Usage: sdramgen [-v] > sdram_config_packed.inl\n");
+		return 1;
+	}
+
+	for (u32 i = 0; i < ARRAY_SIZE(tables); i++)
+		if (_sdram_pack_table(&tables[i], &packed[i]))
+			return 1;
+
+	printf("// Generated by tools/sdram/sdramgen from sdram_config.inl and sdram_config_t210b01.inl.\n\n");
+	for (u32 i = 0; i < ARRAY_SIZE(tables); i++)
+		_print_table(&tables[i], &packed[i]);
+
+	return 0;
+}
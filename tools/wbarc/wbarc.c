@@ -0,0 +1,615 @@
+/*
+ * Copyright (c) 2026 Warmboot Extractor contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Warmboot archive packer.
+ * Stores wb_xx.bin files of many firmware versions in one archive. Each file is an LZ4 block
+ * compressed against a dictionary trained on all of them, so any file decodes on its own.
+ * Archives are read back with source/warmboot/wb_archive.c and compared before they are written.
+ *
+ * The dictionary is built from the segments whose 8 byte strings occur in the most files,
+ * like the zstd cover trainer. The best segments go last, closest to the data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <libgen.h>
+
+#include <libs/compr/lz4.h>
+#include <warmboot/wb_archive.h>
+#include <warmboot/warmboot_extractor.h>
+
+#define WBA_MAX_FILES   256
+#define WBA_GRAM        8
+#define WBA_HASH_BITS   20
+#define WBA_RUNS_DEF    5
+
+typedef struct _wba_file_t
+{
+	u8 fuses;
+	u8 *data;
+	u32 size;
+} wba_file_t;
+
+static const u32 wba_dict_sizes[] = { SZ_1K, SZ_2K, SZ_4K, SZ_8K, SZ_16K, SZ_32K, SZ_64K };
+static const u32 wba_seg_sizes[] = { 32, 64, 128, 256, 512 };
+
+static u32 crc_table[256];
+
+// Same as crc32_calc() of the payload, for wb_archive.c.
+u32 crc32_calc(u32 crc, const u8 *buf, u32 len)
+{
+	if (!crc_table[1])
+	{
+		for (u32 i = 0; i < 256; i++)
+		{
+			u32 rem = i;
+			for (u32 j = 0; j < 8; j++)
+				rem = (rem & 1) ? (rem >> 1) ^ 0xEDB88320 : rem >> 1;
+			crc_table[i] = rem;
+		}
+	}
+
+	crc = ~crc;
+	for (u32 i = 0; i < len; i++)
+		crc = (crc >> 8) ^ crc_table[(crc & 0xFF) ^ buf[i]];
+
+	return ~crc;
+}
+
+static double _time_now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static u8 *_read_file(const char *path, u32 *size)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	u8 *data = malloc(*size ? *size : 1);
+	if (data && fread(data, 1, *size, file) != *size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+
+	return data;
+}
+
+static int _write_file(const char *path, const u8 *data, u32 size)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+		return 1;
+
+	int res = fwrite(data, 1, size, file) != size;
+
+	return fclose(file) || res;
+}
+
+static u32 _gram_hash(const u8 *p)
+{
+	u64 v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return (v * 0x9E3779B97F4A7C15ull) >> (64 - WBA_HASH_BITS);
+}
+
+/*
+ * Trains a dictionary of up to dict_size bytes. Returns its size.
+ * A string counts once per file it occurs in, and no more once a chosen segment holds it.
+ */
+static u32 _train_dict(const wba_file_t *files, u32 count, u8 *dict, u32 dict_size, u32 seg_size)
+{
+	u32 *freq = calloc(1 << WBA_HASH_BITS, sizeof(u32));
+	u32 *seen = calloc(1 << WBA_HASH_BITS, sizeof(u32));
+
+	for (u32 f = 0; f < count; f++)
+	{
+		for (u32 i = 0; i + WBA_GRAM <= files[f].size; i++)
+		{
+			u32 h = _gram_hash(files[f].data + i);
+			if (seen[h] != f + 1)
+			{
+				seen[h] = f + 1;
+				freq[h]++;
+			}
+		}
+	}
+
+	// Segments are picked best first and stored from the end down.
+	u32 pos = dict_size;
+	while (pos)
+	{
+		u32 len = MIN(seg_size, pos);
+		u32 best = 0, best_f = 0, best_i = 0;
+
+		for (u32 f = 0; f < count; f++)
+		{
+			if (files[f].size < len || len < WBA_GRAM)
+				continue;
+
+			// Sliding sum over the strings that start in the segment.
+			u32 grams = len - WBA_GRAM + 1;
+			u32 score = 0;
+			for (u32 i = 0; i < grams; i++)
+				score += freq[_gram_hash(files[f].data + i)];
+
+			for (u32 i = 0; ; i++)
+			{
+				if (score > best)
+				{
+					best = score;
+					best_f = f;
+					best_i = i;
+				}
+				if (i + len >= files[f].size)
+					break;
+
+				score -= freq[_gram_hash(files[f].data + i)];
+				score += freq[_gram_hash(files[f].data + i + grams)];
+			}
+		}
+
+		// Strings in a single file only do not help the others.
+		if (best <= len - WBA_GRAM + 1)
+			break;
+
+		pos -= len;
+		memcpy(dict + pos, files[best_f].data + best_i, len);
+		for (u32 i = 0; i + WBA_GRAM <= len; i++)
+			freq[_gram_hash(files[best_f].data + best_i + i)] = 0;
+	}
+
+	free(freq);
+	free(seen);
+
+	// Move it to the start, if it is not full.
+	memmove(dict, dict + pos, dict_size - pos);
+
+	return dict_size - pos;
+}
+
+static int _file_cmp(const void *a, const void *b)
+{
+	return ((const wba_file_t *)a)->fuses - ((const wba_file_t *)b)->fuses;
+}
+
+// Builds the archive. Returns its size, or 0 on failure.
+static u32 _pack(const wba_file_t *files, u32 count, const u8 *dict, u32 dict_size, u8 *out, u32 out_size)
+{
+	LZ4_stream_t stream;
+	wb_archive_header_t *hdr = (wb_archive_header_t *)out;
+	wb_archive_entry_t *index = (wb_archive_entry_t *)(out + sizeof(wb_archive_header_t));
+	u32 pos = sizeof(wb_archive_header_t) + count * sizeof(wb_archive_entry_t) + dict_size;
+
+	if (pos > out_size)
+		return 0;
+
+	memset(out, 0, pos);
+	hdr->magic = WB_ARCHIVE_MAGIC;
+	hdr->version = WB_ARCHIVE_VERSION;
+	hdr->count = count;
+	hdr->dict_size = dict_size;
+	if (dict_size)
+		memcpy(out + pos - dict_size, dict, dict_size);
+
+	for (u32 i = 0; i < count; i++)
+	{
+		// Keep entries u32 aligned.
+		pos = ALIGN(pos, 4);
+
+		LZ4_resetStream(&stream);
+		if (dict_size)
+			LZ4_loadDict(&stream, (const char *)dict, dict_size);
+		int comp_size = LZ4_compress_fast_continue(&stream, (const char *)files[i].data, (char *)out + pos,
+												   files[i].size, out_size - pos, 1);
+		if (comp_size <= 0)
+			return 0;
+
+		index[i].fuses = files[i].fuses;
+		index[i].offset = pos;
+		index[i].comp_size = comp_size;
+		index[i].size = files[i].size;
+		index[i].crc32 = crc32_calc(0, files[i].data, files[i].size);
+		pos += comp_size;
+	}
+
+	return pos;
+}
+
+static u32 _out_bound(const wba_file_t *files, u32 count)
+{
+	u32 size = sizeof(wb_archive_header_t) + count * sizeof(wb_archive_entry_t) + WB_ARCHIVE_DICT_MAX;
+
+	for (u32 i = 0; i < count; i++)
+		size += LZ4_compressBound(files[i].size) + 4;
+
+	return size;
+}
+
+// Packs with the dictionary and segment sizes given, or the best of all when 0.
+static u32 _pack_best(const wba_file_t *files, u32 count, u32 dict_size, u32 seg_size, u8 *out, u32 out_size,
+	u32 *best_dict, u32 *best_seg, bool verbose)
+{
+	u8 *dict = malloc(WB_ARCHIVE_DICT_MAX);
+	u8 *tmp = malloc(out_size);
+	u32 total = 0;
+	u32 best = 0;
+
+	for (u32 i = 0; i < count; i++)
+		total += files[i].size;
+
+	for (u32 d = 0; d < ARRAY_SIZE(wba_dict_sizes); d++)
+	{
+		if (dict_size ? wba_dict_sizes[d] != dict_size : wba_dict_sizes[d] > total)
+			continue;
+
+		for (u32 s = 0; s < ARRAY_SIZE(wba_seg_sizes); s++)
+		{
+			if (seg_size ? wba_seg_sizes[s] != seg_size : wba_seg_sizes[s] > wba_dict_sizes[d])
+				continue;
+
+			u32 dsize = _train_dict(files, count, dict, wba_dict_sizes[d], wba_seg_sizes[s]);
+			u32 size = _pack(files, count, dict, dsize, tmp, out_size);
+			if (verbose)
+				printf("  dict %5u seg %3u: dict %5u, archive %7u\n", wba_dict_sizes[d], wba_seg_sizes[s], dsize, size);
+
+			if (size && (!best || size < best))
+			{
+				best = size;
+				*best_dict = wba_dict_sizes[d];
+				*best_seg = wba_seg_sizes[s];
+				memcpy(out, tmp, size);
+			}
+		}
+	}
+
+	free(dict);
+	free(tmp);
+
+	return best;
+}
+
+// Reads every entry back with the payload reader. Returns the ns per entry of the best run.
+static double _verify(const u8 *arc_data, u32 arc_size, const wba_file_t *files, u32 count, u32 runs, double *total_ns)
+{
+	wb_archive_t arc;
+	u8 buf[SZ_64K];
+	double best = 0;
+
+	if (!wb_archive_open(&arc, arc_data, arc_size) || arc.count != count)
+		return -1;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		int idx = wb_archive_find(&arc, files[i].fuses);
+		if (idx < 0 || wb_archive_read(&arc, idx, buf, sizeof(buf)) != files[i].size ||
+			memcmp(buf, files[i].data, files[i].size))
+			return -1;
+	}
+
+	// Each run decodes every entry a few times. Entries are found by fuse count like on device.
+	const u32 reps = 64;
+	for (u32 r = 0; r < runs; r++)
+	{
+		double start = _time_now();
+		for (u32 k = 0; k < reps; k++)
+			for (u32 i = 0; i < count; i++)
+				wb_archive_read(&arc, wb_archive_find(&arc, files[i].fuses), buf, sizeof(buf));
+		double ns = (_time_now() - start) * 1e9 / (reps * count);
+		if (!r || ns < best)
+			best = ns;
+	}
+
+	if (total_ns)
+	{
+		// Opening is part of the cost of reading one entry cold.
+		double start = _time_now();
+		for (u32 k = 0; k < reps; k++)
+		{
+			wb_archive_open(&arc, arc_data, arc_size);
+			wb_archive_read(&arc, wb_archive_find(&arc, files[k % count].fuses), buf, sizeof(buf));
+		}
+		*total_ns = (_time_now() - start) * 1e9 / reps;
+	}
+
+	return best;
+}
+
+static int _load_files(char **paths, u32 count, wba_file_t *files)
+{
+	for (u32 i = 0; i < count; i++)
+	{
+		char name[256];
+		unsigned int fuses;
+
+		// Fuse count comes from the wb_xx.bin name.
+		snprintf(name, sizeof(name), "%s", paths[i]);
+		if (sscanf(basename(name), "wb_%x.bin", &fuses) != 1 || fuses > 0xFF)
+		{
+			fprintf(stderr, "%s: not named wb_xx.bin!\n", paths[i]);
+			return 1;
+		}
+
+		files[i].fuses = fuses;
+		files[i].data = _read_file(paths[i], &files[i].size);
+		if (!files[i].data || !files[i].size || files[i].size > SZ_64K)
+		{
+			fprintf(stderr, "%s: can not be read or is not 1 B to 64 KiB!\n", paths[i]);
+			return 1;
+		}
+
+		for (u32 j = 0; j < i; j++)
+		{
+			if (files[j].fuses == files[i].fuses)
+			{
+				fprintf(stderr, "%s: fuse count %02x is there twice!\n", paths[i], fuses);
+				return 1;
+			}
+		}
+	}
+
+	qsort(files, count, sizeof(wba_file_t), _file_cmp);
+
+	return 0;
+}
+
+static u32 _rand_state;
+
+static u32 _rand()
+{
+	_rand_state ^= _rand_state << 13;
+	_rand_state ^= _rand_state >> 17;
+	_rand_state ^= _rand_state << 5;
+
+	return _rand_state;
+}
+
+/*
+ * Synthetic warmboot history: a size field, a per build header and Thumb/ARM like words from
+ * a skewed vocabulary. Each version changes a few words and inserts or drops a few short runs.
+ */
+static u32 _gen_files(wba_file_t *files, u32 count, u32 seed)
+{
+	u32 vocab[512];
+	u32 words = 0xE00 / 4;
+	u32 prev[WARMBOOT_MAX_SIZE / 4];
+
+	_rand_state = seed ? seed : 1;
+	for (u32 i = 0; i < ARRAY_SIZE(vocab); i++)
+		vocab[i] = 0xE0000000 | (_rand() & 0x0FFFFFFF);
+	for (u32 i = 0; i < words; i++)
+		prev[i] = vocab[(_rand() % 512) * (_rand() % 512) / 512];
+
+	for (u32 v = 0; v < count; v++)
+	{
+		u32 cur[WARMBOOT_MAX_SIZE / 4];
+		u32 n = 0;
+
+		for (u32 i = 0; i < words && n < ARRAY_SIZE(cur); i++)
+		{
+			u32 r = _rand() % 1000;
+			if (r < 3)
+				continue;
+			if (r < 6)
+			{
+				for (u32 k = _rand() % 8 + 1; k && n < ARRAY_SIZE(cur) - 1; k--)
+					cur[n++] = vocab[(_rand() % 512) * (_rand() % 512) / 512];
+			}
+			cur[n++] = (r < 20) ? vocab[_rand() % 512] : prev[i];
+		}
+		n = MAX(n, WARMBOOT_MIN_SIZE / 4);
+
+		// Build header.
+		for (u32 i = 1; i < 5; i++)
+			cur[i] = _rand();
+		cur[0] = n * 4;
+
+		files[v].fuses = v + 1;
+		files[v].size = n * 4;
+		files[v].data = malloc(files[v].size);
+		memcpy(files[v].data, cur, files[v].size);
+		memcpy(prev, cur, files[v].size);
+		words = n;
+	}
+
+	return count;
+}
+
+static int _cmd_bench(wba_file_t *files, u32 count, u32 runs)
+{
+	u32 total = 0, plain = 0;
+	u32 out_size = _out_bound(files, count);
+	u8 *out = malloc(out_size);
+	u8 *tmp = malloc(SZ_64K * 2);
+
+	for (u32 i = 0; i < count; i++)
+	{
+		total += files[i].size;
+		plain += LZ4_compress_default((const char *)files[i].data, (char *)tmp, files[i].size, SZ_64K * 2);
+	}
+
+	printf("%u files, %u bytes\n", count, total);
+	printf("LZ4 each file on its own:   %7u bytes (%.1f%%)\n", plain, 100.0 * plain / total);
+
+	u32 size = _pack(files, count, NULL, 0, out, out_size);
+	double ns = _verify(out, size, files, count, runs, NULL);
+	printf("Archive, no dictionary:     %7u bytes (%.1f%%), %.0f ns per entry\n", size, 100.0 * size / total, ns);
+
+	u32 dict_size, seg_size;
+	size = _pack_best(files, count, 0, 0, out, out_size, &dict_size, &seg_size, true);
+	double open_ns;
+	ns = _verify(out, size, files, count, runs, &open_ns);
+	if (ns < 0)
+	{
+		fprintf(stderr, "Archive does not read back!\n");
+		return 1;
+	}
+
+	wb_archive_t arc;
+	wb_archive_open(&arc, out, size);
+	printf("Archive, dict %5u seg %3u: %7u bytes (%.1f%%), dictionary %u bytes\n",
+		dict_size, seg_size, size, 100.0 * size / total, arc.dict_size);
+	printf("Decode: %.0f ns per entry (%.1f MB/s), %.0f ns with open and lookup\n",
+		ns, total / (ns * count / 1e3), open_ns);
+
+	free(out);
+	free(tmp);
+
+	return 0;
+}
+
+static void _usage()
+{
+	fprintf(stderr,
+		"Usage: wbarc [-D <size>] [-k <size>] -c <archive> <wb_xx.bin>...\n"
+		"       wbarc -l <archive>\n"
+		"       wbarc -x <fuses> <archive> <out>\n"
+		"       wbarc -b [-n <runs>] [-g <count>] [<wb_xx.bin>...]\n"
+		"Stores wb_xx.bin files in one archive, compressed with a trained LZ4 dictionary.\n"
+		"  -c <archive>  Create <archive> from the files\n"
+		"  -D <size>     Dictionary size, 1024 to 65536 (default: smallest archive)\n"
+		"  -k <size>     Dictionary segment size, 32 to 512 (default: smallest archive)\n"
+		"  -l            List the entries of <archive>\n"
+		"  -x <fuses>    Extract the entry of fuse count <fuses> (hex, as in wb_xx.bin)\n"
+		"  -b            Benchmark archive size and decoding\n"
+		"  -n <runs>     Benchmark runs, the best one counts (default: %u)\n"
+		"  -g <count>    Benchmark on a synthetic history of <count> versions\n", WBA_RUNS_DEF);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	static wba_file_t files[WBA_MAX_FILES];
+	const char *create = NULL;
+	bool list = false, bench = false;
+	int extract = -1;
+	u32 dict_size = 0, seg_size = 0, runs = WBA_RUNS_DEF, gen = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:D:k:lx:bn:g:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'c': create = optarg; break;
+		case 'D': dict_size = strtoul(optarg, NULL, 0); break;
+		case 'k': seg_size = strtoul(optarg, NULL, 0); break;
+		case 'l': list = true; break;
+		case 'x': extract = strtoul(optarg, NULL, 16) & 0xFF; break;
+		case 'b': bench = true; break;
+		case 'n': runs = strtoul(optarg, NULL, 0); break;
+		case 'g': gen = strtoul(optarg, NULL, 0); break;
+		default: _usage();
+		}
+	}
+
+	u32 count = argc - optind;
+	if (bench)
+	{
+		if (gen)
+			count = _gen_files(files, MIN(gen, WBA_MAX_FILES), 1);
+		else if (!count || count > WBA_MAX_FILES || _load_files(argv + optind, count, files))
+			_usage();
+
+		return _cmd_bench(files, count, runs ? runs : 1);
+	}
+
+	if (create)
+	{
+		if (!count || count > WBA_MAX_FILES || count > 0xFFFF)
+			_usage();
+		if (_load_files(argv + optind, count, files))
+			return 1;
+
+		u32 out_size = _out_bound(files, count);
+		u8 *out = malloc(out_size);
+		u32 best_dict, best_seg;
+		u32 size = _pack_best(files, count, dict_size, seg_size, out, out_size, &best_dict, &best_seg, false);
+		int res = 1;
+		if (!size || _verify(out, size, files, count, 1, NULL) < 0)
+			fprintf(stderr, "Packing failed, check -D and -k!\n");
+		else if (_write_file(create, out, size))
+			fprintf(stderr, "%s: can not be written!\n", create);
+		else
+		{
+			printf("%s: %u entries, %u bytes, dictionary %u with %u byte segments\n",
+				create, count, size, best_dict, best_seg);
+			res = 0;
+		}
+		free(out);
+
+		return res;
+	}
+
+	if ((list && count == 1) || (extract >= 0 && count == 2))
+	{
+		wb_archive_t arc;
+		u32 size;
+		u8 *data = _read_file(argv[optind], &size);
+		if (!data || !wb_archive_open(&arc, data, size))
+		{
+			fprintf(stderr, "%s: not a warmboot archive!\n", argv[optind]);
+			free(data);
+			return 1;
+		}
+
+		int res = 0;
+		if (list)
+		{
+			printf("%u entries, dictionary %u bytes\n", arc.count, arc.dict_size);
+			for (u32 i = 0; i < arc.count; i++)
+				printf("  wb_%02x.bin %5u -> %5u bytes, crc32 %08X\n", arc.index[i].fuses,
+					arc.index[i].size, arc.index[i].comp_size, arc.index[i].crc32);
+		}
+		else
+		{
+			u8 buf[SZ_64K];
+			int idx = wb_archive_find(&arc, extract);
+			u32 out_size = idx < 0 ? 0 : wb_archive_read(&arc, idx, buf, sizeof(buf));
+			if (!out_size)
+			{
+				fprintf(stderr, "wb_%02x.bin: %s!\n", extract, idx < 0 ? "not in archive" : "corrupt");
+				res = 1;
+			}
+			else
+				res = _write_file(argv[optind + 1], buf, out_size);
+		}
+		free(data);
+
+		return res;
+	}
+
+	_usage();
+
+	return 1;
+}